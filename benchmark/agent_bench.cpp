@@ -0,0 +1,406 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+
+/* Measure the overhead added by the ROCdebug-agent to the startup of an
+   application, and to the hsa_executable_freeze and hsa_executable_destroy
+   functions it intercepts, without a GPU.  The agent library is built
+   against the fake-amd-dbgapi library, loaded with dlopen and given an HSA
+   API table whose functions do nothing.
+
+   Each startup run is done in a new process, once attaching dbgapi in
+   OnLoad, and once with --defer-attach.  The hooks are then called by many
+   threads from the same process, the worker thread spinning for --report-us
+   microseconds per code object list update reported to dbgapi.  */
+
+#include "agent_library.h"
+#include "fake_dbgapi.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using agent_library::clock_type;
+
+namespace
+{
+
+struct options_t
+{
+  std::string m_library{ AGENT_LIBRARY };
+  std::string m_agent_options;
+  std::vector<size_t> m_thread_counts{ 1, 2, 4, 8, 16 };
+  size_t m_cycles{ 1000 };
+  size_t m_startup_runs{ 20 };
+  std::chrono::microseconds m_report_cost{ 5 };
+};
+
+/* The timings of one startup run, in microseconds.  */
+struct startup_run_t
+{
+  double m_dlopen;
+  double m_on_load;
+  /* From the start of OnLoad, or of the first freeze if the attach is
+     deferred, to the return of amd_dbgapi_process_attach.  */
+  double m_attach;
+  double m_first_freeze;
+  double m_on_unload;
+};
+
+/* The results of one run of the hooks.  */
+struct result_t
+{
+  std::vector<double> m_freeze_us;
+  std::vector<double> m_destroy_us;
+  size_t m_reports{ 0 };
+  double m_elapsed_s{ 0 };
+};
+
+double
+elapsed_us (clock_type::time_point start, clock_type::time_point end)
+{
+  return std::chrono::duration<double, std::micro> (end - start).count ();
+}
+
+/* Load the agent library with AGENT_OPTIONS, and set the dlopen and
+   OnLoad timings of RUN.  Return the time at which OnLoad was called.  */
+
+clock_type::time_point
+load_agent (const options_t &options, const std::string &agent_options,
+            startup_run_t *run)
+{
+  const auto times = agent_library::load (options.m_library, agent_options);
+  run->m_dlopen = elapsed_us (times.m_dlopen_start, times.m_on_load_start);
+  run->m_on_load = elapsed_us (times.m_on_load_start, times.m_on_load_end);
+  return times.m_on_load_start;
+}
+
+/* Return the time at which the process is attached, exit if it is not
+   attached after a few seconds.  */
+
+clock_type::time_point
+wait_for_attach ()
+{
+  auto attach_time = fake_dbgapi::wait_for_attach (std::chrono::seconds (5));
+  if (!attach_time)
+    {
+      fprintf (stderr, "the agent did not attach the process\n");
+      exit (1);
+    }
+  return *attach_time;
+}
+
+/* Measure the startup in a new process, so that the agent library is loaded
+   and initialized from scratch.  */
+
+startup_run_t
+run_startup (const options_t &options, bool defer_attach)
+{
+  int pipefd[2];
+  if (pipe (pipefd) == -1)
+    {
+      perror ("pipe");
+      exit (1);
+    }
+
+  pid_t pid = fork ();
+  if (pid == -1)
+    {
+      perror ("fork");
+      exit (1);
+    }
+
+  if (pid == 0)
+    {
+      close (pipefd[0]);
+
+      std::string agent_options = options.m_agent_options;
+      if (defer_attach)
+        agent_options += " --defer-attach";
+
+      startup_run_t run;
+      const auto on_load_start = load_agent (options, agent_options, &run);
+      if (!defer_attach)
+        run.m_attach = elapsed_us (on_load_start, wait_for_attach ());
+
+      const auto freeze_start = clock_type::now ();
+      agent_library::executable_freeze (hsa_executable_t{ 1 });
+      const auto freeze_end = clock_type::now ();
+      run.m_first_freeze = elapsed_us (freeze_start, freeze_end);
+      if (defer_attach)
+        run.m_attach = elapsed_us (freeze_start, wait_for_attach ());
+
+      const auto on_unload_start = clock_type::now ();
+      agent_library::unload ();
+      run.m_on_unload = elapsed_us (on_unload_start, clock_type::now ());
+
+      if (write (pipefd[1], &run, sizeof (run)) != sizeof (run))
+        _exit (1);
+      _exit (0);
+    }
+
+  close (pipefd[1]);
+  startup_run_t run;
+  ssize_t size = read (pipefd[0], &run, sizeof (run));
+  close (pipefd[0]);
+
+  int status;
+  if (waitpid (pid, &status, 0) == -1 || !WIFEXITED (status)
+      || WEXITSTATUS (status) != 0 || size != sizeof (run))
+    {
+      fprintf (stderr, "the startup run failed\n");
+      exit (1);
+    }
+  return run;
+}
+
+/* Call the freeze and destroy hooks from THREAD_COUNT threads, each
+   freezing and destroying --cycles executables.  */
+
+result_t
+run_hooks (const options_t &options, size_t thread_count)
+{
+  result_t result;
+  result.m_freeze_us.resize (thread_count * options.m_cycles);
+  result.m_destroy_us.resize (thread_count * options.m_cycles);
+
+  const size_t reports
+      = fake_dbgapi::call_count ("amd_dbgapi_report_breakpoint_hit");
+  const auto start = clock_type::now ();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t)
+    threads.emplace_back ([&, t] () {
+      for (size_t i = 0; i < options.m_cycles; ++i)
+        {
+          hsa_executable_t executable{ t * options.m_cycles + i + 1 };
+
+          const auto freeze_start = clock_type::now ();
+          agent_library::executable_freeze (executable);
+          const auto destroy_start = clock_type::now ();
+          agent_library::executable_destroy (executable);
+          const auto destroy_end = clock_type::now ();
+
+          result.m_freeze_us[t * options.m_cycles + i]
+              = elapsed_us (freeze_start, destroy_start);
+          result.m_destroy_us[t * options.m_cycles + i]
+              = elapsed_us (destroy_start, destroy_end);
+        }
+    });
+
+  for (auto &&thread : threads)
+    thread.join ();
+  result.m_elapsed_s
+      = std::chrono::duration<double> (clock_type::now () - start).count ();
+
+  result.m_reports
+      = fake_dbgapi::call_count ("amd_dbgapi_report_breakpoint_hit")
+        - reports;
+  return result;
+}
+
+/* Print the mean, median, 99th percentile and maximum of SAMPLES, followed
+   by the END of the line.  */
+
+void
+print_distribution (const char *name, const char *column,
+                    std::vector<double> &samples, const std::string &end)
+{
+  std::sort (samples.begin (), samples.end ());
+
+  auto percentile = [&] (double p) {
+    return samples[std::min (samples.size () - 1,
+                             static_cast<size_t> (p * samples.size ()))];
+  };
+
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  printf ("%-12s %-9s %10.1f %10.1f %10.1f %10.1f%s\n", name, column,
+          total / samples.size (), percentile (0.5), percentile (0.99),
+          samples.back (), end.c_str ());
+}
+
+void
+print_startup (const char *mode, std::vector<startup_run_t> &runs)
+{
+  auto print = [&] (const char *name, double startup_run_t::*member) {
+    std::vector<double> samples;
+    for (auto &&run : runs)
+      samples.push_back (run.*member);
+    print_distribution (name, mode, samples, "");
+  };
+
+  print ("dlopen", &startup_run_t::m_dlopen);
+  print ("OnLoad", &startup_run_t::m_on_load);
+  print ("attach", &startup_run_t::m_attach);
+  print ("1st freeze", &startup_run_t::m_first_freeze);
+  print ("OnUnload", &startup_run_t::m_on_unload);
+}
+
+void
+print_result (size_t thread_count, result_t &result)
+{
+  const size_t calls = result.m_freeze_us.size ();
+  const size_t reports = std::max<size_t> (result.m_reports, 1);
+  char end[64];
+
+  snprintf (end, sizeof (end), " %12.0f %9.2f", calls / result.m_elapsed_s,
+            static_cast<double> (calls) / reports);
+  print_distribution ("freeze", std::to_string (thread_count).c_str (),
+                      result.m_freeze_us, end);
+
+  snprintf (end, sizeof (end), " %12.0f %9s", calls / result.m_elapsed_s,
+            "-");
+  print_distribution ("destroy", std::to_string (thread_count).c_str (),
+                      result.m_destroy_us, end);
+}
+
+void
+print_usage (const char *program)
+{
+  fprintf (stderr,
+           "usage: %s [--library=PATH] [--agent-options=OPTIONS] "
+           "[--threads=N[,N...]]\n"
+           "          [--cycles=N] [--startup-runs=N] [--report-us=N]\n"
+           "  --library=PATH          The agent library built against "
+           "fake-amd-dbgapi.\n"
+           "  --agent-options=OPTIONS The ROCM_DEBUG_AGENT_OPTIONS of "
+           "the agent.\n"
+           "  --threads=N[,N...]      The numbers of threads calling "
+           "the hooks\n"
+           "                          (default 1,2,4,8,16).\n"
+           "  --cycles=N              The executables frozen and "
+           "destroyed by each thread\n"
+           "                          (default 1000).\n"
+           "  --startup-runs=N        The processes started per startup "
+           "mode (default 20).\n"
+           "  --report-us=N           The simulated cost of a report in "
+           "microseconds (default 5).\n",
+           program);
+  exit (1);
+}
+
+} /* namespace */
+
+int
+main (int argc, char **argv)
+{
+  options_t options;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg (argv[i]);
+      auto value = [&] (const char *prefix) -> std::optional<std::string> {
+        if (arg.rfind (prefix, 0) != 0)
+          return std::nullopt;
+        return arg.substr (strlen (prefix));
+      };
+
+      if (auto library = value ("--library="))
+        options.m_library = *library;
+      else if (auto agent_options = value ("--agent-options="))
+        options.m_agent_options = *agent_options;
+      else if (auto threads = value ("--threads="))
+        {
+          options.m_thread_counts.clear ();
+          size_t pos = 0;
+          while (pos <= threads->size ())
+            {
+              size_t comma = threads->find (',', pos);
+              if (comma == std::string::npos)
+                comma = threads->size ();
+              size_t count = strtoul (threads->c_str () + pos, nullptr, 10);
+              if (!count)
+                print_usage (argv[0]);
+              options.m_thread_counts.push_back (count);
+              pos = comma + 1;
+            }
+        }
+      else if (auto cycles = value ("--cycles="))
+        {
+          options.m_cycles = strtoul (cycles->c_str (), nullptr, 10);
+          if (!options.m_cycles)
+            print_usage (argv[0]);
+        }
+      else if (auto runs = value ("--startup-runs="))
+        {
+          options.m_startup_runs = strtoul (runs->c_str (), nullptr, 10);
+          if (!options.m_startup_runs)
+            print_usage (argv[0]);
+        }
+      else if (auto report = value ("--report-us="))
+        options.m_report_cost = std::chrono::microseconds (
+            strtoul (report->c_str (), nullptr, 10));
+      else
+        print_usage (argv[0]);
+    }
+
+  fake_dbgapi::set_report_cost (options.m_report_cost);
+
+  /* The startup runs fork, do them before this process starts any
+     thread.  */
+  printf ("%-12s %-9s %10s %10s %10s %10s\n", "startup", "mode", "mean(us)",
+          "p50(us)", "p99(us)", "max(us)");
+
+  for (bool defer_attach : { false, true })
+    {
+      std::vector<startup_run_t> runs;
+      for (size_t i = 0; i < options.m_startup_runs; ++i)
+        runs.push_back (run_startup (options, defer_attach));
+      print_startup (defer_attach ? "deferred" : "attach", runs);
+    }
+
+  startup_run_t run;
+  load_agent (options, options.m_agent_options, &run);
+  wait_for_attach ();
+
+  printf ("\n%-12s %-9s %10s %10s %10s %10s %12s %9s\n", "hook", "threads",
+          "mean(us)", "p50(us)", "p99(us)", "max(us)", "calls/s",
+          "frz/rpt");
+
+  for (size_t thread_count : options.m_thread_counts)
+    {
+      result_t result = run_hooks (options, thread_count);
+      print_result (thread_count, result);
+    }
+
+  agent_library::unload ();
+  return 0;
+}
@@ -0,0 +1,127 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "agent_library.h"
+
+#include <hsa/hsa_api_trace.h>
+
+#include <dlfcn.h>
+#include <libelf.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace agent_library
+{
+
+namespace
+{
+
+using on_load_t = bool (*) (void *, uint64_t, uint64_t, const char *const *);
+using on_unload_t = void (*) ();
+
+hsa_status_t
+fake_hsa_executable_freeze (hsa_executable_t executable, const char *options)
+{
+  return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t
+fake_hsa_executable_destroy (hsa_executable_t executable)
+{
+  return HSA_STATUS_SUCCESS;
+}
+
+CoreApiTable g_core_table{};
+HsaApiTable g_api_table{};
+on_unload_t g_on_unload{ nullptr };
+
+} /* namespace */
+
+load_times_t
+load (const std::string &path, const std::string &agent_options)
+{
+  setenv ("ROCM_DEBUG_AGENT_OPTIONS", agent_options.c_str (), 1);
+
+  /* The agent relies on the runtime to initialize libelf.  */
+  elf_version (EV_CURRENT);
+
+  g_core_table = CoreApiTable{};
+  g_core_table.hsa_executable_freeze_fn = fake_hsa_executable_freeze;
+  g_core_table.hsa_executable_destroy_fn = fake_hsa_executable_destroy;
+  g_api_table = HsaApiTable{};
+  g_api_table.core_ = &g_core_table;
+
+  load_times_t times;
+  times.m_dlopen_start = clock_type::now ();
+  void *library = dlopen (path.c_str (), RTLD_NOW | RTLD_LOCAL);
+  if (!library)
+    {
+      fprintf (stderr, "could not load %s: %s\n", path.c_str (), dlerror ());
+      exit (1);
+    }
+
+  auto on_load = reinterpret_cast<on_load_t> (dlsym (library, "OnLoad"));
+  g_on_unload = reinterpret_cast<on_unload_t> (dlsym (library, "OnUnload"));
+  if (!on_load || !g_on_unload)
+    {
+      fprintf (stderr, "%s is not a tool library\n", path.c_str ());
+      exit (1);
+    }
+
+  times.m_on_load_start = clock_type::now ();
+  if (!on_load (&g_api_table, 1, 0, nullptr))
+    {
+      fprintf (stderr, "OnLoad failed\n");
+      exit (1);
+    }
+  times.m_on_load_end = clock_type::now ();
+  return times;
+}
+
+void
+unload ()
+{
+  g_on_unload ();
+}
+
+hsa_status_t
+executable_freeze (hsa_executable_t executable)
+{
+  return g_core_table.hsa_executable_freeze_fn (executable, nullptr);
+}
+
+hsa_status_t
+executable_destroy (hsa_executable_t executable)
+{
+  return g_core_table.hsa_executable_destroy_fn (executable);
+}
+
+} /* namespace agent_library */
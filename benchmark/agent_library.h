@@ -0,0 +1,69 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_AGENT_LIBRARY_H
+#define _ROCM_DEBUG_AGENT_AGENT_LIBRARY_H 1
+
+#include <hsa/hsa.h>
+
+#include <chrono>
+#include <string>
+
+/* Load the ROCdebug-agent library in the benchmarks, like the ROCm runtime
+   loads its tools, and call the HSA functions it intercepts.  The HSA API
+   table given to the agent has functions that do nothing.  */
+
+namespace agent_library
+{
+
+using clock_type = std::chrono::steady_clock;
+
+struct load_times_t
+{
+  clock_type::time_point m_dlopen_start;
+  clock_type::time_point m_on_load_start;
+  clock_type::time_point m_on_load_end;
+};
+
+/* Load the agent library at PATH with the AGENT_OPTIONS options, and call
+   its OnLoad function.  Exit if the library cannot be loaded.  */
+load_times_t load (const std::string &path, const std::string &agent_options);
+
+/* Call the OnUnload function of the loaded agent library.  */
+void unload ();
+
+/* Call the hsa_executable_freeze and hsa_executable_destroy functions
+   intercepted by the agent.  */
+hsa_status_t executable_freeze (hsa_executable_t executable);
+hsa_status_t executable_destroy (hsa_executable_t executable);
+
+} /* namespace agent_library */
+
+#endif /* _ROCM_DEBUG_AGENT_AGENT_LIBRARY_H */
@@ -0,0 +1,375 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* Measure the round-trip latency of the requests sent by many threads to the
+   worker thread, as done by the hsa_executable_freeze hook to report code
+   object list updates.  The lock-free command queue used by the agent is
+   compared with the previous channel: a pipe written under a global mutex,
+   and a promise/future pair per request.
+
+   The worker thread simulates the cost of amd_dbgapi_report_breakpoint_hit
+   by spinning for --work-us microseconds per report.  */
+
+#include "command_queue.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace amd::debug_agent;
+using clock_type = std::chrono::steady_clock;
+
+namespace
+{
+
+struct options_t
+{
+  std::vector<size_t> m_thread_counts{ 1, 2, 4, 8, 16, 32 };
+  size_t m_requests{ 2000 };
+  std::chrono::microseconds m_work{ 5 };
+};
+
+/* The results of one run.  */
+struct result_t
+{
+  std::vector<double> m_latencies_us;
+  size_t m_reports{ 0 };
+  double m_elapsed_s{ 0 };
+};
+
+void
+spin_for (std::chrono::microseconds duration)
+{
+  const auto end = clock_type::now () + duration;
+  while (clock_type::now () < end)
+    ;
+}
+
+/* The channel used by the agent: a lock-free command queue signaling an
+   eventfd, and a futex completion slot per request.  The worker reports the
+   updates of all the pending requests once.  */
+
+result_t
+run_command_queue (const options_t &options, size_t thread_count)
+{
+  command_queue_t queue;
+  if (!queue.open ())
+    {
+      perror ("eventfd");
+      exit (1);
+    }
+
+  size_t reports = 0;
+  std::thread worker ([&] () {
+    pollfd fd{ queue.fd (), POLLIN, 0 };
+    for (bool running = true; running;)
+      {
+        if (poll (&fd, 1, -1) == -1 && errno != EINTR)
+          {
+            perror ("poll");
+            exit (1);
+          }
+
+        std::vector<completion_t *> completions;
+        bool update = false;
+        for (command_t *command = queue.take_all (); command;)
+          {
+            command_t *next = command->m_next;
+            if (command->m_kind == command_kind_t::stop)
+              running = false;
+            else
+              update = true;
+            if (command->m_completion)
+              completions.push_back (command->m_completion);
+            command = next;
+          }
+
+        if (update)
+          {
+            spin_for (options.m_work);
+            ++reports;
+          }
+
+        for (auto *completion : completions)
+          completion->signal ();
+      }
+  });
+
+  result_t result;
+  result.m_latencies_us.resize (thread_count * options.m_requests);
+
+  const auto start = clock_type::now ();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t)
+    threads.emplace_back ([&, t] () {
+      for (size_t i = 0; i < options.m_requests; ++i)
+        {
+          const auto request_start = clock_type::now ();
+
+          completion_t completion;
+          command_t command{ command_kind_t::update_code_objects,
+                             &completion };
+          queue.push (command);
+          completion.wait ();
+
+          result.m_latencies_us[t * options.m_requests + i]
+              = std::chrono::duration<double, std::micro> (
+                    clock_type::now () - request_start)
+                    .count ();
+        }
+    });
+
+  for (auto &&thread : threads)
+    thread.join ();
+  result.m_elapsed_s
+      = std::chrono::duration<double> (clock_type::now () - start).count ();
+
+  command_t stop{ command_kind_t::stop };
+  queue.push (stop);
+  worker.join ();
+  queue.close ();
+  close (queue.fd ());
+
+  result.m_reports = reports;
+  return result;
+}
+
+/* The previous channel: every request takes a global mutex, writes a byte to
+   a non-blocking pipe and waits on a future until the worker reported the
+   update.  */
+
+result_t
+run_pipe (const options_t &options, size_t thread_count)
+{
+  int pipefd[2];
+  if (pipe2 (pipefd, O_CLOEXEC | O_NONBLOCK) == -1)
+    {
+      perror ("pipe2");
+      exit (1);
+    }
+
+  std::mutex mutex;
+  std::atomic<bool> guard{ false };
+  std::optional<std::promise<void>> promise;
+
+  size_t reports = 0;
+  std::thread worker ([&] () {
+    int epoll_fd = epoll_create1 (0);
+    epoll_event ev{};
+    ev.data.fd = pipefd[0];
+    ev.events = EPOLLIN;
+    epoll_ctl (epoll_fd, EPOLL_CTL_ADD, pipefd[0], &ev);
+
+    for (bool running = true; running;)
+      {
+        epoll_event event;
+        if (epoll_wait (epoll_fd, &event, 1, -1) == -1)
+          continue;
+
+        char buf = '\0';
+        while (read (pipefd[0], &buf, 1) == -1 && errno == EINTR)
+          ;
+
+        if (buf == 'q')
+          running = false;
+        else if (buf == 'b')
+          {
+            guard.load (std::memory_order_acquire);
+            spin_for (options.m_work);
+            ++reports;
+            promise->set_value ();
+          }
+      }
+    close (epoll_fd);
+  });
+
+  result_t result;
+  result.m_latencies_us.resize (thread_count * options.m_requests);
+
+  const auto start = clock_type::now ();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t)
+    threads.emplace_back ([&, t] () {
+      for (size_t i = 0; i < options.m_requests; ++i)
+        {
+          const auto request_start = clock_type::now ();
+          {
+            std::lock_guard<std::mutex> lock (mutex);
+            promise.emplace ();
+            auto future = promise->get_future ();
+            guard.store (true, std::memory_order_release);
+
+            char msg = 'b';
+            if (write (pipefd[1], &msg, 1) != 1)
+              {
+                perror ("write");
+                exit (1);
+              }
+
+            future.wait ();
+            promise.reset ();
+            guard.store (false, std::memory_order_release);
+          }
+
+          result.m_latencies_us[t * options.m_requests + i]
+              = std::chrono::duration<double, std::micro> (
+                    clock_type::now () - request_start)
+                    .count ();
+        }
+    });
+
+  for (auto &&thread : threads)
+    thread.join ();
+  result.m_elapsed_s
+      = std::chrono::duration<double> (clock_type::now () - start).count ();
+
+  char msg = 'q';
+  if (write (pipefd[1], &msg, 1) != 1)
+    perror ("write");
+  worker.join ();
+  close (pipefd[0]);
+  close (pipefd[1]);
+
+  result.m_reports = reports;
+  return result;
+}
+
+void
+print_result (const char *channel, size_t thread_count, result_t &result)
+{
+  auto &latencies = result.m_latencies_us;
+  std::sort (latencies.begin (), latencies.end ());
+
+  auto percentile = [&] (double p) {
+    return latencies[std::min (latencies.size () - 1,
+                               static_cast<size_t> (p * latencies.size ()))];
+  };
+
+  double total = 0;
+  for (double latency : latencies)
+    total += latency;
+
+  printf ("%-14s %7zu %10.1f %10.1f %10.1f %10.1f %12.0f %9.2f\n", channel,
+          thread_count, total / latencies.size (), percentile (0.5),
+          percentile (0.99), latencies.back (),
+          latencies.size () / result.m_elapsed_s,
+          static_cast<double> (latencies.size ()) / result.m_reports);
+}
+
+void
+print_usage (const char *program)
+{
+  fprintf (stderr,
+           "usage: %s [--threads=N[,N...]] [--requests=N] [--work-us=N]\n"
+           "  --threads=N[,N...]  The numbers of requesting threads "
+           "(default 1,2,4,8,16,32).\n"
+           "  --requests=N        The requests sent by each thread "
+           "(default 2000).\n"
+           "  --work-us=N         The simulated cost of a report in "
+           "microseconds (default 5).\n",
+           program);
+  exit (1);
+}
+
+} /* namespace */
+
+int
+main (int argc, char **argv)
+{
+  options_t options;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg (argv[i]);
+      auto value = [&] (const char *prefix) -> std::optional<std::string> {
+        if (arg.rfind (prefix, 0) != 0)
+          return std::nullopt;
+        return arg.substr (strlen (prefix));
+      };
+
+      if (auto threads = value ("--threads="))
+        {
+          options.m_thread_counts.clear ();
+          size_t pos = 0;
+          while (pos <= threads->size ())
+            {
+              size_t comma = threads->find (',', pos);
+              if (comma == std::string::npos)
+                comma = threads->size ();
+              size_t count = strtoul (threads->c_str () + pos, nullptr, 10);
+              if (!count)
+                print_usage (argv[0]);
+              options.m_thread_counts.push_back (count);
+              pos = comma + 1;
+            }
+        }
+      else if (auto requests = value ("--requests="))
+        {
+          options.m_requests = strtoul (requests->c_str (), nullptr, 10);
+          if (!options.m_requests)
+            print_usage (argv[0]);
+        }
+      else if (auto work = value ("--work-us="))
+        options.m_work = std::chrono::microseconds (
+            strtoul (work->c_str (), nullptr, 10));
+      else
+        print_usage (argv[0]);
+    }
+
+  printf ("%-14s %7s %10s %10s %10s %10s %12s %9s\n", "channel", "threads",
+          "mean(us)", "p50(us)", "p99(us)", "max(us)", "requests/s",
+          "req/rpt");
+
+  for (size_t thread_count : options.m_thread_counts)
+    {
+      result_t result = run_pipe (options, thread_count);
+      print_result ("pipe+promise", thread_count, result);
+
+      result = run_command_queue (options, thread_count);
+      print_result ("command-queue", thread_count, result);
+    }
+
+  return 0;
+}
@@ -0,0 +1,356 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* Measure the dumps of the ROCdebug-agent on synthetic processes with many
+   agents and waves, without a GPU.  The agent library is built against the
+   fake-amd-dbgapi library, which simulates the process, and counts the
+   dbgapi calls made by the agent.
+
+   For each topology, the exception dumps are requested by raising
+   exceptions in the faulting waves, and the dumps of all the waves by
+   sending a SIGQUIT to the process.  A dump lasts from the request until
+   the agent lets the process make forward progress again.
+
+   The waves stopped by the agent report their stop after the stop latency
+   of the topology.  With stragglers that stop after the stop timeout of
+   the agent, or never, the late column counts the stops still outstanding
+   at the end of each dump, and the stuck column the waves the agent left
+   stopped after all the dumps of a scenario.  */
+
+#include "agent_library.h"
+#include "fake_dbgapi.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+using agent_library::clock_type;
+
+namespace
+{
+
+struct options_t
+{
+  std::string m_library{ AGENT_LIBRARY };
+  std::string m_agent_options{ "--output=/dev/null" };
+  fake_dbgapi::topology_t m_topology;
+  std::vector<size_t> m_agent_counts{ 1, 4 };
+  std::vector<size_t> m_wave_counts{ 16, 64 };
+  size_t m_dumps{ 5 };
+  bool m_print_calls{ false };
+};
+
+enum class scenario_t
+{
+  /* Raise exceptions in the faulting waves, the agent prints them.  */
+  exception,
+  /* Send a SIGQUIT, the agent stops and prints all the waves.  */
+  all_waves
+};
+
+/* The results of the dumps of one scenario.  */
+struct result_t
+{
+  std::vector<double> m_dump_ms;
+  std::vector<double> m_stop_ms;
+  size_t m_resumed_waves{ 0 };
+  size_t m_outstanding_stops{ 0 };
+  size_t m_stuck_waves{ 0 };
+  size_t m_calls{ 0 };
+  std::map<std::string, size_t> m_calls_by_function;
+};
+
+double
+elapsed_ms (clock_type::duration duration)
+{
+  return std::chrono::duration<double, std::milli> (duration).count ();
+}
+
+std::map<std::string, size_t>
+call_counts ()
+{
+  std::map<std::string, size_t> counts;
+  for (auto &&[function, count] : fake_dbgapi::call_counts ())
+    counts.emplace (function, count);
+  return counts;
+}
+
+/* Request OPTIONS.m_dumps dumps of SCENARIO from the agent, and wait for
+   each of them to complete.  */
+
+result_t
+run_dumps (const options_t &options, scenario_t scenario)
+{
+  result_t result;
+  const size_t calls = fake_dbgapi::call_count ();
+  const auto counts = call_counts ();
+
+  for (size_t i = 0; i < options.m_dumps; ++i)
+    {
+      const size_t cycle_count = fake_dbgapi::stop_cycle_count () + 1;
+      const auto start = clock_type::now ();
+
+      if (scenario == scenario_t::exception)
+        {
+          if (!fake_dbgapi::raise_exceptions ())
+            {
+              fprintf (stderr, "the topology has no faulting waves\n");
+              exit (1);
+            }
+        }
+      else
+        kill (getpid (), SIGQUIT);
+
+      auto cycle = fake_dbgapi::wait_for_stop_cycle (
+          cycle_count, std::chrono::seconds (60));
+      if (!cycle)
+        {
+          fprintf (stderr, "the agent did not complete the dump\n");
+          exit (1);
+        }
+
+      result.m_dump_ms.push_back (elapsed_ms (cycle->m_end - start));
+      if (cycle->m_stop_latency)
+        result.m_stop_ms.push_back (elapsed_ms (*cycle->m_stop_latency));
+      result.m_resumed_waves += cycle->m_resumed_waves;
+      result.m_outstanding_stops += cycle->m_outstanding_stops;
+    }
+
+  /* The late stops must be resumed by the agent when they are reported.  */
+  result.m_stuck_waves = fake_dbgapi::wait_for_running_waves (
+      options.m_topology.m_straggler_latency + std::chrono::seconds (1));
+
+  result.m_calls = fake_dbgapi::call_count () - calls;
+  for (auto &&[function, count] : call_counts ())
+    {
+      auto it = counts.find (function);
+      const size_t before = it != counts.end () ? it->second : 0;
+      if (count > before)
+        result.m_calls_by_function.emplace (function, count - before);
+    }
+  return result;
+}
+
+/* Return the mean, median, 99th percentile and maximum of SAMPLES.  */
+
+std::vector<double>
+distribution (std::vector<double> &samples)
+{
+  std::sort (samples.begin (), samples.end ());
+
+  auto percentile = [&] (double p) {
+    return samples[std::min (samples.size () - 1,
+                             static_cast<size_t> (p * samples.size ()))];
+  };
+
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+
+  return { total / samples.size (), percentile (0.5), percentile (0.99),
+           samples.back () };
+}
+
+void
+print_result (const options_t &options, scenario_t scenario,
+              const fake_dbgapi::topology_t &topology, result_t &result)
+{
+  const auto dump = distribution (result.m_dump_ms);
+
+  /* The waves are only stopped by the agent in the dumps of all the
+     waves.  */
+  char stop[16] = "-";
+  if (!result.m_stop_ms.empty ())
+    snprintf (stop, sizeof (stop), "%.2f",
+              distribution (result.m_stop_ms)[0]);
+
+  printf ("%-9s %6zu %7zu %9.2f %9.2f %9.2f %9.2f %9s %9zu %6zu %6zu "
+          "%11zu\n",
+          scenario == scenario_t::exception ? "exception" : "all",
+          topology.m_agents, topology.m_waves_per_agent, dump[0], dump[1],
+          dump[2], dump[3], stop, result.m_resumed_waves / options.m_dumps,
+          result.m_outstanding_stops / options.m_dumps, result.m_stuck_waves,
+          result.m_calls / options.m_dumps);
+
+  if (!options.m_print_calls)
+    return;
+
+  std::vector<std::pair<size_t, std::string>> calls;
+  for (auto &&[function, count] : result.m_calls_by_function)
+    calls.emplace_back (count, function);
+  std::sort (calls.rbegin (), calls.rend ());
+
+  for (auto &&[count, function] : calls)
+    printf ("  %-48s %11zu\n", function.c_str (), count / options.m_dumps);
+}
+
+/* Parse a comma-separated list of positive numbers.  */
+
+std::optional<std::vector<size_t>>
+parse_counts (const std::string &list)
+{
+  std::vector<size_t> counts;
+  size_t pos = 0;
+  while (pos <= list.size ())
+    {
+      size_t comma = list.find (',', pos);
+      if (comma == std::string::npos)
+        comma = list.size ();
+      size_t count = strtoul (list.c_str () + pos, nullptr, 10);
+      if (!count)
+        return std::nullopt;
+      counts.push_back (count);
+      pos = comma + 1;
+    }
+  return counts;
+}
+
+void
+print_usage (const char *program)
+{
+  fprintf (stderr,
+           "usage: %s [--library=PATH] [--agent-options=OPTIONS] "
+           "[--agents=N[,N...]]\n"
+           "          [--waves=N[,N...]] [--topology=SPEC] [--dumps=N] "
+           "[--calls]\n"
+           "  --library=PATH          The agent library built against "
+           "fake-amd-dbgapi.\n"
+           "  --agent-options=OPTIONS The ROCM_DEBUG_AGENT_OPTIONS of "
+           "the agent\n"
+           "                          (default --output=/dev/null).\n"
+           "  --agents=N[,N...]       The numbers of agents (default "
+           "1,4).\n"
+           "  --waves=N[,N...]        The numbers of waves per agent "
+           "(default 16,64).\n"
+           "  --topology=SPEC         The other settings of the "
+           "topology, for example\n"
+           "                          "
+           "faulting=8,vgprs=128,stop-reasons=trap+memory_violation\n"
+           "                          "
+           "or stop-latency-us=50,stragglers=2,straggler-latency-ms=0.\n"
+           "  --dumps=N               The dumps per scenario and "
+           "topology (default 5).\n"
+           "  --calls                 Print the dbgapi calls per dump "
+           "by function.\n",
+           program);
+  exit (1);
+}
+
+} /* namespace */
+
+int
+main (int argc, char **argv)
+{
+  options_t options;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      std::string arg (argv[i]);
+      auto value = [&] (const char *prefix) -> std::optional<std::string> {
+        if (arg.rfind (prefix, 0) != 0)
+          return std::nullopt;
+        return arg.substr (strlen (prefix));
+      };
+
+      if (auto library = value ("--library="))
+        options.m_library = *library;
+      else if (auto agent_options = value ("--agent-options="))
+        options.m_agent_options = *agent_options;
+      else if (auto agents = value ("--agents="))
+        {
+          auto counts = parse_counts (*agents);
+          if (!counts)
+            print_usage (argv[0]);
+          options.m_agent_counts = std::move (*counts);
+        }
+      else if (auto waves = value ("--waves="))
+        {
+          auto counts = parse_counts (*waves);
+          if (!counts)
+            print_usage (argv[0]);
+          options.m_wave_counts = std::move (*counts);
+        }
+      else if (auto spec = value ("--topology="))
+        {
+          auto topology = fake_dbgapi::parse_topology (*spec);
+          if (!topology)
+            print_usage (argv[0]);
+          options.m_topology = std::move (*topology);
+        }
+      else if (auto dumps = value ("--dumps="))
+        {
+          options.m_dumps = strtoul (dumps->c_str (), nullptr, 10);
+          if (!options.m_dumps)
+            print_usage (argv[0]);
+        }
+      else if (arg == "--calls")
+        options.m_print_calls = true;
+      else
+        print_usage (argv[0]);
+    }
+
+  agent_library::load (options.m_library, options.m_agent_options);
+  if (!fake_dbgapi::wait_for_attach (std::chrono::seconds (5)))
+    {
+      fprintf (stderr, "the agent did not attach the process\n");
+      exit (1);
+    }
+
+  printf ("%-9s %6s %7s %9s %9s %9s %9s %9s %9s %6s %6s %11s\n",
+          "scenario", "agents", "waves", "mean(ms)", "p50(ms)", "p99(ms)",
+          "max(ms)", "stop(ms)", "resumed", "late", "stuck", "calls/dump");
+
+  for (size_t agent_count : options.m_agent_counts)
+    for (size_t wave_count : options.m_wave_counts)
+      {
+        fake_dbgapi::topology_t topology = options.m_topology;
+        topology.m_agents = agent_count;
+        topology.m_waves_per_agent = wave_count;
+        fake_dbgapi::set_topology (topology);
+
+        for (auto scenario : { scenario_t::exception, scenario_t::all_waves })
+          {
+            result_t result = run_dumps (options, scenario);
+            print_result (options, scenario, topology, result);
+          }
+      }
+
+  agent_library::unload ();
+  return 0;
+}
@@ -0,0 +1,223 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* Check that a dump written with the binary writer and replayed into the
+   text writer, as rocm-debug-agent-print does, is printed exactly as the
+   text writer prints it directly, and that a text record does not change
+   how the next one is printed.  It does not need a GPU,
+   the records are made up.  */
+
+#include "dump.h"
+
+#include <amd-dbgapi/amd-dbgapi.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace amd::debug_agent;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(condition)                                                      \
+  do                                                                          \
+    {                                                                         \
+      if (!(condition))                                                       \
+        {                                                                     \
+          fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,  \
+                   #condition);                                               \
+          ++failures;                                                         \
+        }                                                                     \
+    }                                                                         \
+  while (0)
+
+const std::vector<register_class_t> registers
+    = { { "general",
+          { { "pc", "uint64_t", { 0x00, 0x11, 0, 0, 0, 0x7f, 0, 0 } },
+            { "exec", "uint32_t", { 1, 0, 0, 0 } },
+            { "v0", "int32_t[2]", { 1, 0, 0, 0, 2, 0, 0, 0 } } } },
+        { "scalar", { { "s0", "uint32_t", { 0x78, 0x56, 0x34, 0x12 } } } } };
+
+const std::vector<uint8_t> local_memory
+    = { 0x22, 0x22, 0x22, 0x22, 0x11, 0x11, 0x11, 0x11 };
+
+const disassembly_t disassembly
+    = { "vector_add(int*, int*, int*)",
+        0x7f0000001000,
+        "file:///tmp/a.out#offset=0",
+        0x7f0000000000,
+        0x3000,
+        0x7f0000001100,
+        { { disassembly_line_t::kind_t::file, 0, "vector_add.cpp" },
+          { disassembly_line_t::kind_t::source, 53, "  __builtin_trap ();" },
+          { disassembly_line_t::kind_t::ellipsis, 0, "" },
+          { disassembly_line_t::kind_t::instruction, 0x7f0000001100,
+            "s_trap 2" },
+          { disassembly_line_t::kind_t::blank, 0, "" },
+          { disassembly_line_t::kind_t::memory_error, 0x7f0000002000,
+            "" } } };
+
+const std::vector<hot_spot_t> hot_spots
+    = { { "vector_add(int*, int*, int*)",
+          "vector_add(int*, int*, int*)",
+          "vector_add.cpp",
+          53,
+          2,
+          { { 0x7f0000001100, 1 }, { 0x7f0000001104, 1 } } },
+        { std::nullopt,
+          std::nullopt,
+          std::nullopt,
+          0,
+          1,
+          { { 0x7f0000001200, 1 } } } };
+
+const std::vector<dispatch_info_t> dispatches
+    = { { 1, 9, 0x7f0000001000, "vector_add(int*, int*, int*)",
+          { 1024, 1, 1 }, { 256, 1, 1 }, 1500 },
+        { 1, 10, 0x7f0000001000, std::nullopt, { 64, 2, 1 }, { 64, 1, 1 },
+          3000000000 } };
+
+/* Write the records of a wave stopped by an assert trap to WRITER.  */
+
+void
+write_wave (dump_writer_t &writer)
+{
+  writer.wave ({ 1, 0x7f0000001100, AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP,
+                 0x7f0000001000, "vector_add(int*, int*, int*)", 3, 1 });
+  writer.registers (1, registers);
+  writer.local_memory (1, local_memory);
+  writer.disassembly (1, disassembly);
+  writer.end_wave (1);
+}
+
+/* Write a dump of two waves, with all the kinds of records, to WRITER.  */
+
+void
+write_dump (dump_writer_t &writer)
+{
+  writer.begin_dump ();
+  writer.code_object (
+      { 0x7f0000000000, 0x3000, "file:///tmp/a.out#offset=0" });
+  write_wave (writer);
+  writer.wave ({ 2, 0x7f0000001104,
+                 AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION, std::nullopt,
+                 std::nullopt, std::nullopt, std::nullopt });
+  writer.end_wave (2);
+  writer.hot_spots (3, hot_spots);
+  writer.dispatch_history (dispatches);
+  writer.end_dump ();
+}
+
+void
+test_binary_replay ()
+{
+  std::ostringstream binary;
+  write_dump (*make_dump_writer (output_format_t::binary, binary));
+
+  std::istringstream in (binary.str ());
+  std::ostringstream replayed;
+  CHECK (read_binary_dump (in, *make_dump_writer (output_format_t::text,
+                                                   replayed)));
+
+  std::ostringstream text;
+  write_dump (*make_dump_writer (output_format_t::text, text));
+  CHECK (replayed.str () == text.str ());
+}
+
+/* The text writer keeps its stream for the whole dump, a record must not
+   change how the next one is printed: check that the records printed after
+   the details of a wave are printed as after a wave without details.  The
+   local memory is printed last, its words are padded with '0'.  */
+
+void
+test_record_format ()
+{
+  auto print_after = [] (bool details, auto &&write_record) {
+    std::ostringstream out;
+    auto writer = make_dump_writer (output_format_t::text, out);
+    writer->wave ({ 1, 0x7f0000001100, 0, std::nullopt, std::nullopt,
+                    std::nullopt, std::nullopt });
+    if (details)
+      {
+        writer->registers (1, registers);
+        writer->disassembly (1, disassembly);
+        writer->local_memory (1, local_memory);
+      }
+    const size_t wave_size = out.str ().size ();
+    write_record (*writer);
+    return out.str ().substr (wave_size);
+  };
+
+  auto write_wave_2 = [] (dump_writer_t &writer) {
+    writer.wave ({ 2, 0x7f0000001104,
+                   AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION,
+                   0x7f0000001000, "vector_add(int*, int*, int*)",
+                   std::nullopt, std::nullopt });
+    writer.registers (2, registers);
+    writer.local_memory (2, local_memory);
+    writer.disassembly (2, disassembly);
+  };
+  CHECK (print_after (true, write_wave_2)
+         == print_after (false, write_wave_2));
+
+  auto write_hot_spots
+      = [] (dump_writer_t &writer) { writer.hot_spots (3, hot_spots); };
+  CHECK (print_after (true, write_hot_spots)
+         == print_after (false, write_hot_spots));
+
+  auto write_dispatch_history = [] (dump_writer_t &writer) {
+    writer.dispatch_history (dispatches);
+  };
+  CHECK (print_after (true, write_dispatch_history)
+         == print_after (false, write_dispatch_history));
+}
+
+} /* namespace */
+
+int
+main ()
+{
+  test_binary_replay ();
+  test_record_format ();
+
+  if (failures)
+    {
+      fprintf (stderr, "%d checks failed\n", failures);
+      return 1;
+    }
+
+  printf ("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,1836 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* A stand-in for the ROCdbgapi library.  The synthetic process described by
+   the topology has agents whose waves execute kernels in code objects
+   loaded in host memory.  Its waves only stop when the benchmark raises
+   exceptions, or when the agent stops them.  A wave stopped by the agent
+   stops after the stop latency of the topology, a thread reports its stop
+   event then.  Every function counts its calls, and takes a global lock
+   like the real library does.
+
+   Each code object is an ELF image with a symbol for each of its kernels,
+   and the code of the kernels, whose instructions are 32-bit words, is
+   loaded in a separate buffer.  Both are read by the agent through its
+   xfer_global_memory callback, as the real library would.  */
+
+#include "fake_dbgapi.h"
+
+#include <elf.h>
+#include <link.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifndef EM_AMDGPU
+#define EM_AMDGPU 224
+#endif
+
+/* The runtime debug interface, exported by the ROCm runtime.  The
+   ROCdebug-agent only compares the address of the r_brk function with the
+   address of the breakpoint inserted by dbgapi.  */
+
+extern "C" void
+_amdgpu_r_debug_breakpoint ()
+{
+}
+
+r_debug _amdgpu_r_debug = { 1, nullptr,
+                            reinterpret_cast<ElfW (Addr)> (
+                                &_amdgpu_r_debug_breakpoint),
+                            r_debug::RT_CONSISTENT, 0 };
+
+using namespace fake_dbgapi;
+
+namespace
+{
+
+/* Count the calls to the function it is used in.  The counter of each
+   function is looked up once.  */
+#define COUNT_CALL()                                                          \
+  do                                                                          \
+    {                                                                         \
+      static std::atomic<size_t> &counter = call_counter (__func__);          \
+      counter.fetch_add (1, std::memory_order_relaxed);                       \
+    }                                                                         \
+  while (false)
+
+std::mutex g_counters_mutex;
+std::map<std::string, std::atomic<size_t>> g_call_counters;
+
+std::atomic<size_t> &
+call_counter (const char *function)
+{
+  std::lock_guard<std::mutex> lock (g_counters_mutex);
+  return g_call_counters[function];
+}
+
+/* The address spaces of the architecture.  */
+constexpr amd_dbgapi_address_space_id_t local_address_space{ 3 };
+
+constexpr amd_dbgapi_architecture_id_t architecture_id{ 1 };
+constexpr size_t largest_instruction_size = 8;
+
+/* The register classes, in the order they are listed.  */
+enum register_class_t
+{
+  register_class_scalar,
+  register_class_vector,
+  register_class_system,
+  register_class_general,
+  register_class_number
+};
+
+const char *const register_class_names[register_class_number]
+    = { "scalar", "vector", "system", "general" };
+
+struct register_desc_t
+{
+  std::string m_name;
+  std::string m_type;
+  size_t m_size;
+  register_class_t m_class;
+};
+
+struct agent_t
+{
+  amd_dbgapi_os_agent_id_t m_os_id;
+};
+
+struct dispatch_t
+{
+  size_t m_agent;
+  amd_dbgapi_global_address_t m_kernel_entry;
+};
+
+struct wave_t
+{
+  size_t m_dispatch;
+  amd_dbgapi_global_address_t m_pc;
+  amd_dbgapi_wave_state_t m_state{ AMD_DBGAPI_WAVE_STATE_RUN };
+  amd_dbgapi_wave_stop_reasons_t m_stop_reason{
+    AMD_DBGAPI_WAVE_STOP_REASON_NONE
+  };
+  /* The index of the stop reason given when an exception is raised, if the
+     wave is faulting.  */
+  std::optional<size_t> m_fault;
+  /* True if the wave takes the straggler latency to stop.  */
+  bool m_straggler{ false };
+  /* True if a stop was requested by amd_dbgapi_wave_stop, and its stop
+     event was not processed yet, and the stop cycle it was requested in.  */
+  bool m_stop_requested{ false };
+  size_t m_stop_cycle{ 0 };
+};
+
+struct code_object_t
+{
+  std::vector<uint8_t> m_image;
+  /* The kernels' code, padded so that the largest instruction can be read
+     at any pc.  Its address is the load address of the code object.  */
+  std::vector<uint32_t> m_code;
+  std::string m_uri;
+};
+
+struct event_t
+{
+  amd_dbgapi_event_id_t m_id;
+  amd_dbgapi_event_kind_t m_kind;
+  amd_dbgapi_runtime_state_t m_runtime_state;
+  amd_dbgapi_wave_id_t m_wave;
+  amd_dbgapi_queue_id_t m_queue;
+};
+
+struct process_t
+{
+  amd_dbgapi_process_id_t m_id;
+  amd_dbgapi_client_process_id_t m_client_process_id;
+  amd_dbgapi_breakpoint_id_t m_rbrk_breakpoint_id;
+  int m_notifier;
+  /* The events not yet returned by amd_dbgapi_process_next_pending_event,
+     and the events returned but not yet processed.  */
+  std::deque<event_t> m_pending_events;
+  std::deque<event_t> m_reported_events;
+
+  std::vector<agent_t> m_agents;
+  std::vector<dispatch_t> m_dispatches;
+  std::vector<wave_t> m_waves;
+  std::vector<code_object_t> m_code_objects;
+  /* The handle of the first wave.  The handles of the waves replaced by a
+     new topology are not reused, like the real library's.  */
+  uint64_t m_first_wave_handle{ 1 };
+  bool m_wave_list_changed{ true };
+  bool m_code_object_list_changed{ true };
+
+  amd_dbgapi_progress_t m_progress{ AMD_DBGAPI_PROGRESS_NORMAL };
+  /* The stop cycle in progress, and the time of its first stop request.  */
+  std::optional<stop_cycle_t> m_stop_cycle;
+  std::optional<std::chrono::steady_clock::time_point> m_first_stop;
+  /* The waves stopping, by the time they stop.  */
+  std::multimap<std::chrono::steady_clock::time_point, amd_dbgapi_wave_id_t>
+      m_pending_stops;
+};
+
+std::mutex g_mutex;
+std::condition_variable g_state_cv;
+
+std::optional<amd_dbgapi_callbacks_t> g_callbacks;
+std::optional<process_t> g_process;
+std::optional<topology_t> g_topology;
+std::vector<register_desc_t> g_registers;
+std::optional<std::chrono::steady_clock::time_point> g_attach_time;
+uint64_t g_next_event_handle{ 1 };
+
+std::atomic<std::chrono::nanoseconds::rep> g_report_cost{ 0 };
+
+size_t g_stop_cycle_count{ 0 };
+std::optional<stop_cycle_t> g_last_stop_cycle;
+
+void
+spin_for (std::chrono::nanoseconds duration)
+{
+  const auto end = std::chrono::steady_clock::now () + duration;
+  while (std::chrono::steady_clock::now () < end)
+    ;
+}
+
+/* Return a copy of STRING allocated with the client's allocator.  */
+
+char *
+allocate_string (const std::string &string)
+{
+  const size_t size = string.size () + 1;
+  char *copy = static_cast<char *> (g_callbacks->allocate_memory (size));
+  if (copy)
+    memcpy (copy, string.c_str (), size);
+  return copy;
+}
+
+/* Return the handles FIRST to FIRST + COUNT - 1 in an array allocated with
+   the client's allocator.  */
+
+template <typename T>
+T *
+allocate_handles (size_t count, uint64_t first = 1)
+{
+  T *handles
+      = static_cast<T *> (g_callbacks->allocate_memory (count * sizeof (T)));
+  if (handles)
+    for (size_t i = 0; i < count; ++i)
+      handles[i] = T{ first + i };
+  return handles;
+}
+
+template <typename T>
+amd_dbgapi_status_t
+get_info (size_t value_size, void *value, const T &result)
+{
+  if (value == nullptr)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+  if (value_size != sizeof (T))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT_COMPATIBILITY;
+
+  *static_cast<T *> (value) = result;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+get_string_info (size_t value_size, void *value, const std::string &result)
+{
+  if (value == nullptr)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+  if (value_size != sizeof (char *))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT_COMPATIBILITY;
+
+  char *string = allocate_string (result);
+  if (!string)
+    return AMD_DBGAPI_STATUS_ERROR_CLIENT_CALLBACK;
+
+  *static_cast<char **> (value) = string;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+process_t *
+find_process (amd_dbgapi_process_id_t process_id)
+{
+  if (!g_process || g_process->m_id.handle != process_id.handle)
+    return nullptr;
+  return &*g_process;
+}
+
+/* The objects of the process are numbered from 1 in the order of their
+   vectors.  */
+
+template <typename T>
+T *
+find_object (std::vector<T> &objects, uint64_t handle)
+{
+  if (handle == 0 || handle > objects.size ())
+    return nullptr;
+  return &objects[handle - 1];
+}
+
+template <typename T>
+T *
+find_object (std::vector<T> process_t::*objects, uint64_t handle)
+{
+  return g_process ? find_object ((*g_process).*objects, handle) : nullptr;
+}
+
+wave_t *
+find_wave (amd_dbgapi_wave_id_t wave_id)
+{
+  if (!g_process || wave_id.handle < g_process->m_first_wave_handle)
+    return nullptr;
+  return find_object (g_process->m_waves,
+                      wave_id.handle - g_process->m_first_wave_handle + 1);
+}
+
+/* Queue an event and wake up the client waiting on the notifier.  */
+
+void
+queue_event (process_t &process, event_t event)
+{
+  event.m_id = amd_dbgapi_event_id_t{ g_next_event_handle++ };
+  process.m_pending_events.push_back (event);
+
+  uint64_t one = 1;
+  if (write (process.m_notifier, &one, sizeof (one)) != sizeof (one))
+    abort ();
+}
+
+event_t *
+find_event (amd_dbgapi_event_id_t event_id)
+{
+  if (!g_process)
+    return nullptr;
+
+  for (auto &&event : g_process->m_reported_events)
+    if (event.m_id.handle == event_id.handle)
+      return &event;
+  return nullptr;
+}
+
+/* Stop WAVE, whose stop was requested, and report its stop event.  */
+
+void
+stop_wave (process_t &process, wave_t &wave, amd_dbgapi_wave_id_t wave_id)
+{
+  wave.m_state = AMD_DBGAPI_WAVE_STATE_STOP;
+  wave.m_stop_reason = AMD_DBGAPI_WAVE_STOP_REASON_NONE;
+  queue_event (process,
+               { {}, AMD_DBGAPI_EVENT_KIND_WAVE_STOP, {}, wave_id, {} });
+}
+
+/* The thread that stops the waves of the process when their stop latency
+   expires.  It is started by the first stop that is not immediate, and
+   stopped when the process is detached or the library is unloaded.  */
+
+class stopper_t
+{
+public:
+  ~stopper_t () { stop (); }
+
+  /* Start the thread if it is not running, and wake it up so that it sees
+     a new pending stop.  Called with g_mutex held.  */
+  void notify ();
+  /* Stop the thread.  Called without g_mutex held.  */
+  void stop ();
+
+private:
+  void run (uint64_t generation);
+
+  std::thread m_thread;
+  std::condition_variable m_cv;
+  /* Incremented to tell the running thread to exit.  */
+  uint64_t m_generation{ 0 };
+};
+
+stopper_t g_stopper;
+
+void
+stopper_t::notify ()
+{
+  if (!m_thread.joinable ())
+    m_thread = std::thread (&stopper_t::run, this, m_generation);
+  m_cv.notify_one ();
+}
+
+void
+stopper_t::stop ()
+{
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    if (!m_thread.joinable ())
+      return;
+    ++m_generation;
+    thread = std::move (m_thread);
+  }
+  m_cv.notify_one ();
+  thread.join ();
+}
+
+void
+stopper_t::run (uint64_t generation)
+{
+  std::unique_lock<std::mutex> lock (g_mutex);
+  while (generation == m_generation)
+    {
+      if (!g_process || g_process->m_pending_stops.empty ())
+        {
+          m_cv.wait (lock);
+          continue;
+        }
+
+      auto it = g_process->m_pending_stops.begin ();
+      if (std::chrono::steady_clock::now () < it->first)
+        {
+          m_cv.wait_until (lock, it->first);
+          continue;
+        }
+
+      const amd_dbgapi_wave_id_t wave_id = it->second;
+      g_process->m_pending_stops.erase (it);
+
+      /* The wave could have stopped because of an exception in the
+         meantime, its stop event reports both.  */
+      if (wave_t *wave = find_wave (wave_id);
+          wave && wave->m_state == AMD_DBGAPI_WAVE_STATE_RUN)
+        stop_wave (*g_process, *wave, wave_id);
+    }
+}
+
+/* The registers of the architecture: the pc, exec and status registers,
+   then the scalar and vector registers.  */
+
+std::vector<register_desc_t>
+make_registers (const topology_t &topology)
+{
+  std::vector<register_desc_t> registers;
+  registers.push_back ({ "pc", "code_ptr", 8, register_class_system });
+  registers.push_back ({ "exec", "uint64_t", 8, register_class_system });
+  registers.push_back ({ "status", "uint32_t", 4, register_class_system });
+
+  for (size_t i = 0; i < topology.m_sgprs; ++i)
+    registers.push_back (
+        { "s" + std::to_string (i), "int32_t", 4, register_class_scalar });
+
+  const std::string vector_type
+      = "int32_t[" + std::to_string (topology.m_lanes) + "]";
+  for (size_t i = 0; i < topology.m_vgprs; ++i)
+    registers.push_back ({ "v" + std::to_string (i), vector_type,
+                           4 * topology.m_lanes, register_class_vector });
+
+  return registers;
+}
+
+/* Return an ELF image of a code object whose text contains KERNEL_COUNT
+   kernels of KERNEL_SIZE bytes, with a function symbol for each kernel.
+   The text occupies no space in the image.  */
+
+std::vector<uint8_t>
+make_elf_image (size_t index, size_t kernel_count, size_t kernel_size)
+{
+  std::string strtab (1, '\0');
+  std::vector<Elf64_Sym> symbols (1);
+  for (size_t i = 0; i < kernel_count; ++i)
+    {
+      /* A mangled name, as for a HIP kernel taking a float * and an int.  */
+      const std::string name = "fake_kernel_" + std::to_string (index) + "_"
+                               + std::to_string (i);
+      Elf64_Sym symbol{};
+      symbol.st_name = strtab.size ();
+      symbol.st_info = ELF64_ST_INFO (STB_GLOBAL, STT_FUNC);
+      symbol.st_shndx = 1;
+      symbol.st_value = i * kernel_size;
+      symbol.st_size = kernel_size;
+      symbols.push_back (symbol);
+
+      strtab += "_Z" + std::to_string (name.size ()) + name + "Pfi";
+      strtab += '\0';
+    }
+
+  const std::string shstrtab ("\0.text\0.symtab\0.strtab\0.shstrtab\0", 34);
+
+  const size_t phdr_offset = sizeof (Elf64_Ehdr);
+  const size_t symtab_offset = phdr_offset + sizeof (Elf64_Phdr);
+  const size_t symtab_size = symbols.size () * sizeof (Elf64_Sym);
+  const size_t strtab_offset = symtab_offset + symtab_size;
+  const size_t shstrtab_offset = strtab_offset + strtab.size ();
+  const size_t shdr_offset
+      = (shstrtab_offset + shstrtab.size () + 7) & ~size_t{ 7 };
+
+  std::vector<Elf64_Shdr> sections (5);
+  sections[1].sh_name = 1;
+  sections[1].sh_type = SHT_NOBITS;
+  sections[1].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+  sections[1].sh_size = kernel_count * kernel_size;
+  sections[1].sh_addralign = 256;
+  sections[2].sh_name = 7;
+  sections[2].sh_type = SHT_SYMTAB;
+  sections[2].sh_offset = symtab_offset;
+  sections[2].sh_size = symtab_size;
+  sections[2].sh_link = 3;
+  sections[2].sh_info = 1;
+  sections[2].sh_addralign = 8;
+  sections[2].sh_entsize = sizeof (Elf64_Sym);
+  sections[3].sh_name = 15;
+  sections[3].sh_type = SHT_STRTAB;
+  sections[3].sh_offset = strtab_offset;
+  sections[3].sh_size = strtab.size ();
+  sections[3].sh_addralign = 1;
+  sections[4].sh_name = 23;
+  sections[4].sh_type = SHT_STRTAB;
+  sections[4].sh_offset = shstrtab_offset;
+  sections[4].sh_size = shstrtab.size ();
+  sections[4].sh_addralign = 1;
+
+  Elf64_Ehdr ehdr{};
+  memcpy (ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_ident[EI_OSABI] = 64 /* ELFOSABI_AMDGPU_HSA */;
+  ehdr.e_type = ET_DYN;
+  ehdr.e_machine = EM_AMDGPU;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_phoff = phdr_offset;
+  ehdr.e_shoff = shdr_offset;
+  ehdr.e_ehsize = sizeof (Elf64_Ehdr);
+  ehdr.e_phentsize = sizeof (Elf64_Phdr);
+  ehdr.e_phnum = 1;
+  ehdr.e_shentsize = sizeof (Elf64_Shdr);
+  ehdr.e_shnum = sections.size ();
+  ehdr.e_shstrndx = 4;
+
+  Elf64_Phdr phdr{};
+  phdr.p_type = PT_LOAD;
+  phdr.p_flags = PF_R | PF_X;
+  phdr.p_memsz = kernel_count * kernel_size;
+  phdr.p_align = 4096;
+
+  std::vector<uint8_t> image (shdr_offset
+                              + sections.size () * sizeof (Elf64_Shdr));
+  memcpy (&image[0], &ehdr, sizeof (ehdr));
+  memcpy (&image[phdr_offset], &phdr, sizeof (phdr));
+  memcpy (&image[symtab_offset], symbols.data (), symtab_size);
+  memcpy (&image[strtab_offset], strtab.data (), strtab.size ());
+  memcpy (&image[shstrtab_offset], shstrtab.data (), shstrtab.size ());
+  memcpy (&image[shdr_offset], sections.data (),
+          sections.size () * sizeof (Elf64_Shdr));
+  return image;
+}
+
+/* Create the agents, dispatches, waves and code objects of PROCESS from
+   TOPOLOGY.  */
+
+void
+build_process (process_t &process, const topology_t &topology)
+{
+  process.m_code_objects.clear ();
+  process.m_code_objects.reserve (topology.m_code_objects);
+
+  std::vector<amd_dbgapi_global_address_t> kernel_entries;
+  for (size_t i = 0; i < topology.m_code_objects; ++i)
+    {
+      code_object_t &code_object = process.m_code_objects.emplace_back ();
+      code_object.m_image = make_elf_image (
+          i, topology.m_kernels_per_code_object, topology.m_kernel_size);
+
+      const size_t code_size
+          = topology.m_kernels_per_code_object * topology.m_kernel_size;
+      code_object.m_code.resize (
+          (code_size + largest_instruction_size) / sizeof (uint32_t));
+      for (size_t j = 0; j < code_object.m_code.size (); ++j)
+        code_object.m_code[j] = (i << 24) | j;
+
+      const auto load_address
+          = reinterpret_cast<amd_dbgapi_global_address_t> (
+              code_object.m_code.data ());
+      for (size_t j = 0; j < topology.m_kernels_per_code_object; ++j)
+        kernel_entries.push_back (load_address + j * topology.m_kernel_size);
+
+      char uri[128];
+      snprintf (uri, sizeof (uri), "memory://%d#offset=%#lx&size=%zu",
+                getpid (),
+                reinterpret_cast<uintptr_t> (code_object.m_image.data ()),
+                code_object.m_image.size ());
+      code_object.m_uri = uri;
+    }
+
+  process.m_agents.clear ();
+  process.m_dispatches.clear ();
+  process.m_first_wave_handle += process.m_waves.size ();
+  process.m_waves.clear ();
+  process.m_pending_stops.clear ();
+
+  for (size_t i = 0; i < topology.m_agents; ++i)
+    {
+      process.m_agents.push_back ({ 1000 + i });
+
+      for (size_t j = 0; j < topology.m_dispatches_per_agent; ++j)
+        {
+          amd_dbgapi_global_address_t kernel_entry{ 0 };
+          if (!kernel_entries.empty ())
+            kernel_entry = kernel_entries[process.m_dispatches.size ()
+                                          % kernel_entries.size ()];
+          process.m_dispatches.push_back ({ i, kernel_entry });
+        }
+    }
+
+  /* Leave room for the instructions disassembled after the pc.  */
+  const size_t pc_slots = std::max<size_t> (
+      topology.m_kernel_size / sizeof (uint32_t), 16)
+      - 12;
+  const size_t wave_count = topology.m_agents * topology.m_waves_per_agent;
+  const size_t fault_stride
+      = topology.m_faulting_waves
+            ? std::max<size_t> (wave_count / topology.m_faulting_waves, 1)
+            : 0;
+
+  for (size_t i = 0; i < wave_count; ++i)
+    {
+      const size_t agent = i % topology.m_agents;
+      const size_t dispatch
+          = agent * topology.m_dispatches_per_agent
+            + (i / topology.m_agents) % topology.m_dispatches_per_agent;
+
+      wave_t &wave = process.m_waves.emplace_back ();
+      wave.m_dispatch = dispatch;
+      wave.m_pc = process.m_dispatches[dispatch].m_kernel_entry
+                  + ((i * 7) % pc_slots) * sizeof (uint32_t);
+
+      if (fault_stride && i % fault_stride == 0
+          && i / fault_stride < topology.m_faulting_waves
+          && !topology.m_stop_reasons.empty ())
+        wave.m_fault.emplace ((i / fault_stride)
+                              % topology.m_stop_reasons.size ());
+
+      wave.m_straggler = i + topology.m_stragglers >= wave_count;
+    }
+
+  g_registers = make_registers (topology);
+  process.m_wave_list_changed = true;
+  process.m_code_object_list_changed = true;
+}
+
+/* The topology of the process, read from the environment if it was not
+   set.  */
+
+const topology_t &
+topology ()
+{
+  if (!g_topology)
+    {
+      const char *spec = getenv ("FAKE_DBGAPI_TOPOLOGY");
+      if (spec)
+        g_topology = parse_topology (spec);
+
+      if (!g_topology)
+        {
+          if (spec)
+            fprintf (stderr, "fake-amd-dbgapi: invalid topology `%s'\n",
+                     spec);
+          g_topology.emplace ();
+        }
+    }
+  return *g_topology;
+}
+
+/* Record the processing of the stop event of WAVE, stopped by
+   amd_dbgapi_wave_stop.  */
+
+void
+stop_event_processed (process_t &process, const wave_t &wave)
+{
+  if (!process.m_stop_cycle || !process.m_first_stop
+      || wave.m_stop_cycle != g_stop_cycle_count)
+    return;
+
+  process.m_stop_cycle->m_stop_latency.emplace (
+      std::chrono::steady_clock::now () - *process.m_first_stop);
+}
+
+const std::pair<const char *, amd_dbgapi_wave_stop_reasons_t>
+    stop_reason_names[] = {
+      { "breakpoint", AMD_DBGAPI_WAVE_STOP_REASON_BREAKPOINT },
+      { "watchpoint", AMD_DBGAPI_WAVE_STOP_REASON_WATCHPOINT },
+      { "single_step", AMD_DBGAPI_WAVE_STOP_REASON_SINGLE_STEP },
+      { "fp_input_denormal", AMD_DBGAPI_WAVE_STOP_REASON_FP_INPUT_DENORMAL },
+      { "fp_divide_by_0", AMD_DBGAPI_WAVE_STOP_REASON_FP_DIVIDE_BY_0 },
+      { "fp_overflow", AMD_DBGAPI_WAVE_STOP_REASON_FP_OVERFLOW },
+      { "fp_underflow", AMD_DBGAPI_WAVE_STOP_REASON_FP_UNDERFLOW },
+      { "fp_inexact", AMD_DBGAPI_WAVE_STOP_REASON_FP_INEXACT },
+      { "fp_invalid_operation",
+        AMD_DBGAPI_WAVE_STOP_REASON_FP_INVALID_OPERATION },
+      { "int_divide_by_0", AMD_DBGAPI_WAVE_STOP_REASON_INT_DIVIDE_BY_0 },
+      { "debug_trap", AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP },
+      { "assert_trap", AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP },
+      { "trap", AMD_DBGAPI_WAVE_STOP_REASON_TRAP },
+      { "memory_violation", AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION },
+      { "address_error", AMD_DBGAPI_WAVE_STOP_REASON_ADDRESS_ERROR },
+      { "illegal_instruction",
+        AMD_DBGAPI_WAVE_STOP_REASON_ILLEGAL_INSTRUCTION },
+      { "ecc_error", AMD_DBGAPI_WAVE_STOP_REASON_ECC_ERROR },
+      { "fatal_halt", AMD_DBGAPI_WAVE_STOP_REASON_FATAL_HALT },
+    };
+
+} /* namespace */
+
+namespace fake_dbgapi
+{
+
+std::optional<topology_t>
+parse_topology (const std::string &spec)
+{
+  topology_t topology;
+
+  size_t pos = 0;
+  while (pos < spec.size ())
+    {
+      size_t end = spec.find (',', pos);
+      if (end == std::string::npos)
+        end = spec.size ();
+      const std::string setting = spec.substr (pos, end - pos);
+      pos = end + 1;
+
+      const size_t equal = setting.find ('=');
+      if (equal == std::string::npos)
+        return std::nullopt;
+      const std::string key = setting.substr (0, equal);
+      const std::string value = setting.substr (equal + 1);
+
+      if (key == "stop-reasons")
+        {
+          topology.m_stop_reasons.clear ();
+          size_t name_pos = 0;
+          while (name_pos <= value.size ())
+            {
+              size_t name_end = value.find ('+', name_pos);
+              if (name_end == std::string::npos)
+                name_end = value.size ();
+              const std::string name
+                  = value.substr (name_pos, name_end - name_pos);
+              name_pos = name_end + 1;
+
+              auto it = std::find_if (
+                  std::begin (stop_reason_names),
+                  std::end (stop_reason_names), [&] (auto &&entry) {
+                    return !strcasecmp (entry.first, name.c_str ());
+                  });
+              if (it == std::end (stop_reason_names))
+                return std::nullopt;
+              topology.m_stop_reasons.push_back (it->second);
+            }
+          continue;
+        }
+
+      char *value_end;
+      const size_t number = strtoul (value.c_str (), &value_end, 0);
+      if (value.empty () || *value_end)
+        return std::nullopt;
+
+      if (key == "agents" && number)
+        topology.m_agents = number;
+      else if (key == "waves")
+        topology.m_waves_per_agent = number;
+      else if (key == "dispatches" && number)
+        topology.m_dispatches_per_agent = number;
+      else if (key == "code-objects")
+        topology.m_code_objects = number;
+      else if (key == "kernels" && number)
+        topology.m_kernels_per_code_object = number;
+      else if (key == "kernel-size" && number && !(number % 256))
+        topology.m_kernel_size = number;
+      else if (key == "faulting")
+        topology.m_faulting_waves = number;
+      else if (key == "sgprs")
+        topology.m_sgprs = number;
+      else if (key == "vgprs")
+        topology.m_vgprs = number;
+      else if (key == "lanes" && number)
+        topology.m_lanes = number;
+      else if (key == "lds" && !(number % sizeof (uint32_t)))
+        topology.m_lds_size = number;
+      else if (key == "stop-cost-ns")
+        topology.m_stop_cost = std::chrono::nanoseconds (number);
+      else if (key == "stop-latency-us")
+        topology.m_stop_latency = std::chrono::microseconds (number);
+      else if (key == "stragglers")
+        topology.m_stragglers = number;
+      else if (key == "straggler-latency-ms")
+        topology.m_straggler_latency = std::chrono::milliseconds (number);
+      else
+        return std::nullopt;
+    }
+
+  return topology;
+}
+
+void
+set_topology (const topology_t &topology)
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  g_topology.emplace (topology);
+  if (g_process)
+    build_process (*g_process, topology);
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+wait_for_attach (std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock (g_mutex);
+  g_state_cv.wait_for (lock, timeout,
+                       [] () { return g_attach_time.has_value (); });
+  return g_attach_time;
+}
+
+void
+set_report_cost (std::chrono::nanoseconds cost)
+{
+  g_report_cost.store (cost.count (), std::memory_order_relaxed);
+}
+
+size_t
+raise_exceptions ()
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!g_process)
+    return 0;
+
+  const auto &stop_reasons = topology ().m_stop_reasons;
+  size_t count = 0;
+  for (size_t i = 0; i < g_process->m_waves.size (); ++i)
+    {
+      wave_t &wave = g_process->m_waves[i];
+      if (!wave.m_fault || wave.m_state != AMD_DBGAPI_WAVE_STATE_RUN)
+        continue;
+
+      wave.m_state = AMD_DBGAPI_WAVE_STATE_STOP;
+      wave.m_stop_reason = stop_reasons[*wave.m_fault];
+      queue_event (*g_process,
+                   { {},
+                     AMD_DBGAPI_EVENT_KIND_WAVE_STOP,
+                     {},
+                     { g_process->m_first_wave_handle + i },
+                     {} });
+      ++count;
+    }
+  return count;
+}
+
+void
+raise_queue_error ()
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!g_process || g_process->m_agents.empty ())
+    return;
+
+  queue_event (*g_process, { {}, AMD_DBGAPI_EVENT_KIND_QUEUE_ERROR, {}, {},
+                             amd_dbgapi_queue_id_t{ 1 } });
+}
+
+size_t
+stop_cycle_count ()
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  return g_stop_cycle_count;
+}
+
+std::optional<stop_cycle_t>
+wait_for_stop_cycle (size_t count, std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock (g_mutex);
+  if (!g_state_cv.wait_for (lock, timeout, [count] () {
+        return g_stop_cycle_count >= count;
+      }))
+    return std::nullopt;
+  return g_last_stop_cycle;
+}
+
+size_t
+wait_for_running_waves (std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock (g_mutex);
+
+  auto stopped_waves = [] () {
+    if (!g_process)
+      return size_t{ 0 };
+
+    const bool stragglers_stop = topology ().m_straggler_latency.count ();
+    return static_cast<size_t> (std::count_if (
+        g_process->m_waves.begin (), g_process->m_waves.end (),
+        [&] (auto &&wave) {
+          return wave.m_state != AMD_DBGAPI_WAVE_STATE_RUN
+                 || (wave.m_stop_requested
+                     && (!wave.m_straggler || stragglers_stop));
+        }));
+  };
+
+  size_t count;
+  g_state_cv.wait_for (lock, timeout,
+                       [&] () { return (count = stopped_waves ()) == 0; });
+  return count;
+}
+
+size_t
+call_count (const char *function)
+{
+  std::lock_guard<std::mutex> lock (g_counters_mutex);
+  if (function)
+    {
+      auto it = g_call_counters.find (function);
+      return it != g_call_counters.end ()
+                 ? it->second.load (std::memory_order_relaxed)
+                 : 0;
+    }
+
+  size_t total = 0;
+  for (auto &&[name, counter] : g_call_counters)
+    total += counter.load (std::memory_order_relaxed);
+  return total;
+}
+
+std::vector<std::pair<std::string, size_t>>
+call_counts ()
+{
+  std::lock_guard<std::mutex> lock (g_counters_mutex);
+  std::vector<std::pair<std::string, size_t>> counts;
+  for (auto &&[name, counter] : g_call_counters)
+    if (size_t count = counter.load (std::memory_order_relaxed))
+      counts.emplace_back (name, count);
+  return counts;
+}
+
+} /* namespace fake_dbgapi */
+
+/* Initialization and logging.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_initialize (amd_dbgapi_callbacks_t *callbacks)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (g_callbacks)
+    return AMD_DBGAPI_STATUS_ERROR_ALREADY_INITIALIZED;
+  if (!callbacks)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  g_callbacks.emplace (*callbacks);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_finalize ()
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!g_callbacks)
+    return AMD_DBGAPI_STATUS_ERROR_NOT_INITIALIZED;
+  if (g_process)
+    return AMD_DBGAPI_STATUS_ERROR;
+
+  g_callbacks.reset ();
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+void
+amd_dbgapi_set_log_level (amd_dbgapi_log_level_t level)
+{
+  COUNT_CALL ();
+}
+
+/* Processes.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_process_attach (amd_dbgapi_client_process_id_t client_process_id,
+                           amd_dbgapi_process_id_t *process_id)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!g_callbacks)
+    return AMD_DBGAPI_STATUS_ERROR_NOT_INITIALIZED;
+  if (!process_id)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+  if (g_process)
+    return AMD_DBGAPI_STATUS_ERROR_ALREADY_ATTACHED;
+
+  int notifier = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (notifier == -1)
+    return AMD_DBGAPI_STATUS_ERROR;
+
+  process_t &process = g_process.emplace ();
+  process.m_id = amd_dbgapi_process_id_t{ 1 };
+  process.m_client_process_id = client_process_id;
+  process.m_rbrk_breakpoint_id = amd_dbgapi_breakpoint_id_t{ 1 };
+  process.m_notifier = notifier;
+
+  /* Like the real library, stop in r_brk to learn when the code objects
+     loaded by the runtime change.  */
+  if (g_callbacks->insert_breakpoint (client_process_id,
+                                      _amdgpu_r_debug.r_brk,
+                                      process.m_rbrk_breakpoint_id)
+      != AMD_DBGAPI_STATUS_SUCCESS)
+    {
+      close (notifier);
+      g_process.reset ();
+      return AMD_DBGAPI_STATUS_ERROR;
+    }
+
+  build_process (process, topology ());
+
+  /* The runtime is already loaded when the tools are loaded.  */
+  queue_event (process, { {}, AMD_DBGAPI_EVENT_KIND_RUNTIME,
+                          AMD_DBGAPI_RUNTIME_STATE_LOADED_SUCCESS, {}, {} });
+
+  *process_id = process.m_id;
+  g_attach_time.emplace (std::chrono::steady_clock::now ());
+  g_state_cv.notify_all ();
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_process_detach (amd_dbgapi_process_id_t process_id)
+{
+  COUNT_CALL ();
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    process_t *process = find_process (process_id);
+    if (!process)
+      return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+
+    g_callbacks->remove_breakpoint (process->m_client_process_id,
+                                    process->m_rbrk_breakpoint_id);
+    close (process->m_notifier);
+    g_process.reset ();
+  }
+
+  g_stopper.stop ();
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_process_get_info (amd_dbgapi_process_id_t process_id,
+                             amd_dbgapi_process_info_t query,
+                             size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_PROCESS_INFO_NOTIFIER:
+      return get_info (value_size, value, process->m_notifier);
+    case AMD_DBGAPI_PROCESS_INFO_OS_ID:
+      return get_info (value_size, value, getpid ());
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_process_set_progress (amd_dbgapi_process_id_t process_id,
+                                 amd_dbgapi_progress_t progress)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+
+  if (progress == process->m_progress)
+    return AMD_DBGAPI_STATUS_SUCCESS;
+  process->m_progress = progress;
+
+  const auto now = std::chrono::steady_clock::now ();
+  if (progress == AMD_DBGAPI_PROGRESS_NO_FORWARD)
+    {
+      process->m_stop_cycle.emplace (stop_cycle_t{ now, now, {}, 0, 0, 0 });
+      process->m_first_stop.reset ();
+      return AMD_DBGAPI_STATUS_SUCCESS;
+    }
+
+  if (process->m_stop_cycle)
+    {
+      process->m_stop_cycle->m_end = now;
+      process->m_stop_cycle->m_outstanding_stops = std::count_if (
+          process->m_waves.begin (), process->m_waves.end (),
+          [] (auto &&wave) { return wave.m_stop_requested; });
+      g_last_stop_cycle = process->m_stop_cycle;
+      process->m_stop_cycle.reset ();
+      ++g_stop_cycle_count;
+      g_state_cv.notify_all ();
+    }
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_process_set_wave_creation (amd_dbgapi_process_id_t process_id,
+                                      amd_dbgapi_wave_creation_t creation)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!find_process (process_id))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_set_memory_precision (amd_dbgapi_process_id_t process_id,
+                                 amd_dbgapi_memory_precision_t precision)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!find_process (process_id))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+/* Events.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_process_next_pending_event (amd_dbgapi_process_id_t process_id,
+                                       amd_dbgapi_event_id_t *event_id,
+                                       amd_dbgapi_event_kind_t *kind)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  if (!event_id || !kind)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  if (process->m_pending_events.empty ())
+    {
+      *event_id = AMD_DBGAPI_EVENT_NONE;
+      *kind = AMD_DBGAPI_EVENT_KIND_NONE;
+      return AMD_DBGAPI_STATUS_SUCCESS;
+    }
+
+  event_t event = process->m_pending_events.front ();
+  process->m_pending_events.pop_front ();
+  process->m_reported_events.push_back (event);
+
+  *event_id = event.m_id;
+  *kind = event.m_kind;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_event_get_info (amd_dbgapi_event_id_t event_id,
+                           amd_dbgapi_event_info_t query, size_t value_size,
+                           void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  event_t *event = find_event (event_id);
+  if (!event)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_EVENT_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_EVENT_INFO_PROCESS:
+      return get_info (value_size, value, g_process->m_id);
+    case AMD_DBGAPI_EVENT_INFO_KIND:
+      return get_info (value_size, value, event->m_kind);
+    case AMD_DBGAPI_EVENT_INFO_RUNTIME_STATE:
+      if (event->m_kind != AMD_DBGAPI_EVENT_KIND_RUNTIME)
+        return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT_COMPATIBILITY;
+      return get_info (value_size, value, event->m_runtime_state);
+    case AMD_DBGAPI_EVENT_INFO_WAVE:
+      if (event->m_kind != AMD_DBGAPI_EVENT_KIND_WAVE_STOP
+          && event->m_kind != AMD_DBGAPI_EVENT_KIND_WAVE_COMMAND_TERMINATED)
+        return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT_COMPATIBILITY;
+      return get_info (value_size, value, event->m_wave);
+    case AMD_DBGAPI_EVENT_INFO_QUEUE:
+      if (event->m_kind != AMD_DBGAPI_EVENT_KIND_QUEUE_ERROR)
+        return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT_COMPATIBILITY;
+      return get_info (value_size, value, event->m_queue);
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_event_processed (amd_dbgapi_event_id_t event_id)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!g_process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_EVENT_ID;
+
+  auto &events = g_process->m_reported_events;
+  auto it = std::find_if (events.begin (), events.end (), [&] (auto &&event) {
+    return event.m_id.handle == event_id.handle;
+  });
+  if (it == events.end ())
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_EVENT_ID;
+
+  if (it->m_kind == AMD_DBGAPI_EVENT_KIND_WAVE_STOP)
+    if (wave_t *wave = find_wave (it->m_wave); wave && wave->m_stop_requested)
+      {
+        wave->m_stop_requested = false;
+        stop_event_processed (*g_process, *wave);
+        g_state_cv.notify_all ();
+      }
+
+  events.erase (it);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_report_breakpoint_hit (
+    amd_dbgapi_breakpoint_id_t breakpoint_id,
+    amd_dbgapi_client_thread_id_t client_thread_id,
+    amd_dbgapi_breakpoint_action_t *action)
+{
+  COUNT_CALL ();
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    if (!g_process
+        || g_process->m_rbrk_breakpoint_id.handle != breakpoint_id.handle)
+      return AMD_DBGAPI_STATUS_ERROR_INVALID_BREAKPOINT_ID;
+    if (!action)
+      return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+  }
+
+  spin_for (std::chrono::nanoseconds (
+      g_report_cost.load (std::memory_order_relaxed)));
+
+  *action = AMD_DBGAPI_BREAKPOINT_ACTION_RESUME;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+/* Code objects.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_process_code_object_list (
+    amd_dbgapi_process_id_t process_id, size_t *code_object_count,
+    amd_dbgapi_code_object_id_t **code_objects, amd_dbgapi_changed_t *changed)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  if (!code_object_count || !code_objects)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  if (changed)
+    {
+      *changed = process->m_code_object_list_changed
+                     ? AMD_DBGAPI_CHANGED_YES
+                     : AMD_DBGAPI_CHANGED_NO;
+      process->m_code_object_list_changed = false;
+      if (*changed == AMD_DBGAPI_CHANGED_NO)
+        return AMD_DBGAPI_STATUS_SUCCESS;
+    }
+
+  *code_object_count = process->m_code_objects.size ();
+  *code_objects = allocate_handles<amd_dbgapi_code_object_id_t> (
+      *code_object_count);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_code_object_get_info (amd_dbgapi_code_object_id_t code_object_id,
+                                 amd_dbgapi_code_object_info_t query,
+                                 size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  code_object_t *code_object
+      = find_object (&process_t::m_code_objects, code_object_id.handle);
+  if (!code_object)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_CODE_OBJECT_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_CODE_OBJECT_INFO_PROCESS:
+      return get_info (value_size, value, g_process->m_id);
+    case AMD_DBGAPI_CODE_OBJECT_INFO_URI_NAME:
+      return get_string_info (value_size, value, code_object->m_uri);
+    case AMD_DBGAPI_CODE_OBJECT_INFO_LOAD_ADDRESS:
+      return get_info (value_size, value,
+                       reinterpret_cast<amd_dbgapi_global_address_t> (
+                           code_object->m_code.data ()));
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+/* Agents and dispatches.  Each agent has one queue.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_agent_get_info (amd_dbgapi_agent_id_t agent_id,
+                           amd_dbgapi_agent_info_t query, size_t value_size,
+                           void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  agent_t *agent = find_object (&process_t::m_agents, agent_id.handle);
+  if (!agent)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_AGENT_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_AGENT_INFO_NAME:
+      return get_string_info (value_size, value, "gfx90a");
+    case AMD_DBGAPI_AGENT_INFO_OS_ID:
+      return get_info (value_size, value, agent->m_os_id);
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_queue_get_info (amd_dbgapi_queue_id_t queue_id,
+                           amd_dbgapi_queue_info_t query, size_t value_size,
+                           void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  agent_t *agent = find_object (&process_t::m_agents, queue_id.handle);
+  if (!agent)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_QUEUE_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_QUEUE_INFO_AGENT:
+      return get_info (value_size, value,
+                       amd_dbgapi_agent_id_t{ queue_id.handle });
+    case AMD_DBGAPI_QUEUE_INFO_ADDRESS:
+      /* The queues are not backed by any memory.  */
+      return get_info (value_size, value,
+                       amd_dbgapi_global_address_t{ queue_id.handle << 20 });
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_dispatch_get_info (amd_dbgapi_dispatch_id_t dispatch_id,
+                              amd_dbgapi_dispatch_info_t query,
+                              size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  dispatch_t *dispatch
+      = find_object (&process_t::m_dispatches, dispatch_id.handle);
+  if (!dispatch)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_DISPATCH_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_DISPATCH_INFO_QUEUE:
+      return get_info (value_size, value,
+                       amd_dbgapi_queue_id_t{ dispatch->m_agent + 1 });
+    case AMD_DBGAPI_DISPATCH_INFO_AGENT:
+      return get_info (value_size, value,
+                       amd_dbgapi_agent_id_t{ dispatch->m_agent + 1 });
+    case AMD_DBGAPI_DISPATCH_INFO_PROCESS:
+      return get_info (value_size, value, g_process->m_id);
+    case AMD_DBGAPI_DISPATCH_INFO_ARCHITECTURE:
+      return get_info (value_size, value, architecture_id);
+    case AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS:
+      return get_info (value_size, value, dispatch->m_kernel_entry);
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+/* Waves.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_process_wave_list (amd_dbgapi_process_id_t process_id,
+                              size_t *wave_count,
+                              amd_dbgapi_wave_id_t **waves,
+                              amd_dbgapi_changed_t *changed)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  if (!wave_count || !waves)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  if (changed)
+    {
+      *changed = process->m_wave_list_changed ? AMD_DBGAPI_CHANGED_YES
+                                              : AMD_DBGAPI_CHANGED_NO;
+      process->m_wave_list_changed = false;
+      if (*changed == AMD_DBGAPI_CHANGED_NO)
+        return AMD_DBGAPI_STATUS_SUCCESS;
+    }
+
+  *wave_count = process->m_waves.size ();
+  *waves = allocate_handles<amd_dbgapi_wave_id_t> (
+      *wave_count, process->m_first_wave_handle);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_wave_get_info (amd_dbgapi_wave_id_t wave_id,
+                          amd_dbgapi_wave_info_t query, size_t value_size,
+                          void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  wave_t *wave = find_wave (wave_id);
+  if (!wave)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+
+  const dispatch_t &dispatch = g_process->m_dispatches[wave->m_dispatch];
+  switch (query)
+    {
+    case AMD_DBGAPI_WAVE_INFO_STATE:
+      return get_info (value_size, value, wave->m_state);
+    case AMD_DBGAPI_WAVE_INFO_DISPATCH:
+      return get_info (value_size, value,
+                       amd_dbgapi_dispatch_id_t{ wave->m_dispatch + 1 });
+    case AMD_DBGAPI_WAVE_INFO_QUEUE:
+      return get_info (value_size, value,
+                       amd_dbgapi_queue_id_t{ dispatch.m_agent + 1 });
+    case AMD_DBGAPI_WAVE_INFO_AGENT:
+      return get_info (value_size, value,
+                       amd_dbgapi_agent_id_t{ dispatch.m_agent + 1 });
+    case AMD_DBGAPI_WAVE_INFO_PROCESS:
+      return get_info (value_size, value, g_process->m_id);
+    case AMD_DBGAPI_WAVE_INFO_ARCHITECTURE:
+      return get_info (value_size, value, architecture_id);
+    default:
+      break;
+    }
+
+  /* The other information is only available while the wave is
+     stopped.  */
+  if (wave->m_state != AMD_DBGAPI_WAVE_STATE_STOP)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_NOT_STOPPED;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_WAVE_INFO_STOP_REASON:
+      return get_info (value_size, value, wave->m_stop_reason);
+    case AMD_DBGAPI_WAVE_INFO_PC:
+      return get_info (value_size, value, wave->m_pc);
+    case AMD_DBGAPI_WAVE_INFO_EXEC_MASK:
+      return get_info (value_size, value, ~uint64_t{ 0 });
+    case AMD_DBGAPI_WAVE_INFO_LANE_COUNT:
+      return get_info (value_size, value, topology ().m_lanes);
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_wave_stop (amd_dbgapi_wave_id_t wave_id)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  wave_t *wave = find_wave (wave_id);
+  if (!wave)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+  if (wave->m_stop_requested)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_OUTSTANDING_STOP;
+  if (wave->m_state == AMD_DBGAPI_WAVE_STATE_STOP)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_STOPPED;
+
+  spin_for (topology ().m_stop_cost);
+
+  const auto now = std::chrono::steady_clock::now ();
+  process_t &process = *g_process;
+  if (process.m_stop_cycle && !process.m_first_stop)
+    process.m_first_stop.emplace (now);
+  if (process.m_stop_cycle)
+    ++process.m_stop_cycle->m_stopped_waves;
+
+  wave->m_stop_requested = true;
+  wave->m_stop_cycle = g_stop_cycle_count;
+
+  const std::chrono::nanoseconds latency
+      = wave->m_straggler ? topology ().m_straggler_latency
+                          : topology ().m_stop_latency;
+  if (!latency.count ())
+    {
+      /* A straggler without latency never stops.  */
+      if (!wave->m_straggler)
+        stop_wave (process, *wave, wave_id);
+      return AMD_DBGAPI_STATUS_SUCCESS;
+    }
+
+  process.m_pending_stops.emplace (now + latency, wave_id);
+  g_stopper.notify ();
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_wave_resume (amd_dbgapi_wave_id_t wave_id,
+                        amd_dbgapi_resume_mode_t resume_mode,
+                        amd_dbgapi_exceptions_t exceptions)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  wave_t *wave = find_wave (wave_id);
+  if (!wave)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+  if (wave->m_state != AMD_DBGAPI_WAVE_STATE_STOP)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_NOT_STOPPED;
+  if (wave->m_stop_requested)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_OUTSTANDING_STOP;
+
+  wave->m_state = AMD_DBGAPI_WAVE_STATE_RUN;
+  wave->m_stop_reason = AMD_DBGAPI_WAVE_STOP_REASON_NONE;
+  if (g_process->m_stop_cycle)
+    ++g_process->m_stop_cycle->m_resumed_waves;
+  g_state_cv.notify_all ();
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+/* Architectures and registers.  The registers are numbered from 1 in the
+   order of g_registers, and the register classes in the order of
+   register_class_t.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_architecture_get_info (
+    amd_dbgapi_architecture_id_t architecture_id,
+    amd_dbgapi_architecture_info_t query, size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  if (architecture_id.handle != ::architecture_id.handle)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARCHITECTURE_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_ARCHITECTURE_INFO_NAME:
+      {
+        std::lock_guard<std::mutex> lock (g_mutex);
+        return get_string_info (value_size, value,
+                                "amdgcn-amd-amdhsa--gfx90a");
+      }
+    case AMD_DBGAPI_ARCHITECTURE_INFO_ELF_AMDGPU_MACHINE:
+      return get_info (value_size, value, uint32_t{ 0x3f });
+    case AMD_DBGAPI_ARCHITECTURE_INFO_LARGEST_INSTRUCTION_SIZE:
+      return get_info (value_size, value,
+                       amd_dbgapi_size_t{ largest_instruction_size });
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_architecture_register_class_list (
+    amd_dbgapi_architecture_id_t architecture_id, size_t *register_class_count,
+    amd_dbgapi_register_class_id_t **register_classes)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (architecture_id.handle != ::architecture_id.handle)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARCHITECTURE_ID;
+  if (!register_class_count || !register_classes)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  *register_class_count = register_class_number;
+  *register_classes = allocate_handles<amd_dbgapi_register_class_id_t> (
+      register_class_number);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_architecture_register_class_get_info (
+    amd_dbgapi_register_class_id_t register_class_id,
+    amd_dbgapi_register_class_info_t query, size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (register_class_id.handle == 0
+      || register_class_id.handle > register_class_number)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_REGISTER_CLASS_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_REGISTER_CLASS_INFO_ARCHITECTURE:
+      return get_info (value_size, value, architecture_id);
+    case AMD_DBGAPI_REGISTER_CLASS_INFO_NAME:
+      return get_string_info (
+          value_size, value,
+          register_class_names[register_class_id.handle - 1]);
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_wave_register_list (amd_dbgapi_wave_id_t wave_id,
+                               size_t *register_count,
+                               amd_dbgapi_register_id_t **registers)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  if (!find_wave (wave_id))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+  if (!register_count || !registers)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  *register_count = g_registers.size ();
+  *registers = allocate_handles<amd_dbgapi_register_id_t> (*register_count);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_register_is_in_register_class (
+    amd_dbgapi_register_class_id_t register_class_id,
+    amd_dbgapi_register_id_t register_id,
+    amd_dbgapi_register_class_state_t *register_class_state)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  register_desc_t *reg = find_object (g_registers, register_id.handle);
+  if (!reg)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_REGISTER_ID;
+  if (register_class_id.handle == 0
+      || register_class_id.handle > register_class_number)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_REGISTER_CLASS_ID;
+  if (!register_class_state)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  const size_t class_index = register_class_id.handle - 1;
+  *register_class_state = class_index == register_class_general
+                                  || class_index == reg->m_class
+                              ? AMD_DBGAPI_REGISTER_CLASS_STATE_MEMBER
+                              : AMD_DBGAPI_REGISTER_CLASS_STATE_NOT_MEMBER;
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_register_get_info (amd_dbgapi_register_id_t register_id,
+                              amd_dbgapi_register_info_t query,
+                              size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  register_desc_t *reg = find_object (g_registers, register_id.handle);
+  if (!reg)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_REGISTER_ID;
+
+  switch (query)
+    {
+    case AMD_DBGAPI_REGISTER_INFO_ARCHITECTURE:
+      return get_info (value_size, value, architecture_id);
+    case AMD_DBGAPI_REGISTER_INFO_NAME:
+      return get_string_info (value_size, value, reg->m_name);
+    case AMD_DBGAPI_REGISTER_INFO_TYPE:
+      return get_string_info (value_size, value, reg->m_type);
+    case AMD_DBGAPI_REGISTER_INFO_SIZE:
+      return get_info (value_size, value, amd_dbgapi_size_t{ reg->m_size });
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_NOT_IMPLEMENTED;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_read_register (amd_dbgapi_wave_id_t wave_id,
+                          amd_dbgapi_register_id_t register_id,
+                          amd_dbgapi_size_t offset,
+                          amd_dbgapi_size_t value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  wave_t *wave = find_wave (wave_id);
+  if (!wave)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+  register_desc_t *reg = find_object (g_registers, register_id.handle);
+  if (!reg)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_REGISTER_ID;
+  if (!value || !value_size || offset + value_size > reg->m_size)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+  if (wave->m_state != AMD_DBGAPI_WAVE_STATE_STOP)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_NOT_STOPPED;
+
+  /* The pc and exec registers have their real values, the others a pattern
+     derived from the wave and the register.  */
+  std::vector<uint8_t> contents (reg->m_size);
+  if (reg->m_name == "pc")
+    memcpy (contents.data (), &wave->m_pc, sizeof (wave->m_pc));
+  else if (reg->m_name == "exec")
+    memset (contents.data (), 0xff, contents.size ());
+  else
+    for (size_t i = 0; i < contents.size (); i += sizeof (uint32_t))
+      {
+        const uint32_t word = (wave_id.handle << 20)
+                              ^ (register_id.handle << 8) ^ (i / 4);
+        memcpy (&contents[i], &word, sizeof (word));
+      }
+
+  memcpy (value, &contents[offset], value_size);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+/* Memory.  The global memory of the process is the memory of the client
+   process.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_dwarf_address_space_to_address_space (
+    amd_dbgapi_architecture_id_t architecture_id,
+    uint64_t dwarf_address_space,
+    amd_dbgapi_address_space_id_t *address_space_id)
+{
+  COUNT_CALL ();
+  if (architecture_id.handle != ::architecture_id.handle)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARCHITECTURE_ID;
+  if (!address_space_id)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  switch (dwarf_address_space)
+    {
+    case 0x0: /* DW_ASPACE_AMDGPU_generic  */
+      *address_space_id = AMD_DBGAPI_ADDRESS_SPACE_GLOBAL;
+      return AMD_DBGAPI_STATUS_SUCCESS;
+    case 0x3: /* DW_ASPACE_AMDGPU_local  */
+      *address_space_id = local_address_space;
+      return AMD_DBGAPI_STATUS_SUCCESS;
+    default:
+      return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+}
+
+amd_dbgapi_status_t
+amd_dbgapi_read_memory (amd_dbgapi_process_id_t process_id,
+                        amd_dbgapi_wave_id_t wave_id,
+                        amd_dbgapi_lane_id_t lane_id,
+                        amd_dbgapi_address_space_id_t address_space_id,
+                        amd_dbgapi_segment_address_t segment_address,
+                        amd_dbgapi_size_t *value_size, void *value)
+{
+  COUNT_CALL ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  process_t *process = find_process (process_id);
+  if (!process)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_PROCESS_ID;
+  if (!value_size || !value)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  if (address_space_id.handle == AMD_DBGAPI_ADDRESS_SPACE_GLOBAL.handle)
+    return g_callbacks->xfer_global_memory (process->m_client_process_id,
+                                            segment_address, value_size,
+                                            value, nullptr);
+
+  if (address_space_id.handle != local_address_space.handle)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ADDRESS_SPACE_ID;
+
+  /* The local memory is shared by the waves of a workgroup, it is read
+     through one of them.  */
+  wave_t *wave = find_wave (wave_id);
+  if (!wave)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID;
+  if (wave->m_state != AMD_DBGAPI_WAVE_STATE_STOP)
+    return AMD_DBGAPI_STATUS_ERROR_WAVE_NOT_STOPPED;
+
+  const size_t lds_size = topology ().m_lds_size;
+  if (segment_address >= lds_size)
+    return AMD_DBGAPI_STATUS_ERROR_MEMORY_ACCESS;
+
+  *value_size = std::min<amd_dbgapi_size_t> (*value_size,
+                                             lds_size - segment_address);
+  auto *bytes = static_cast<uint8_t *> (value);
+  for (size_t i = 0; i < *value_size; ++i)
+    bytes[i] = static_cast<uint8_t> (wave_id.handle + segment_address + i);
+  return AMD_DBGAPI_STATUS_SUCCESS;
+}
+
+/* Disassembly.  The instructions are 32-bit words, every eighth one is a
+   branch whose target is symbolized.  */
+
+amd_dbgapi_status_t
+amd_dbgapi_disassemble_instruction (
+    amd_dbgapi_architecture_id_t architecture_id,
+    amd_dbgapi_global_address_t address, amd_dbgapi_size_t *size,
+    const void *memory, char **instruction_text,
+    amd_dbgapi_symbolizer_id_t symbolizer_id,
+    amd_dbgapi_status_t (*symbolizer) (
+        amd_dbgapi_symbolizer_id_t symbolizer_id,
+        amd_dbgapi_global_address_t address, char **symbol_text))
+{
+  COUNT_CALL ();
+  if (architecture_id.handle != ::architecture_id.handle)
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARCHITECTURE_ID;
+  if (!size || !memory || *size < sizeof (uint32_t))
+    return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
+
+  uint32_t word;
+  memcpy (&word, memory, sizeof (word));
+  *size = sizeof (uint32_t);
+
+  if (!instruction_text)
+    return AMD_DBGAPI_STATUS_SUCCESS;
+
+  char text[128];
+  if ((word & 7) == 7)
+    {
+      const amd_dbgapi_global_address_t target = address - 4 * (word & 0xf8);
+      std::string target_text = std::to_string (target);
+      if (symbolizer)
+        {
+          char *symbol_text;
+          if (symbolizer (symbolizer_id, target, &symbol_text)
+              == AMD_DBGAPI_STATUS_SUCCESS)
+            {
+              target_text = symbol_text;
+              free (symbol_text);
+            }
+        }
+      snprintf (text, sizeof (text), "s_cbranch_execz %s",
+                target_text.c_str ());
+    }
+  else
+    snprintf (text, sizeof (text), "v_add_f32_e32 v%u, v%u, v%u",
+              word & 0xff, (word >> 8) & 0xff, (word >> 16) & 0xff);
+
+  std::lock_guard<std::mutex> lock (g_mutex);
+  *instruction_text = allocate_string (text);
+  return *instruction_text ? AMD_DBGAPI_STATUS_SUCCESS
+                           : AMD_DBGAPI_STATUS_ERROR_CLIENT_CALLBACK;
+}
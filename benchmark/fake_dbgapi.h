@@ -0,0 +1,163 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+
+#ifndef _ROCM_DEBUG_AGENT_FAKE_DBGAPI_H
+#define _ROCM_DEBUG_AGENT_FAKE_DBGAPI_H 1
+
+#include <amd-dbgapi/amd-dbgapi.h>
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* The fake-amd-dbgapi library stands in for the ROCdbgapi library, so that
+   the ROCdebug-agent can be loaded and driven by the benchmarks without a
+   GPU.  It implements the part of the dbgapi interface used by the agent on
+   a synthetic process, whose topology is set by the functions below.  They
+   control it from the benchmark, from any thread.  */
+
+namespace fake_dbgapi
+{
+
+/* The agents of the synthetic process, the waves of their dispatches, and
+   the code objects containing the kernels the waves execute.  */
+
+struct topology_t
+{
+  size_t m_agents{ 1 };
+  size_t m_waves_per_agent{ 64 };
+  size_t m_dispatches_per_agent{ 1 };
+  size_t m_code_objects{ 1 };
+  size_t m_kernels_per_code_object{ 4 };
+  /* The size of the code of each kernel, in bytes.  */
+  size_t m_kernel_size{ 1024 };
+  /* The waves stopped by raise_exceptions, spread over the agents, and the
+     stop reasons given to them in turn.  */
+  size_t m_faulting_waves{ 1 };
+  std::vector<amd_dbgapi_wave_stop_reasons_t> m_stop_reasons{
+    AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION
+  };
+  /* The registers of each wave.  */
+  size_t m_sgprs{ 104 };
+  size_t m_vgprs{ 256 };
+  size_t m_lanes{ 64 };
+  /* The size of the local memory of each wave, in bytes.  */
+  size_t m_lds_size{ 4096 };
+  /* The time spent in amd_dbgapi_wave_stop, for each wave stopped.  */
+  std::chrono::nanoseconds m_stop_cost{ 0 };
+  /* The time a wave takes to stop after amd_dbgapi_wave_stop returns, and
+     to report its stop event.  The waves stop in amd_dbgapi_wave_stop if it
+     is zero.  */
+  std::chrono::microseconds m_stop_latency{ 0 };
+  /* The number of waves, the last ones of the process, which take
+     m_straggler_latency to stop instead, or never stop if it is zero.  */
+  size_t m_stragglers{ 0 };
+  std::chrono::milliseconds m_straggler_latency{ 0 };
+};
+
+/* Parse a topology from a list of comma-separated KEY=VALUE settings of the
+   members of topology_t, for example "agents=4,waves=1024,faulting=8".
+   The stop reasons are separated by '+', and the durations are given in
+   the unit at the end of their key (stop-cost-ns, stop-latency-us and
+   straggler-latency-ms).  Return nullopt if SPEC is invalid.  */
+std::optional<topology_t> parse_topology (const std::string &spec);
+
+/* Set the topology of the process.  The topology is read from the
+   FAKE_DBGAPI_TOPOLOGY environment variable by the attach if it was never
+   set.  Changing the topology of an attached process replaces all its
+   waves and code objects, none of its waves must be stopped.  */
+void set_topology (const topology_t &topology);
+
+/* Wait until the process is attached, or until TIMEOUT expires.  Return the
+   time at which amd_dbgapi_process_attach returned, or nullopt if the
+   process was not attached in time.  */
+std::optional<std::chrono::steady_clock::time_point>
+wait_for_attach (std::chrono::milliseconds timeout);
+
+/* Simulate the cost of amd_dbgapi_report_breakpoint_hit, which reads the
+   code object list of the process, by spinning for COST per report.  */
+void set_report_cost (std::chrono::nanoseconds cost);
+
+/* Stop the faulting waves that are running, and report their stop events.
+   Return the number of waves stopped.  */
+size_t raise_exceptions ();
+
+/* Report a queue error on the queue of the first agent.  */
+void raise_queue_error ();
+
+/* A stop cycle lasts from the time the forward progress of the process is
+   disabled until it is enabled again, the agent prints the waves during a
+   stop cycle.  */
+
+struct stop_cycle_t
+{
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::time_point m_end;
+  /* From the first amd_dbgapi_wave_stop to the processing of the last stop
+     event caused by the stops requested during the cycle, if waves were
+     stopped.  */
+  std::optional<std::chrono::nanoseconds> m_stop_latency;
+  size_t m_stopped_waves;
+  size_t m_resumed_waves;
+  /* The waves whose stop was requested, but not reported yet, at the end of
+     the cycle.  */
+  size_t m_outstanding_stops;
+};
+
+/* Return the number of stop cycles completed since the library was
+   loaded.  */
+size_t stop_cycle_count ();
+
+/* Wait until COUNT stop cycles are completed, or until TIMEOUT expires.
+   Return the last stop cycle completed, or nullopt if there were fewer than
+   COUNT in time.  */
+std::optional<stop_cycle_t>
+wait_for_stop_cycle (size_t count, std::chrono::milliseconds timeout);
+
+/* Wait until the waves are running and none of their stops is outstanding,
+   or until TIMEOUT expires.  The stragglers that never stop are ignored.
+   Return the number of waves that are still stopped or stopping.  */
+size_t wait_for_running_waves (std::chrono::milliseconds timeout);
+
+/* Return the number of calls made to the dbgapi FUNCTION, or to all the
+   functions if FUNCTION is null, since the library was loaded.  */
+size_t call_count (const char *function = nullptr);
+
+/* Return the number of calls made to each dbgapi function called at least
+   once, sorted by name.  */
+std::vector<std::pair<std::string, size_t>> call_counts ();
+
+} /* namespace fake_dbgapi */
+
+#endif /* _ROCM_DEBUG_AGENT_FAKE_DBGAPI_H */
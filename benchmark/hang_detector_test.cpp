@@ -0,0 +1,195 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* Check that hang_detector_t reports the waits that last longer than its
+   threshold, including the waits of a thread that polls a signal with a
+   short timeout, but not the thread that does other work after a wait
+   timed out.  It does not need a GPU, the waits are simulated by sleeping
+   between begin_wait and end_wait.  */
+
+#include "hang_detector.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace amd::debug_agent;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+constexpr auto threshold = 50ms;
+constexpr uint64_t test_signal = 0x1000;
+constexpr uint64_t other_signal = 0x2000;
+
+int failures = 0;
+
+#define CHECK(condition)                                                      \
+  do                                                                          \
+    {                                                                         \
+      if (!(condition))                                                       \
+        {                                                                     \
+          fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,  \
+                   #condition);                                               \
+          ++failures;                                                         \
+        }                                                                     \
+    }                                                                         \
+  while (0)
+
+/* Wait on SIGNAL for DURATION, then time out.  */
+
+void
+timed_out_wait (hang_detector_t &detector, uint64_t signal,
+      std::chrono::milliseconds duration)
+{
+  detector.begin_wait (signal);
+  std::this_thread::sleep_for (duration);
+  detector.end_wait (false);
+}
+
+void
+test_satisfied_wait ()
+{
+  hang_detector_t detector (threshold);
+
+  detector.begin_wait (test_signal);
+  detector.end_wait (true);
+  std::this_thread::sleep_for (threshold * 2);
+  CHECK (detector.check ().empty ());
+
+  detector.begin_wait (test_signal);
+  std::this_thread::sleep_for (threshold * 2);
+  auto hangs = detector.check ();
+  CHECK (hangs.size () == 1);
+  CHECK (hangs.size () == 1 && hangs[0].m_signal == test_signal);
+  CHECK (hangs.size () == 1 && hangs[0].m_duration >= threshold);
+
+  /* A wait is only reported once.  */
+  CHECK (detector.check ().empty ());
+  detector.end_wait (true);
+}
+
+/* A thread polling the signal right after each timeout is one long
+   wait.  */
+
+void
+test_timeout_then_continue ()
+{
+  hang_detector_t detector (threshold);
+
+  const auto end = std::chrono::steady_clock::now () + threshold * 2;
+  while (std::chrono::steady_clock::now () < end)
+    timed_out_wait (detector, test_signal, 5ms);
+
+  detector.begin_wait (test_signal);
+  auto hangs = detector.check ();
+  CHECK (hangs.size () == 1);
+  CHECK (hangs.size () == 1 && hangs[0].m_duration >= threshold * 2);
+  detector.end_wait (true);
+}
+
+/* A thread that does other work between its polls for longer than they
+   last starts a new wait with each poll.  */
+
+void
+test_timeout_then_work ()
+{
+  hang_detector_t detector (threshold);
+
+  const auto end = std::chrono::steady_clock::now () + threshold * 2;
+  while (std::chrono::steady_clock::now () < end)
+    {
+      timed_out_wait (detector, test_signal, 1ms);
+      std::this_thread::sleep_for (10ms);
+    }
+
+  detector.begin_wait (test_signal);
+  CHECK (detector.check ().empty ());
+  detector.end_wait (true);
+}
+
+/* A thread is not waiting after its wait timed out, until it waits
+   again.  */
+
+void
+test_timeout_then_idle ()
+{
+  hang_detector_t detector (threshold);
+
+  timed_out_wait (detector, test_signal, 5ms);
+  std::this_thread::sleep_for (threshold * 2);
+  CHECK (detector.check ().empty ());
+
+  /* The next wait starts anew, it does not continue the one that timed
+     out long ago.  */
+  detector.begin_wait (test_signal);
+  CHECK (detector.check ().empty ());
+  detector.end_wait (true);
+}
+
+/* A wait on another signal does not continue the wait that timed out.  */
+
+void
+test_timeout_then_other_signal ()
+{
+  hang_detector_t detector (threshold);
+
+  const auto end = std::chrono::steady_clock::now () + threshold * 2;
+  for (uint64_t s = test_signal; std::chrono::steady_clock::now () < end;
+       s = s == test_signal ? other_signal : test_signal)
+    timed_out_wait (detector, s, 5ms);
+
+  detector.begin_wait (test_signal);
+  CHECK (detector.check ().empty ());
+  detector.end_wait (true);
+}
+
+} /* namespace */
+
+int
+main ()
+{
+  test_satisfied_wait ();
+  test_timeout_then_continue ();
+  test_timeout_then_work ();
+  test_timeout_then_idle ();
+  test_timeout_then_other_signal ();
+
+  if (failures)
+    {
+      fprintf (stderr, "%d checks failed\n", failures);
+      return 1;
+    }
+
+  printf ("all checks passed\n");
+  return 0;
+}
@@ -130,6 +130,28 @@ code_object_t::find_symbol (amd_dbgapi_global_address_t address)
   return {};
 }
 
+std::optional<code_object_t::line_info_t>
+code_object_t::find_line (amd_dbgapi_global_address_t address)
+{
+  /* Load the line number table, and low/high pc for all CUs.  */
+  load_debug_info ();
+
+  /* Only use the line number table if ADDRESS is in one of the CUs, the
+     preceding line could belong to another CU otherwise.  */
+  if (auto it = m_pc_ranges_map->upper_bound (address);
+      it == m_pc_ranges_map->begin () || address >= std::prev (it)->second)
+    return {};
+
+  if (auto it = m_line_number_map->upper_bound (address);
+      it != m_line_number_map->begin ())
+    {
+      auto &&[file_name, line_number] = std::prev (it)->second;
+      return line_info_t{ file_name, line_number };
+    }
+
+  return {};
+}
+
 void
 code_object_t::open ()
 {
@@ -434,7 +456,7 @@ code_object_t::load_debug_info ()
       /* dwarf_ranges returns a single contiguous range
          (DW_AT_low_pc/DW_AT_high_pc), or a series of non-contiguous ranges
          (DW_AT_ranges). */
-      while ((offset = dwarf_ranges (&die, offset, &base, &start, &end) > 0))
+      while ((offset = dwarf_ranges (&die, offset, &base, &start, &end)) > 0)
         m_pc_ranges_map->emplace (m_load_address + start,
                                   m_load_address + end);
 
@@ -463,7 +485,7 @@ code_object_t::load_debug_info ()
     }
 }
 
-void
+disassembly_t
 code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
                             amd_dbgapi_global_address_t pc)
 {
@@ -530,16 +552,19 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
 
   auto symbol = find_symbol (pc);
 
-  agent_out << std::endl << "Disassembly";
+  disassembly_t disassembly;
   if (symbol)
-    agent_out << " for function " << symbol->m_name;
-  agent_out << ":" << std::endl;
+    {
+      disassembly.m_function_name.emplace (symbol->m_name);
+      disassembly.m_function_address.emplace (symbol->m_value);
+    }
+  disassembly.m_uri = m_uri;
+  disassembly.m_load_address = m_load_address;
+  disassembly.m_mem_size = m_mem_size;
+  disassembly.m_pc = pc;
 
-  agent_out << "    code object: " << m_uri << std::endl;
-  agent_out << "    loaded at: "
-            << "[0x" << std::hex << m_load_address << "-"
-            << "0x" << std::hex << (m_load_address + m_mem_size) << "]"
-            << std::endl;
+  auto &lines = disassembly.m_lines;
+  using kind_t = disassembly_line_t::kind_t;
 
   /* Remember the start_pc address to print the first source line.  */
   amd_dbgapi_global_address_t saved_start_pc{ start_pc };
@@ -583,10 +608,10 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
           size_t line_number = it->second.second;
 
           if (file_name != prev_file_name || line_number != prev_line_number)
-            agent_out << std::endl;
+            lines.push_back ({ kind_t::blank, 0, {} });
 
           if (file_name != prev_file_name)
-            agent_out << file_name << ":" << std::endl;
+            lines.push_back ({ kind_t::file, 0, file_name });
 
           /* If the source line for `addr` is a different line than the
              previous one printed, then print it.  If the previous line printed
@@ -630,15 +655,15 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
 
               for (size_t line = first_line; line <= last_line; ++line)
                 {
-                  agent_out << std::setfill (' ') << std::setw (8) << std::left
-                            << std::dec << line;
+                  std::string text;
 
-                  if (auto lines = get_source_file_index (file_name); !lines)
-                    agent_out << file_name << ": No such file or directory.";
-                  else if (line && line <= lines->get ().size ())
-                    agent_out << lines->get ()[line - 1];
+                  if (auto source = get_source_file_index (file_name);
+                      !source)
+                    text = file_name + ": No such file or directory.";
+                  else if (line && line <= source->get ().size ())
+                    text = source->get ()[line - 1];
 
-                  agent_out << std::endl;
+                  lines.push_back ({ kind_t::source, line, std::move (text) });
                 }
             }
 
@@ -649,7 +674,7 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
              block, then print ... to show that the following instruction is
              not the first in the block.  */
           if (addr == start_pc && start_pc != saved_start_pc)
-            agent_out << "    ..." << std::endl;
+            lines.push_back ({ kind_t::ellipsis, 0, {} });
         }
 
       std::vector<uint8_t> buffer (largest_instruction_size);
@@ -660,8 +685,7 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
               AMD_DBGAPI_ADDRESS_SPACE_GLOBAL, addr, &size, buffer.data ())
           != AMD_DBGAPI_STATUS_SUCCESS)
         {
-          agent_out << "Cannot access memory at address 0x" << std::hex << addr
-                    << std::endl;
+          lines.push_back ({ kind_t::memory_error, addr, {} });
           break;
         }
 
@@ -691,24 +715,9 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
           != AMD_DBGAPI_STATUS_SUCCESS)
         agent_error ("amd_dbgapi_disassemble_instruction failed");
 
-      std::string instruction (value);
+      lines.push_back ({ kind_t::instruction, addr, value });
       free (value);
 
-      agent_out << ((addr == pc) ? " => " : "    ");
-
-      agent_out << "0x" << std::hex << addr;
-      if (symbol)
-        {
-          agent_out << " <";
-          if (addr >= symbol->m_value)
-            agent_out << "+" << std::dec << (addr - symbol->m_value);
-          else
-            agent_out << "-" << std::dec << (symbol->m_value - addr);
-          agent_out << ">";
-        }
-
-      agent_out << ":    " << instruction << std::endl;
-
       addr += size;
     }
 
@@ -718,9 +727,9 @@ code_object_t::disassemble (amd_dbgapi_architecture_id_t architecture_id,
      printed.  */
   if (auto it = m_line_number_map->find (addr);
       it == m_line_number_map->end ())
-    agent_out << "    ..." << std::endl;
+    lines.push_back ({ kind_t::ellipsis, 0, {} });
 
-  agent_out << std::endl << "End of disassembly." << std::endl;
+  return disassembly;
 }
 
 bool
@@ -31,6 +31,8 @@
 #ifndef _ROCM_DEBUG_AGENT_CODE_OBJECT_H
 #define _ROCM_DEBUG_AGENT_CODE_OBJECT_H 1
 
+#include "dump.h"
+
 #include <amd-dbgapi/amd-dbgapi.h>
 
 #include <cstddef>
@@ -52,6 +54,12 @@ private:
     amd_dbgapi_size_t m_size;
   };
 
+  struct line_info_t
+  {
+    const std::string m_file_name;
+    size_t m_line_number;
+  };
+
   void load_symbol_map ();
   void load_debug_info ();
 
@@ -66,12 +74,17 @@ public:
 
   amd_dbgapi_global_address_t load_address () const { return m_load_address; }
   amd_dbgapi_size_t mem_size () const { return m_mem_size; }
+  const std::string &uri () const { return m_uri; }
 
   std::optional<symbol_info_t>
   find_symbol (amd_dbgapi_global_address_t address);
 
-  void disassemble (amd_dbgapi_architecture_id_t architecture_id,
-                    amd_dbgapi_global_address_t pc);
+  /* Return the source line of the instruction at ADDRESS, if the code object
+     has line number information for it.  */
+  std::optional<line_info_t> find_line (amd_dbgapi_global_address_t address);
+
+  disassembly_t disassemble (amd_dbgapi_architecture_id_t architecture_id,
+                             amd_dbgapi_global_address_t pc);
 
   bool save (const std::string &directory) const;
 
@@ -0,0 +1,157 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "command_queue.h"
+
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+long
+futex (std::atomic<uint32_t> *address, int op, uint32_t value)
+{
+  static_assert (sizeof (std::atomic<uint32_t>) == sizeof (uint32_t));
+  return syscall (SYS_futex, reinterpret_cast<uint32_t *> (address), op,
+                  value, nullptr, nullptr, 0);
+}
+
+} /* namespace */
+
+void
+completion_t::wait ()
+{
+  while (!m_done.load (std::memory_order_acquire))
+    futex (&m_done, FUTEX_WAIT_PRIVATE, 0);
+}
+
+void
+completion_t::signal ()
+{
+  m_done.store (1, std::memory_order_release);
+  futex (&m_done, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+command_t command_queue_t::s_closed{ command_kind_t::stop };
+
+bool
+command_queue_t::open ()
+{
+  if (m_event_fd == -1)
+    m_event_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  if (m_event_fd == -1)
+    return false;
+
+  command_t *expected = &s_closed;
+  m_head.compare_exchange_strong (expected, nullptr,
+                                  std::memory_order_acq_rel);
+  return true;
+}
+
+command_t *
+command_queue_t::close ()
+{
+  return exchange (&s_closed);
+}
+
+bool
+command_queue_t::push (command_t &command)
+{
+  command_t *head = m_head.load (std::memory_order_relaxed);
+  do
+    {
+      if (head == &s_closed)
+        return false;
+      command.m_next = head;
+    }
+  while (!m_head.compare_exchange_weak (head, &command,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+
+  /* Only the first command pushed after the consumer took the pending ones
+     needs to wake it up.  */
+  if (!head)
+    {
+      uint64_t value = 1;
+      while (write (m_event_fd, &value, sizeof (value)) == -1
+             && errno == EINTR)
+        ;
+    }
+
+  return true;
+}
+
+command_t *
+command_queue_t::take_all ()
+{
+  /* Reset the eventfd before taking the commands, a command pushed after
+     this point signals it again.  */
+  uint64_t value;
+  while (read (m_event_fd, &value, sizeof (value)) == -1 && errno == EINTR)
+    ;
+
+  return exchange (nullptr);
+}
+
+command_t *
+command_queue_t::exchange (command_t *new_head)
+{
+  command_t *head = m_head.load (std::memory_order_relaxed);
+  do
+    if (head == &s_closed)
+      return nullptr;
+  while (!m_head.compare_exchange_weak (head, new_head,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed));
+
+  /* The stack is in the reverse order of the pushes.  */
+  command_t *commands = nullptr;
+  while (head)
+    {
+      command_t *next = head->m_next;
+      head->m_next = commands;
+      commands = head;
+      head = next;
+    }
+
+  return commands;
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,133 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_COMMAND_QUEUE_H
+#define _ROCM_DEBUG_AGENT_COMMAND_QUEUE_H 1
+
+#include <atomic>
+#include <cstdint>
+
+namespace amd::debug_agent
+{
+
+/* A slot where the worker thread signals the completion of a command.  The
+   requesting thread sleeps on a futex until the slot is signaled, without
+   taking any lock.  */
+
+class completion_t
+{
+public:
+  /* Wait until the command is complete.  */
+  void wait ();
+
+  /* Mark the command complete and wake up the waiting thread.  The slot must
+     not be accessed by the worker thread after this call, it may be
+     destroyed as soon as the waiting thread returns.  */
+  void signal ();
+
+private:
+  std::atomic<uint32_t> m_done{ 0 };
+};
+
+enum class command_kind_t
+{
+  /* Print all the wavefronts.  */
+  print_waves,
+  /* Report the code object list updates to dbgapi.  */
+  update_code_objects,
+  /* Exit the worker thread's event loop.  */
+  stop,
+};
+
+/* A request sent to the worker thread.  Commands are owned by the requesting
+   thread, which usually allocates them on its stack and waits for their
+   completion.  */
+
+struct command_t
+{
+  command_kind_t m_kind;
+  /* Signaled when the command is complete, if not null.  */
+  completion_t *m_completion{ nullptr };
+  /* The next command in the queue.  */
+  command_t *m_next{ nullptr };
+};
+
+/* A lock-free multiple producer, single consumer queue of commands.  The
+   producers push commands on a lock-free stack and signal an eventfd when
+   the stack was empty.  The consumer waits for the eventfd to be readable
+   and takes all the pending commands at once.
+
+   Pushing a command does not allocate memory or take a lock, so it is
+   async-signal-safe.  */
+
+class command_queue_t
+{
+public:
+  command_queue_t () = default;
+
+  command_queue_t (const command_queue_t &) = delete;
+  command_queue_t &operator= (const command_queue_t &) = delete;
+
+  /* Start accepting commands.  Return false if the eventfd could not be
+     created.  The queue is closed until it is opened.  The eventfd is never
+     closed, a producer may still be signaling it after the queue is closed,
+     and the queue may be used by the HSA hooks until the process exits.  */
+  bool open ();
+
+  /* Stop accepting commands, and return the pending commands in the order
+     they were pushed.  */
+  command_t *close ();
+
+  /* The file descriptor that is readable when commands are pending.  */
+  int fd () const { return m_event_fd; }
+
+  /* Push COMMAND at the end of the queue.  Return false if the queue is
+     closed, the command is not queued in that case.  */
+  bool push (command_t &command);
+
+  /* Return the pending commands in the order they were pushed, or nullptr if
+     there are none.  */
+  command_t *take_all ();
+
+private:
+  /* Take the pending commands, and replace them with NEW_HEAD.  */
+  command_t *exchange (command_t *new_head);
+
+  /* A sentinel head marking a closed queue.  */
+  static command_t s_closed;
+
+  /* The last pushed command, linked to the previous ones.  */
+  std::atomic<command_t *> m_head{ &s_closed };
+  int m_event_fd{ -1 };
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_COMMAND_QUEUE_H */
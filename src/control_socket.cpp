@@ -0,0 +1,343 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "control_socket.h"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <streambuf>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+/* The longest request accepted from a client.  */
+constexpr size_t max_request_size = 4096;
+
+/* The most connections waiting for their request to be complete.  */
+constexpr size_t max_connections = 16;
+
+/* How long a reply may wait for a client that does not read it.  */
+constexpr time_t send_timeout_seconds = 5;
+
+/* The most output of a handler kept before it is sent to the client.  */
+constexpr size_t reply_buffer_size = 64 * 1024;
+
+/* Send SIZE bytes at DATA to the client FD.  Return false if the client
+   closed the connection or stopped reading.  */
+bool
+send_all (int fd, const char *data, size_t size)
+{
+  while (size != 0)
+    {
+      ssize_t sent = send (fd, data, size, MSG_NOSIGNAL);
+      if (sent == -1 && errno == EINTR)
+        continue;
+      if (sent == -1)
+        return false;
+      data += sent;
+      size -= sent;
+    }
+  return true;
+}
+
+/* A stream buffer that sends the output of a handler to the client as it is
+   produced, so that a large reply is never held in memory.  The flushes are
+   ignored, the output is sent when the buffer is full and when the reply
+   ends, so that a dump does not make a system call for each record.  Once a
+   send fails, the rest of the output is dropped.  */
+
+class reply_buffer_t : public std::streambuf
+{
+public:
+  explicit reply_buffer_t (int fd) : m_fd (fd)
+  {
+    setp (m_buffer, m_buffer + sizeof (m_buffer));
+  }
+
+  /* Send the output that is still buffered.  */
+  void finish () { send_buffer (); }
+
+protected:
+  int_type overflow (int_type c) override
+  {
+    send_buffer ();
+    if (!traits_type::eq_int_type (c, traits_type::eof ()))
+      {
+        *pptr () = traits_type::to_char_type (c);
+        pbump (1);
+      }
+    return traits_type::not_eof (c);
+  }
+
+private:
+  void send_buffer ()
+  {
+    if (!m_failed)
+      m_failed = !send_all (m_fd, pbase (), pptr () - pbase ());
+    setp (m_buffer, m_buffer + sizeof (m_buffer));
+  }
+
+  int m_fd;
+  bool m_failed{ false };
+  char m_buffer[reply_buffer_size];
+};
+
+} /* namespace */
+
+bool
+control_socket_t::open (const std::string &path)
+{
+  sockaddr_un address{};
+  if (path.size () >= sizeof (address.sun_path))
+    {
+      errno = ENAMETOOLONG;
+      return false;
+    }
+
+  address.sun_family = AF_UNIX;
+  strcpy (address.sun_path, path.c_str ());
+
+  m_listen_fd
+      = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_listen_fd == -1)
+    return false;
+
+  /* The file left by a previous process with the same pid is stale.  */
+  unlink (path.c_str ());
+
+  /* Do not let other users connect.  The mode is set before listening, so
+     that no connection can be made before it is.  The umask is not used
+     for this, it is shared by all the threads of the process.  */
+  if (bind (m_listen_fd, reinterpret_cast<sockaddr *> (&address),
+            sizeof (address))
+          == -1
+      || chmod (path.c_str (), S_IRUSR | S_IWUSR) == -1
+      || listen (m_listen_fd, SOMAXCONN) == -1)
+    {
+      int saved_errno = errno;
+      ::close (m_listen_fd);
+      unlink (path.c_str ());
+      m_listen_fd = -1;
+      errno = saved_errno;
+      return false;
+    }
+  m_path = path;
+
+  m_epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = m_listen_fd;
+  if (m_epoll_fd == -1
+      || epoll_ctl (m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, &ev) == -1)
+    {
+      int saved_errno = errno;
+      close ();
+      errno = saved_errno;
+      return false;
+    }
+
+  return true;
+}
+
+void
+control_socket_t::close ()
+{
+  while (!m_connections.empty ())
+    close_connection (m_connections.begin ()->first);
+
+  if (m_epoll_fd != -1)
+    ::close (m_epoll_fd);
+  m_epoll_fd = -1;
+
+  if (m_listen_fd != -1)
+    {
+      ::close (m_listen_fd);
+      unlink (m_path.c_str ());
+    }
+  m_listen_fd = -1;
+}
+
+void
+control_socket_t::serve (const handler_t &handler)
+{
+  constexpr size_t max_events = 16;
+  epoll_event evs[max_events];
+
+  int nfd = epoll_wait (m_epoll_fd, evs, max_events, 0);
+  for (int i = 0; i < nfd; ++i)
+    {
+      int fd = evs[i].data.fd;
+      if (fd == m_listen_fd)
+        accept_connections ();
+      else if (read_request (fd))
+        {
+          /* The request is terminated by a newline or by the end of the
+             connection.  */
+          std::string request = std::move (m_connections[fd]);
+          if (auto eol = request.find ('\n'); eol != std::string::npos)
+            request.resize (eol);
+          if (!request.empty () && request.back () == '\r')
+            request.pop_back ();
+
+          if (request.size () >= max_request_size)
+            {
+              reply (fd, "error: the request is too long\n");
+              continue;
+            }
+
+          begin_reply (fd);
+          auto buffer = std::make_unique<reply_buffer_t> (fd);
+          std::ostream out (buffer.get ());
+          std::string response = handler (request, out);
+          buffer->finish ();
+
+          reply (fd, response);
+        }
+    }
+}
+
+void
+control_socket_t::accept_connections ()
+{
+  while (true)
+    {
+      int fd = accept4 (m_listen_fd, nullptr, nullptr,
+                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd == -1)
+        {
+          if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+          return;
+        }
+
+      if (m_connections.size () >= max_connections)
+        {
+          ::close (fd);
+          continue;
+        }
+
+      ucred credentials;
+      socklen_t length = sizeof (credentials);
+      if (getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length)
+              == -1
+          || (credentials.uid != 0 && credentials.uid != geteuid ()))
+        {
+          ::close (fd);
+          continue;
+        }
+
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ev.data.fd = fd;
+      if (epoll_ctl (m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+        {
+          ::close (fd);
+          continue;
+        }
+
+      m_connections.emplace (fd, std::string{});
+    }
+}
+
+bool
+control_socket_t::read_request (int fd)
+{
+  auto it = m_connections.find (fd);
+  if (it == m_connections.end ())
+    return false;
+  std::string &request = it->second;
+
+  char buffer[512];
+  while (true)
+    {
+      ssize_t size = read (fd, buffer, sizeof (buffer));
+      if (size == -1 && errno == EINTR)
+        continue;
+
+      if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return request.find ('\n') != std::string::npos
+               || request.size () >= max_request_size;
+
+      if (size == -1)
+        {
+          close_connection (fd);
+          return false;
+        }
+
+      /* The client closed its end of the connection.  */
+      if (size == 0)
+        return true;
+
+      request.append (buffer, size);
+      if (request.find ('\n') != std::string::npos
+          || request.size () >= max_request_size)
+        return true;
+    }
+}
+
+void
+control_socket_t::begin_reply (int fd)
+{
+  /* The reply is sent in blocking mode, but a client that stops reading it
+     cannot hold the thread serving the requests forever.  */
+  fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_NONBLOCK);
+  timeval timeout{ send_timeout_seconds, 0 };
+  setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+}
+
+void
+control_socket_t::reply (int fd, const std::string &response)
+{
+  begin_reply (fd);
+  send_all (fd, response.data (), response.size ());
+  close_connection (fd);
+}
+
+void
+control_socket_t::close_connection (int fd)
+{
+  epoll_ctl (m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  ::close (fd);
+  m_connections.erase (fd);
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,109 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_CONTROL_SOCKET_H
+#define _ROCM_DEBUG_AGENT_CONTROL_SOCKET_H 1
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace amd::debug_agent
+{
+
+/* A Unix domain socket where local clients send requests to the agent.  A
+   client connects, sends one request terminated by a newline (or by closing
+   its end of the connection), and reads the reply until the agent closes
+   the connection.  Only the clients running as the same user as the process
+   (or as root) are served.
+
+   The listening socket and the client connections are watched by an epoll
+   instance of their own, whose file descriptor can be added to the event
+   loop of the thread serving the requests.  */
+
+class control_socket_t
+{
+public:
+  /* A handler returns the reply to REQUEST, or writes it to OUT while it is
+     produced if it may be large.  What is written to OUT is sent first.  */
+  using handler_t = std::function<std::string (const std::string &request,
+                                               std::ostream &out)>;
+
+  control_socket_t () = default;
+  ~control_socket_t () { close (); }
+
+  control_socket_t (const control_socket_t &) = delete;
+  control_socket_t &operator= (const control_socket_t &) = delete;
+
+  /* Create the socket at PATH, replacing any file left there.  Return false,
+     with errno set, if the socket could not be created.  */
+  bool open (const std::string &path);
+
+  /* Close the connections and the socket, and remove it.  */
+  void close ();
+
+  bool is_open () const { return m_listen_fd != -1; }
+  const std::string &path () const { return m_path; }
+
+  /* The file descriptor that is readable when there is something to serve.  */
+  int fd () const { return m_epoll_fd; }
+
+  /* Accept the pending connections, read the pending requests, and reply to
+     the complete ones with the result of HANDLER.  Never blocks waiting for
+     a request, but may block for a while sending a reply to a slow client:
+     each send waits for at most a few seconds, and once one times out the
+     rest of the reply is dropped.  */
+  void serve (const handler_t &handler);
+
+private:
+  void accept_connections ();
+
+  /* Read the data available from the client FD.  Return true if its request
+     is complete.  */
+  bool read_request (int fd);
+
+  /* Send the replies to the client FD in blocking mode, with a timeout.  */
+  void begin_reply (int fd);
+
+  void reply (int fd, const std::string &response);
+  void close_connection (int fd);
+
+  std::string m_path;
+  int m_listen_fd{ -1 };
+  int m_epoll_fd{ -1 };
+
+  /* The connections, and the part of their request received so far.  */
+  std::unordered_map<int, std::string> m_connections;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_CONTROL_SOCKET_H */
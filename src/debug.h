@@ -45,6 +45,9 @@ namespace amd::debug_agent
   do                                                                          \
     {                                                                         \
       agent_log (log_level_t::error, format, ##__VA_ARGS__);                  \
+      /* Do not lose the buffered output.  */                                 \
+      amd::debug_agent::run_abort_hook ();                                    \
+      amd::debug_agent::agent_out.flush ();                                   \
       abort ();                                                               \
     }                                                                         \
   while (false)
@@ -29,8 +29,18 @@
    DEALINGS WITH THE SOFTWARE.  */
 
 #include "code_object.h"
+#include "command_queue.h"
+#include "control_socket.h"
 #include "debug.h"
+#include "dispatch_history.h"
+#include "dump.h"
+#include "dump_throttle.h"
+#include "hang_detector.h"
 #include "logging.h"
+#include "memory_cache.h"
+#include "profile.h"
+#include "stats.h"
+#include "wave_filter.h"
 
 #include <amd-dbgapi/amd-dbgapi.h>
 #include <hsa/hsa.h>
@@ -42,15 +52,22 @@
 #include <getopt.h>
 #include <signal.h>
 #include <string.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
-#include <future>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -59,8 +76,10 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
@@ -87,13 +106,120 @@ std::optional<std::string> g_code_objects_dir;
 bool g_all_wavefronts{ false };
 bool g_precise_emmory{ false };
 
+/* The writer used to format the wavefront dumps, and the file it writes to
+   if the dump is not written to agent_out.  */
+std::unique_ptr<dump_writer_t> g_dump_writer;
+std::ofstream g_dump_out;
+/* True in the thread that writes the dumps, the only one that may flush
+   g_dump_writer and g_dump_out.  */
+thread_local bool g_dump_thread{ false };
+
+/* Selects the wavefronts included in the dumps.  */
+wave_filter_t g_wave_filter;
+
+/* The limits on the duration and the size of a wavefront dump.  When either
+   is exceeded, the dump is stopped at the end of the current record.  */
+struct dump_budget_t
+{
+  std::optional<std::chrono::milliseconds> m_time;
+  std::optional<uint64_t> m_size;
+};
+
+std::optional<dump_budget_t> g_dump_budget;
+
+/* The details printed for each wave, in addition to its summary.  */
+enum class dump_detail_t
+{
+  summary,
+  registers,
+  full
+};
+
+dump_detail_t g_dump_detail{ dump_detail_t::full };
+
+/* Print a histogram of the wave locations instead of the waves.  */
+bool g_hot_spots{ false };
+
+/* The wave creation mode last set for the process.  stop_all_wavefronts
+   only needs to list the waves once if wave creation is stopped.  */
+amd_dbgapi_wave_creation_t g_wave_creation{ AMD_DBGAPI_WAVE_CREATION_NORMAL };
+
+/* How long stop_all_wavefronts waits for the waves to stop.  */
+std::optional<std::chrono::milliseconds> g_stop_timeout;
+
+/* The waves stopped by the agent, or reported by a WAVE_STOP event, during
+   the current stop cycle.  They are resumed at the end of the cycle, with
+   the exceptions of their stop reason if it is already known.  */
+std::unordered_map<decltype (amd_dbgapi_wave_id_t::handle),
+                   std::optional<uint64_t>>
+    g_waves_to_resume;
+
+/* The waves that were still stopping when the stop timeout of
+   stop_all_wavefronts expired.  Their stop request is outstanding: they
+   report a WAVE_STOP or a COMMAND_TERMINATED event later, after which they
+   are resumed without being printed.  */
+std::unordered_set<decltype (amd_dbgapi_wave_id_t::handle)> g_straggling_waves;
+
+/* How long to wait for more events before halting the process to print the
+   waves, if set.  */
+std::optional<std::chrono::milliseconds> g_coalesce_window;
+
+/* Limit the number of dumps printed for the same exception.  */
+dump_throttle_t g_dump_throttle;
+
+/* The flight recorder of the kernel dispatches, and the number of dispatches
+   printed per queue.  It is never destroyed, the HSA hooks may use it until
+   the process exits.  */
+dispatch_history_t *g_dispatch_history{ nullptr };
+size_t g_dispatch_history_length{ 16 };
+
+/* The detector of the host threads waiting on a signal for too long, if
+   enabled.  It is never destroyed, the HSA hooks may use it until the
+   process exits.  The waits are checked every g_hang_check_period, and at
+   most one hang dump is printed every hang_dump_interval.  */
+hang_detector_t *g_hang_detector{ nullptr };
+std::chrono::nanoseconds g_hang_check_period;
+std::chrono::steady_clock::time_point g_next_hang_check;
+std::optional<std::chrono::steady_clock::time_point> g_last_hang_dump;
+constexpr std::chrono::seconds hang_dump_interval{ 60 };
+
+/* The pc sampling profile if enabled, and the prefix of the files it is
+   written to.  */
+std::optional<profile_t> g_profile;
+std::string g_profile_output;
+
 /* Global state accessed by the dbgapi callbacks.  */
 std::optional<amd_dbgapi_breakpoint_id_t> g_rbrk_breakpoint_id;
-struct
-{
-  std::atomic<bool> guard;
-  std::optional<std::promise<void>> promise;
-} g_rbrk_sync;
+
+/* The memory of the process, read by dbgapi through the
+   xfer_global_memory callback.  Its cache is enabled once all the waves to
+   print are reported stopped, and dropped when they are resumed.  */
+std::optional<memory_cache_t> g_memory_cache;
+
+/* The commands sent to the worker thread.  */
+command_queue_t g_commands;
+
+/* With --defer-attach, the worker thread is started, and dbgapi attached,
+   by the first hsa_executable_freeze instead of OnLoad.  */
+bool g_defer_attach{ false };
+std::once_flag g_deferred_attach;
+
+/* The socket where the worker thread serves the requests of local clients,
+   and its path if enabled.  */
+control_socket_t g_control_socket;
+std::optional<std::string> g_control_socket_path;
+
+/* Set while the print command sent by the signal handler is queued, so that
+   it is not queued twice.  The number of signals received while it was
+   queued is counted, they are all served by the same dump.  */
+std::atomic_flag g_print_waves_queued = ATOMIC_FLAG_INIT;
+std::atomic<size_t> g_print_waves_signals{ 0 };
+static_assert (std::atomic<size_t>::is_always_lock_free,
+               "the signal handler must not take a lock");
+
+/* True if code object list updates were requested by the HSA executable
+   hooks since the last report to dbgapi.  */
+std::atomic<bool> g_code_object_update_pending{ false };
 
 amd_dbgapi_status_t
 amd_dbgapi_client_process_get_info (
@@ -130,19 +256,25 @@ amd_dbgapi_xfer_global_memory (
   if (client_process_id == 0)
     return AMD_DBGAPI_STATUS_ERROR_INVALID_ARGUMENT;
 
-  int *self_mem_fd = reinterpret_cast<int *> (client_process_id);
-  if (*self_mem_fd == 0)
-    return AMD_DBGAPI_STATUS_ERROR;
+  auto *memory = reinterpret_cast<memory_cache_t *> (client_process_id);
 
   ssize_t nbytes;
   if (write_buffer == nullptr)
-    nbytes = pread (*self_mem_fd, read_buffer, *value_size, global_address);
+    nbytes = memory->read (global_address, read_buffer, *value_size);
   else
-    nbytes = pwrite (*self_mem_fd, write_buffer, *value_size, global_address);
+    nbytes = memory->write (global_address, write_buffer, *value_size);
 
   if (nbytes == -1)
     {
-      perror ((write_buffer == nullptr) ? "pread failed" : "pwrite failed");
+      /* dbgapi probes memory that may not be mapped, a failed read is not
+         an error.  */
+      if (write_buffer == nullptr)
+        agent_log (log_level_t::verbose,
+                   "could not read %lu bytes at %#lx: %s", *value_size,
+                   global_address, strerror (errno));
+      else
+        agent_warning ("could not write %lu bytes at %#lx: %s", *value_size,
+                       global_address, strerror (errno));
       return AMD_DBGAPI_STATUS_ERROR_MEMORY_ACCESS;
     }
 
@@ -192,60 +324,54 @@ static amd_dbgapi_callbacks_t dbgapi_callbacks = {
   /* log_message callback.  */
   .log_message =
       [] (amd_dbgapi_log_level_t level, const char *message) {
-        agent_out << "rocm-dbgapi: " << message << std::endl;
+        switch (level)
+          {
+          case AMD_DBGAPI_LOG_LEVEL_NONE:
+            break;
+          case AMD_DBGAPI_LOG_LEVEL_FATAL_ERROR:
+            log_dbgapi_message (log_level_t::error, message);
+            break;
+          case AMD_DBGAPI_LOG_LEVEL_WARNING:
+            log_dbgapi_message (log_level_t::warning, message);
+            break;
+          case AMD_DBGAPI_LOG_LEVEL_INFO:
+            log_dbgapi_message (log_level_t::info, message);
+            break;
+          case AMD_DBGAPI_LOG_LEVEL_TRACE:
+          case AMD_DBGAPI_LOG_LEVEL_VERBOSE:
+            log_dbgapi_message (log_level_t::verbose, message);
+            break;
+          }
       }
 };
 
-std::string
-hex_string (const std::vector<uint8_t> &value)
-{
-  std::string value_string;
-  value_string.reserve (2 * value.size ());
-
-  for (size_t pos = value.size (); pos > 0; --pos)
-    {
-      static constexpr char hex_digits[] = "0123456789abcdef";
-      value_string.push_back (hex_digits[value[pos - 1] >> 4]);
-      value_string.push_back (hex_digits[value[pos - 1] & 0xF]);
-    }
-
-  return value_string;
-}
+/* Make dbgapi report the messages it logs at the agent's log level.  */
 
-std::string
-register_value_string (const std::string &register_type,
-                       const std::vector<uint8_t> &register_value)
+void
+set_dbgapi_log_level ()
 {
-  /* handle vector types..  */
-  if (size_t pos = register_type.find_last_of ('['); pos != std::string::npos)
+  switch (dbgapi_log_level ())
     {
-      const std::string element_type = register_type.substr (0, pos);
-      const size_t element_count = std::stoi (register_type.substr (pos + 1));
-      const size_t element_size = register_value.size () / element_count;
-
-      agent_assert ((register_value.size () % element_size) == 0);
-
-      std::stringstream ss;
-      for (size_t i = 0; i < element_count; ++i)
-        {
-          if (i != 0)
-            ss << " ";
-          ss << "[" << i << "] ";
-
-          std::vector<uint8_t> element_value (
-              &register_value[element_size * i],
-              &register_value[element_size * (i + 1)]);
-
-          ss << register_value_string (element_type, element_value);
-        }
-      return ss.str ();
+    case log_level_t::none:
+      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_NONE);
+      break;
+    case log_level_t::verbose:
+      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_VERBOSE);
+      break;
+    case log_level_t::info:
+      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_INFO);
+      break;
+    case log_level_t::warning:
+      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_WARNING);
+      break;
+    case log_level_t::error:
+      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_FATAL_ERROR);
+      break;
     }
-
-  return hex_string (register_value);
 }
 
-void
-print_registers (amd_dbgapi_wave_id_t wave_id)
+std::vector<register_class_t>
+collect_registers (amd_dbgapi_wave_id_t wave_id)
 {
   amd_dbgapi_architecture_id_t architecture_id;
   DBGAPI_CHECK (
@@ -262,6 +388,8 @@ print_registers (amd_dbgapi_wave_id_t wave_id)
   DBGAPI_CHECK (
       amd_dbgapi_wave_register_list (wave_id, &register_count, &register_ids));
 
+  stats::scoped_timer_t timer (stats::timer_t::registers);
+
   auto hash = [] (const amd_dbgapi_register_id_t &id) {
     return std::hash<decltype (id.handle)>{}(id.handle);
   };
@@ -273,6 +401,9 @@ print_registers (amd_dbgapi_wave_id_t wave_id)
                      decltype (equal_to)>
       printed_registers (0, hash, equal_to);
 
+  std::vector<register_class_t> classes;
+  classes.reserve (class_count);
+
   for (size_t i = 0; i < class_count; ++i)
     {
       amd_dbgapi_register_class_id_t register_class_id = register_class_ids[i];
@@ -292,10 +423,10 @@ print_registers (amd_dbgapi_wave_id_t wave_id)
           continue;
         }
 
-      agent_out << std::endl << class_name << " registers:";
+      auto &register_class = classes.emplace_back ();
+      register_class.m_name = std::move (class_name);
 
-      size_t last_register_size = 0;
-      for (size_t j = 0, column = 0; j < register_count; ++j)
+      for (size_t j = 0; j < register_count; ++j)
         {
           amd_dbgapi_register_id_t register_id = register_ids[j];
 
@@ -315,14 +446,15 @@ print_registers (amd_dbgapi_wave_id_t wave_id)
           DBGAPI_CHECK (amd_dbgapi_register_get_info (
               register_id, AMD_DBGAPI_REGISTER_INFO_NAME,
               sizeof (register_name_), &register_name_));
-          std::string register_name (register_name_);
+          register_value_t &reg = register_class.m_registers.emplace_back ();
+          reg.m_name.assign (register_name_);
           free (register_name_);
 
           char *register_type_;
           DBGAPI_CHECK (amd_dbgapi_register_get_info (
               register_id, AMD_DBGAPI_REGISTER_INFO_TYPE,
               sizeof (register_type_), &register_type_));
-          std::string register_type (register_type_);
+          reg.m_type.assign (register_type_);
           free (register_type_);
 
           size_t register_size;
@@ -330,40 +462,23 @@ print_registers (amd_dbgapi_wave_id_t wave_id)
               register_id, AMD_DBGAPI_REGISTER_INFO_SIZE,
               sizeof (register_size), &register_size));
 
-          std::vector<uint8_t> buffer (register_size);
+          reg.m_value.resize (register_size);
           DBGAPI_CHECK (amd_dbgapi_read_register (
-              wave_id, register_id, 0, register_size, buffer.data ()));
-
-          const size_t num_register_per_line = 16 / register_size;
-
-          if (register_size > sizeof (uint64_t) /* Registers larger than a
-                                                   uint64_t are printed each
-                                                   on a separate line.  */
-              || register_size != last_register_size
-              || (column++ % num_register_per_line) == 0)
-            {
-              agent_out << std::endl;
-              column = 1;
-            }
-
-          last_register_size = register_size;
-
-          agent_out << std::right << std::setfill (' ') << std::setw (16)
-                    << (register_name + ": ")
-                    << register_value_string (register_type, buffer);
+              wave_id, register_id, 0, register_size, reg.m_value.data ()));
+          stats::add (stats::counter_t::register_bytes, register_size);
 
           printed_registers.emplace (register_id);
         }
-
-      agent_out << std::endl;
     }
 
   free (register_ids);
   free (register_class_ids);
+
+  return classes;
 }
 
-void
-print_local_memory (amd_dbgapi_wave_id_t wave_id)
+std::vector<uint8_t>
+read_local_memory (amd_dbgapi_wave_id_t wave_id)
 {
   amd_dbgapi_process_id_t process_id;
   DBGAPI_CHECK (amd_dbgapi_wave_get_info (wave_id,
@@ -380,61 +495,150 @@ print_local_memory (amd_dbgapi_wave_id_t wave_id)
       architecture_id, 0x3 /* DW_ASPACE_AMDGPU_local */,
       &local_address_space_id));
 
-  std::vector<uint32_t> buffer (1024);
+  stats::scoped_timer_t timer (stats::timer_t::local_memory);
+
+  constexpr size_t chunk_size = 4096;
+  std::vector<uint8_t> contents;
   amd_dbgapi_segment_address_t base_address{ 0 };
 
   while (true)
     {
-      size_t requested_size = buffer.size () * sizeof (buffer[0]);
-      size_t size = requested_size;
+      contents.resize (base_address + chunk_size);
+
+      size_t size = chunk_size;
       if (amd_dbgapi_read_memory (process_id, wave_id, 0,
                                   local_address_space_id, base_address, &size,
-                                  buffer.data ())
+                                  &contents[base_address])
           != AMD_DBGAPI_STATUS_SUCCESS)
+        size = 0;
+
+      agent_assert ((size % sizeof (uint32_t)) == 0);
+      base_address += size;
+
+      if (size != chunk_size)
         break;
+    }
 
-      agent_assert ((size % sizeof (buffer[0])) == 0);
-      buffer.resize (size / sizeof (buffer[0]));
+  contents.resize (base_address);
+  stats::add (stats::counter_t::local_memory_bytes, contents.size ());
+  return contents;
+}
 
-      if (!base_address)
-        agent_out << std::endl << "Local memory content:";
+void
+set_wave_creation (amd_dbgapi_process_id_t process_id,
+                   amd_dbgapi_wave_creation_t mode)
+{
+  DBGAPI_CHECK (amd_dbgapi_process_set_wave_creation (process_id, mode));
+  g_wave_creation = mode;
+}
 
-      for (size_t i = 0, column = 0; i < buffer.size (); ++i)
-        {
-          if ((column++ % 8) == 0)
-            {
-              agent_out << std::endl
-                        << "    0x" << std::setfill ('0') << std::setw (4)
-                        << (base_address + i * sizeof (buffer[0])) << ":";
-              column = 1;
-            }
+/* Drain the dbgapi NOTIFIER pipe.  An event reported after this point writes
+   to the notifier again.  */
 
-          agent_out << " " << std::hex << std::setfill ('0') << std::setw (8)
-                    << buffer[i];
-        }
+void
+drain_notifier (amd_dbgapi_notifier_t notifier)
+{
+  char buf[64];
+  ssize_t r;
+  do
+    r = read (notifier, buf, sizeof (buf));
+  while (r == sizeof (buf) || (r == -1 && errno == EINTR));
+}
 
-      base_address += size;
+/* Wait until the dbgapi notifier of PROCESS_ID signals that new events are
+   available, or until DEADLINE.  Return false if the deadline expired.  */
+
+bool
+wait_for_dbgapi_events (
+    amd_dbgapi_process_id_t process_id,
+    std::optional<std::chrono::steady_clock::time_point> deadline)
+{
+  amd_dbgapi_notifier_t notifier;
+  DBGAPI_CHECK (amd_dbgapi_process_get_info (process_id,
+                                             AMD_DBGAPI_PROCESS_INFO_NOTIFIER,
+                                             sizeof (notifier), &notifier));
+
+  pollfd fd{ notifier, POLLIN, 0 };
+  while (true)
+    {
+      int timeout = -1;
+      if (deadline)
+        {
+          auto remaining = std::chrono::ceil<std::chrono::milliseconds> (
+              *deadline - std::chrono::steady_clock::now ());
+          if (remaining.count () <= 0)
+            return false;
+          timeout = remaining.count ();
+        }
 
-      if (size != requested_size)
+      if (int ret = poll (&fd, 1, timeout); ret == 0)
+        return false;
+      else if (ret > 0)
         break;
+      else if (errno != EINTR)
+        agent_error ("poll failed: %s", strerror (errno));
     }
 
-  if (base_address)
-    agent_out << std::endl;
+  /* The events are all processed by the caller.  */
+  drain_notifier (notifier);
+  return true;
 }
 
-void
+/* Stop all the waves, and record them in g_waves_to_resume.  Return true if
+   a queue error was reported while the waves were stopping.  */
+
+bool
 stop_all_wavefronts (amd_dbgapi_process_id_t process_id)
 {
   using wave_handle_type_t = decltype (amd_dbgapi_wave_id_t::handle);
-  std::unordered_set<wave_handle_type_t> already_stopped;
-  std::unordered_set<wave_handle_type_t> waiting_to_stop;
 
-  agent_log (log_level_t::info, "stopping all wavefronts");
-  for (size_t iter = 0;; ++iter)
+  enum class tracked_state_t : uint8_t
+  {
+    /* A stop request was sent, the wave will report a WAVE_STOP or a
+       COMMAND_TERMINATED event.  */
+    stopping,
+    /* The wave is stopped.  */
+    stopped,
+    /* The wave is single-stepping, it will stop and report an event once the
+       instruction execution is complete.  */
+    single_stepping,
+    /* The wave terminated.  */
+    terminated
+  };
+
+  struct tracked_wave_t
+  {
+    wave_handle_type_t m_handle;
+    tracked_state_t m_state;
+
+    bool operator< (wave_handle_type_t handle) const
     {
-      agent_log (log_level_t::info, "iteration %zu:", iter);
+      return m_handle < handle;
+    }
+  };
+
+  /* The waves seen so far, sorted by handle.  */
+  std::vector<tracked_wave_t> waves;
+  size_t stopping_count = 0;
+
+  auto find_wave = [&waves] (wave_handle_type_t handle) -> tracked_wave_t * {
+    auto it = std::lower_bound (waves.begin (), waves.end (), handle);
+    return (it != waves.end () && it->m_handle == handle) ? &*it : nullptr;
+  };
+
+  const auto start = std::chrono::steady_clock::now ();
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (g_stop_timeout)
+    deadline.emplace (start + *g_stop_timeout);
 
+  size_t list_count = 0, wait_count = 0;
+  bool need_wave_list = true;
+  bool timed_out = false;
+  bool queue_error = false;
+
+  agent_log (log_level_t::info, "stopping all wavefronts");
+  while (true)
+    {
       while (true)
         {
           amd_dbgapi_event_id_t event_id;
@@ -454,102 +658,403 @@ stop_all_wavefronts (amd_dbgapi_process_id_t process_id)
                   event_id, AMD_DBGAPI_EVENT_INFO_WAVE, sizeof (wave_id),
                   &wave_id));
 
-              agent_assert (waiting_to_stop.find (wave_id.handle)
-                            != waiting_to_stop.end ());
+              g_straggling_waves.erase (wave_id.handle);
+
+              tracked_wave_t *wave = find_wave (wave_id.handle);
+              if (!wave)
+                {
+                  /* The wave stopped on its own before it was listed.  It
+                     is recorded when the waves are listed.  */
+                  need_wave_list = true;
+                }
+              else
+                {
+                  if (wave->m_state == tracked_state_t::stopping)
+                    --stopping_count;
 
-              waiting_to_stop.erase (wave_id.handle);
+                  wave->m_state = kind == AMD_DBGAPI_EVENT_KIND_WAVE_STOP
+                                      ? tracked_state_t::stopped
+                                      : tracked_state_t::terminated;
+                }
 
               if (kind == AMD_DBGAPI_EVENT_KIND_WAVE_STOP)
+                agent_log (log_level_t::info, "wave_%ld is stopped",
+                           wave_id.handle);
+              else /* kind == AMD_DBGAPI_EVENT_KIND_COMMAND_TERMINATED */
+                agent_log (log_level_t::info,
+                           "wave_%ld terminated while stopping",
+                           wave_id.handle);
+            }
+          else if (kind == AMD_DBGAPI_EVENT_KIND_QUEUE_ERROR)
+            queue_error = true;
+
+          DBGAPI_CHECK (amd_dbgapi_event_processed (event_id));
+        }
+
+      if (need_wave_list)
+        {
+          amd_dbgapi_wave_id_t *wave_ids;
+          size_t wave_count;
+          DBGAPI_CHECK (amd_dbgapi_process_wave_list (
+              process_id, &wave_count, &wave_ids, nullptr));
+          std::unique_ptr<amd_dbgapi_wave_id_t, decltype (free) *>
+              wave_ids_cleaner (wave_ids, free);
+          ++list_count;
+
+          std::sort (wave_ids, wave_ids + wave_count,
+                     [] (auto &&lhs, auto &&rhs) {
+                       return lhs.handle < rhs.handle;
+                     });
+
+          /* Merge the new waves into the table, and stop those that are
+             still running.  */
+          std::vector<tracked_wave_t> merged_waves;
+          merged_waves.reserve (std::max (waves.size (), wave_count));
+
+          auto it = waves.begin ();
+          for (size_t i = 0; i < wave_count; ++i)
+            {
+              amd_dbgapi_wave_id_t wave_id = wave_ids[i];
+
+              while (it != waves.end () && it->m_handle < wave_id.handle)
+                merged_waves.push_back (*it++);
+
+              if (it != waves.end () && it->m_handle == wave_id.handle)
+                {
+                  merged_waves.push_back (*it++);
+                  continue;
+                }
+
+              /* A wave that did not stop before the timeout of a previous
+                 call reports a stop event for the outstanding request, even
+                 if it is already stopped.  */
+              if (g_straggling_waves.count (wave_id.handle))
+                {
+                  merged_waves.push_back (
+                      { wave_id.handle, tracked_state_t::stopping });
+                  ++stopping_count;
+
+                  agent_log (log_level_t::info,
+                             "wave_%ld is still stopping", wave_id.handle);
+                  continue;
+                }
+
+              amd_dbgapi_wave_state_t state;
+              if (amd_dbgapi_status_t status = amd_dbgapi_wave_get_info (
+                      wave_id, AMD_DBGAPI_WAVE_INFO_STATE, sizeof (state),
+                      &state);
+                  status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
+                {
+                  /* The wave could have terminated since it was listed.
+                     Skip it.  */
+                  continue;
+                }
+              else if (status != AMD_DBGAPI_STATUS_SUCCESS)
+                agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)",
+                             status);
+
+              if (state == AMD_DBGAPI_WAVE_STATE_STOP)
                 {
-                  already_stopped.emplace (wave_id.handle);
+                  merged_waves.push_back (
+                      { wave_id.handle, tracked_state_t::stopped });
 
-                  agent_log (log_level_t::info, "wave_%ld is stopped",
+                  agent_log (log_level_t::info, "wave_%ld is already stopped",
                              wave_id.handle);
+                  continue;
                 }
-              else /* kind == AMD_DBGAPI_EVENT_KIND_COMMAND_TERMINATED */
+              if (state == AMD_DBGAPI_WAVE_STATE_SINGLE_STEP)
                 {
-                  agent_log (log_level_t::info,
-                             "wave_%ld terminated while stopping",
+                  merged_waves.push_back (
+                      { wave_id.handle, tracked_state_t::single_stepping });
+
+                  agent_log (log_level_t::info, "wave_%ld is single-stepping",
                              wave_id.handle);
+                  continue;
+                }
+
+              if (amd_dbgapi_status_t status = amd_dbgapi_wave_stop (wave_id);
+                  status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
+                {
+                  /* The wave could have terminated since it was listed.
+                     Skip it.  */
+                  continue;
                 }
+              else if (status != AMD_DBGAPI_STATUS_SUCCESS
+                       && status
+                              != AMD_DBGAPI_STATUS_ERROR_WAVE_OUTSTANDING_STOP)
+                agent_error ("amd_dbgapi_wave_stop failed (rc=%d)", status);
+
+              agent_log (log_level_t::info,
+                         "wave_%ld is running, sent stop request",
+                         wave_id.handle);
+
+              merged_waves.push_back (
+                  { wave_id.handle, tracked_state_t::stopping });
+              ++stopping_count;
             }
 
-          DBGAPI_CHECK (amd_dbgapi_event_processed (event_id));
+          /* Waves that are not listed anymore have terminated, they are kept
+             so that their pending events are recognized.  */
+          merged_waves.insert (merged_waves.end (), it, waves.end ());
+          waves = std::move (merged_waves);
+
+          /* New waves can only appear if wave creation is not stopped.  */
+          need_wave_list = g_wave_creation != AMD_DBGAPI_WAVE_CREATION_STOP;
         }
 
-      amd_dbgapi_wave_id_t *wave_ids;
-      size_t wave_count;
-      DBGAPI_CHECK (amd_dbgapi_process_wave_list (process_id, &wave_count,
-                                                  &wave_ids, nullptr));
+      if (!stopping_count)
+        break;
 
-      /* Stop all waves that are still running.  */
-      for (size_t i = 0; i < wave_count; ++i)
+      /* Block until the waves report their stop events.  */
+      ++wait_count;
+      if (!wait_for_dbgapi_events (process_id, deadline))
         {
-          amd_dbgapi_wave_id_t wave_id = wave_ids[i];
+          timed_out = true;
+          break;
+        }
+    }
 
-          if (already_stopped.find (wave_id.handle) != already_stopped.end ())
-            continue;
+  /* The stopped waves must be resumed at the end of the stop cycle.  The
+     waves still stopping are resumed when they report their stop.  The
+     straggling waves that are not listed anymore have terminated.  */
+  g_straggling_waves.clear ();
+  for (auto &&wave : waves)
+    if (wave.m_state == tracked_state_t::stopped)
+      g_waves_to_resume.try_emplace (wave.m_handle);
+    else if (wave.m_state == tracked_state_t::stopping)
+      g_straggling_waves.insert (wave.m_handle);
+
+  const auto latency = std::chrono::steady_clock::now () - start;
+  stats::record (stats::timer_t::stop_all_wavefronts, latency);
+
+  if (timed_out)
+    agent_warning ("%zu wavefronts did not stop within %ld ms",
+                   stopping_count,
+                   static_cast<long> (g_stop_timeout->count ()));
+  else
+    agent_log (log_level_t::info, "all wavefronts are stopped");
 
-          /* Already requested to stop.  */
-          if (waiting_to_stop.find (wave_id.handle) != waiting_to_stop.end ())
-            {
-              agent_log (log_level_t::info, "wave_%ld is still stopping",
-                         wave_id.handle);
-              continue;
-            }
+  using usec = std::chrono::duration<double, std::micro>;
+  agent_log (log_level_t::info,
+             "stopped %zu wavefronts in %.0f us (%zu wave lists, %zu waits)",
+             waves.size (), usec (latency).count (), list_count, wait_count);
 
-          amd_dbgapi_wave_state_t state;
-          if (amd_dbgapi_status_t status = amd_dbgapi_wave_get_info (
-                  wave_id, AMD_DBGAPI_WAVE_INFO_STATE, sizeof (state), &state);
-              status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
-            {
-              /* The wave could have terminated since it was reported in the
-                 last wave list.  Skip it.  */
-              continue;
-            }
-          else if (status != AMD_DBGAPI_STATUS_SUCCESS)
-            agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)", status);
+  return queue_error;
+}
 
-          if (state == AMD_DBGAPI_WAVE_STATE_STOP)
-            {
-              already_stopped.emplace (wave_ids[i].handle);
+using code_object_map_t
+    = std::map<amd_dbgapi_global_address_t, code_object_t>;
 
-              agent_log (log_level_t::info, "wave_%ld is already stopped",
-                         wave_id.handle);
-              continue;
-            }
-          if (state == AMD_DBGAPI_WAVE_STATE_SINGLE_STEP)
-            {
-              /* The wave is single-stepping, it will stop and report an event
-                 once the instruction execution is complete.  */
-              agent_log (log_level_t::info, "wave_%ld is single-stepping",
-                         wave_id.handle);
-              continue;
-            }
+/* Return the code object in CODE_OBJECT_MAP that contains ADDRESS, or nullptr
+   if there is none.  */
 
-          if (amd_dbgapi_status_t status = amd_dbgapi_wave_stop (wave_id);
-              status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
-            {
-              /* The wave could have terminated since it was reported in the
-                 last wave list.  Skip it.  */
-              continue;
-            }
-          else if (status != AMD_DBGAPI_STATUS_SUCCESS)
-            agent_error ("amd_dbgapi_wave_stop failed (rc=%d)", status);
+code_object_t *
+find_code_object (code_object_map_t &code_object_map,
+                  amd_dbgapi_global_address_t address)
+{
+  if (auto it = code_object_map.upper_bound (address);
+      it != code_object_map.begin ())
+    if (auto &&[load_address, code_object] = *std::prev (it);
+        (address - load_address) <= code_object.mem_size ())
+      return &code_object;
 
-          agent_log (log_level_t::info,
-                     "wave_%ld is running, sent stop request", wave_id.handle);
+  return nullptr;
+}
+
+/* Return the kernel, function and source line of PC, executed by a wave of
+   the kernel at KERNEL_ENTRY (or 0 if it is not known), as far as they are
+   known from the code objects in CODE_OBJECT_MAP.  */
 
-          waiting_to_stop.emplace (wave_id.handle);
+profile_t::location_t
+source_location (code_object_map_t &code_object_map,
+                 amd_dbgapi_global_address_t kernel_entry,
+                 amd_dbgapi_global_address_t pc)
+{
+  profile_t::location_t location;
+
+  if (code_object_t *code_object
+      = kernel_entry ? find_code_object (code_object_map, kernel_entry)
+                     : nullptr)
+    if (auto symbol = code_object->find_symbol (kernel_entry))
+      location.m_kernel_name.emplace (symbol->m_name);
+
+  if (code_object_t *code_object = find_code_object (code_object_map, pc))
+    {
+      if (auto symbol = code_object->find_symbol (pc))
+        location.m_function_name.emplace (symbol->m_name);
+
+      if (auto line_info = code_object->find_line (pc))
+        {
+          location.m_file_name.emplace (line_info->m_file_name);
+          location.m_line = line_info->m_line_number;
         }
+    }
 
-      free (wave_ids);
+  return location;
+}
 
-      if (!waiting_to_stop.size ())
-        break;
+/* Print a histogram of the location of the stopped waves, grouped by kernel,
+   function and source line.  Only the pc and the dispatch of each wave are
+   read, so this is much cheaper than printing the waves.  */
+
+void
+print_hot_spots (amd_dbgapi_process_id_t process_id,
+                 code_object_map_t &code_object_map)
+{
+  amd_dbgapi_wave_id_t *wave_ids;
+  size_t wave_count;
+  DBGAPI_CHECK (amd_dbgapi_process_wave_list (process_id, &wave_count,
+                                              &wave_ids, nullptr));
+
+  /* The number of waves at each kernel entry and pc.  The kernel entry is 0
+     if it is not available.  */
+  std::map<std::pair<amd_dbgapi_global_address_t, amd_dbgapi_global_address_t>,
+           uint64_t>
+      pc_counts;
+  std::unordered_map<decltype (amd_dbgapi_dispatch_id_t::handle),
+                     amd_dbgapi_global_address_t>
+      kernel_entries;
+  uint64_t stopped_waves = 0;
+
+  for (size_t i = 0; i < wave_count; ++i)
+    {
+      amd_dbgapi_global_address_t pc;
+      if (auto status
+          = amd_dbgapi_wave_get_info (wave_ids[i], AMD_DBGAPI_WAVE_INFO_PC,
+                                      sizeof (pc), &pc);
+          status == AMD_DBGAPI_STATUS_ERROR_WAVE_NOT_STOPPED)
+        continue;
+      else if (status != AMD_DBGAPI_STATUS_SUCCESS)
+        agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)", status);
+
+      amd_dbgapi_global_address_t kernel_entry{ 0 };
+      amd_dbgapi_dispatch_id_t dispatch_id;
+      if (amd_dbgapi_wave_get_info (wave_ids[i], AMD_DBGAPI_WAVE_INFO_DISPATCH,
+                                    sizeof (dispatch_id), &dispatch_id)
+          == AMD_DBGAPI_STATUS_SUCCESS)
+        {
+          auto [it, inserted]
+              = kernel_entries.try_emplace (dispatch_id.handle);
+          if (inserted)
+            DBGAPI_CHECK (amd_dbgapi_dispatch_get_info (
+                dispatch_id,
+                AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS,
+                sizeof (it->second), &it->second));
+          kernel_entry = it->second;
+        }
+
+      ++pc_counts[{ kernel_entry, pc }];
+      ++stopped_waves;
+    }
+
+  free (wave_ids);
+
+  /* Group the pcs by kernel, function and source line.  */
+  using location_t
+      = std::tuple<std::optional<std::string>, std::optional<std::string>,
+                   std::optional<std::string>, uint64_t>;
+  std::map<location_t, hot_spot_t> locations;
+
+  for (auto &&[key, count] : pc_counts)
+    {
+      auto [kernel_entry, pc] = key;
+      auto [kernel_name, function_name, file_name, line]
+          = source_location (code_object_map, kernel_entry, pc);
+      location_t location{ kernel_name, function_name, file_name, line };
+
+      auto [it, inserted] = locations.try_emplace (location);
+      hot_spot_t &hot_spot = it->second;
+      if (inserted)
+        {
+          hot_spot.m_kernel_name = kernel_name;
+          hot_spot.m_function_name = function_name;
+          hot_spot.m_file_name = file_name;
+          hot_spot.m_line = line;
+          hot_spot.m_wave_count = 0;
+        }
+
+      hot_spot.m_wave_count += count;
+      hot_spot.m_pcs.push_back ({ pc, count });
+    }
+
+  std::vector<hot_spot_t> hot_spots;
+  hot_spots.reserve (locations.size ());
+  for (auto &&[location, hot_spot] : locations)
+    {
+      std::stable_sort (hot_spot.m_pcs.begin (), hot_spot.m_pcs.end (),
+                        [] (auto &&lhs, auto &&rhs) {
+                          return lhs.m_wave_count > rhs.m_wave_count;
+                        });
+      hot_spots.emplace_back (std::move (hot_spot));
     }
 
-  agent_log (log_level_t::info, "all wavefronts are stopped");
+  std::stable_sort (hot_spots.begin (), hot_spots.end (),
+                    [] (auto &&lhs, auto &&rhs) {
+                      return lhs.m_wave_count > rhs.m_wave_count;
+                    });
+
+  g_dump_writer->hot_spots (stopped_waves, hot_spots);
+}
+
+/* Print the last kernels dispatched to each queue.  */
+
+void
+print_dispatch_history (amd_dbgapi_process_id_t process_id,
+                        code_object_map_t &code_object_map)
+{
+  const auto records
+      = g_dispatch_history->last_dispatches (g_dispatch_history_length);
+  if (records.empty ())
+    return;
+
+  const uint64_t now
+      = std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ())
+            .count ();
+
+  /* The name of the kernel of each kernel descriptor.  */
+  std::unordered_map<uint64_t, std::optional<std::string>> kernel_names;
+  auto kernel_name = [&] (uint64_t kernel_object) {
+    auto [it, inserted] = kernel_names.try_emplace (kernel_object);
+    if (!inserted)
+      return it->second;
+
+    /* The kernel descriptor's kernel_code_entry_byte_offset is the offset of
+       the kernel's code from the descriptor.  */
+    constexpr uint64_t kernel_code_entry_byte_offset = 16;
+    int64_t entry_offset;
+    amd_dbgapi_size_t size = sizeof (entry_offset);
+    if (amd_dbgapi_read_memory (
+            process_id, AMD_DBGAPI_WAVE_NONE, AMD_DBGAPI_LANE_NONE,
+            AMD_DBGAPI_ADDRESS_SPACE_GLOBAL,
+            kernel_object + kernel_code_entry_byte_offset, &size,
+            &entry_offset)
+        != AMD_DBGAPI_STATUS_SUCCESS)
+      return it->second;
+
+    const uint64_t kernel_entry = kernel_object + entry_offset;
+    if (auto *code_object = find_code_object (code_object_map, kernel_entry))
+      if (auto symbol = code_object->find_symbol (kernel_entry))
+        it->second.emplace (symbol->m_name);
+
+    return it->second;
+  };
+
+  std::vector<dispatch_info_t> dispatches;
+  dispatches.reserve (records.size ());
+  for (auto &&record : records)
+    dispatches.push_back (
+        { record.m_queue_id,
+          record.m_packet_id,
+          record.m_kernel_object,
+          kernel_name (record.m_kernel_object),
+          { record.m_grid_size[0], record.m_grid_size[1],
+            record.m_grid_size[2] },
+          { record.m_workgroup_size[0], record.m_workgroup_size[1],
+            record.m_workgroup_size[2] },
+          now > record.m_timestamp ? now - record.m_timestamp : 0 });
+
+  g_dump_writer->dispatch_history (dispatches);
 }
 
 void
@@ -562,7 +1067,42 @@ print_wavefronts (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
   /* Make sure the lock is released when this function returns.  */
   std::scoped_lock sl (std::adopt_lock, lock);
 
-  std::map<amd_dbgapi_global_address_t, code_object_t> code_object_map;
+  stats::scoped_timer_t dump_timer (stats::timer_t::dump);
+  stats::add (stats::counter_t::dumps);
+
+  const auto dump_start = std::chrono::steady_clock::now ();
+  const uint64_t dump_start_size = g_dump_writer->bytes_written ();
+
+  auto end_dump = [&] () {
+    {
+      stats::scoped_timer_t timer (stats::timer_t::output);
+      g_dump_writer->end_dump ();
+    }
+    stats::add (stats::counter_t::dump_bytes,
+                g_dump_writer->bytes_written () - dump_start_size);
+  };
+
+  auto budget_exhausted = [&] () {
+    if (!g_dump_budget)
+      return false;
+
+    if (g_dump_budget->m_time
+        && std::chrono::steady_clock::now () - dump_start
+               >= *g_dump_budget->m_time)
+      return true;
+
+    return g_dump_budget->m_size
+           && g_dump_writer->bytes_written () - dump_start_size
+                  >= *g_dump_budget->m_size;
+  };
+
+  /* Write the messages logged before the dump first.  */
+  flush_log ();
+  g_dump_writer->begin_dump ();
+
+  code_object_map_t code_object_map;
+  std::optional<stats::scoped_timer_t> code_objects_timer;
+  code_objects_timer.emplace (stats::timer_t::code_objects);
 
   amd_dbgapi_code_object_id_t *code_objects_id;
   size_t code_object_count;
@@ -585,24 +1125,69 @@ print_wavefronts (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
         agent_warning ("could not save code object to %s",
                        g_code_objects_dir->c_str ());
 
+      g_dump_writer->code_object ({ code_object.load_address (),
+                                    code_object.mem_size (),
+                                    code_object.uri () });
+
       code_object_map.emplace (code_object.load_address (),
                                std::move (code_object));
     }
   free (code_objects_id);
+  code_objects_timer.reset ();
 
   if (all_wavefronts)
     stop_all_wavefronts (process_id);
 
+  /* dbgapi suspends and resumes the queues, and updates the memory they
+     use, until the waves it stops report their stop.  The reads are only
+     cached once no wave is still stopping.  */
+  if (g_straggling_waves.empty ())
+    g_memory_cache->enable ();
+
+  if (g_dispatch_history)
+    print_dispatch_history (process_id, code_object_map);
+
+  if (g_hot_spots)
+    {
+      print_hot_spots (process_id, code_object_map);
+      end_dump ();
+      return;
+    }
+
   amd_dbgapi_wave_id_t *wave_ids;
   size_t wave_count;
   DBGAPI_CHECK (amd_dbgapi_process_wave_list (process_id, &wave_count,
                                               &wave_ids, nullptr));
 
-  for (size_t i = 0; i < wave_count; ++i)
-    {
-      amd_dbgapi_wave_id_t wave_id = wave_ids[i];
+  /* The operating system id of the agents, used to filter the waves.  */
+  std::unordered_map<decltype (amd_dbgapi_agent_id_t::handle),
+                     amd_dbgapi_os_agent_id_t>
+      os_agent_ids;
 
-      amd_dbgapi_wave_state_t state;
+  /* The id recorded by the dispatch history of the HSA queue of each dbgapi
+     queue, used to match the waves with their queue's dispatches.  */
+  std::unordered_map<decltype (amd_dbgapi_queue_id_t::handle),
+                     std::optional<uint64_t>>
+      queue_ids;
+
+  /* The waves selected for the dump.  */
+  struct dumped_wave_t
+  {
+    amd_dbgapi_wave_id_t m_wave_id;
+    wave_info_t m_info;
+    code_object_t *m_code_object;
+  };
+  std::vector<dumped_wave_t> waves;
+
+  size_t filtered_waves = 0;
+  for (size_t i = 0; i < wave_count; ++i)
+    {
+      amd_dbgapi_wave_id_t wave_id = wave_ids[i];
+
+      /* The filters are checked in order of the cost of the information they
+         need, before anything else is read from the wave.  */
+
+      amd_dbgapi_wave_state_t state;
       DBGAPI_CHECK (amd_dbgapi_wave_get_info (
           wave_id, AMD_DBGAPI_WAVE_INFO_STATE, sizeof (state), &state));
 
@@ -614,148 +1199,240 @@ print_wavefronts (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
           amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON,
                                     sizeof (stop_reason), &stop_reason));
 
-      amd_dbgapi_global_address_t pc;
-      DBGAPI_CHECK (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_PC,
-                                              sizeof (pc), &pc));
+      /* Make sure all the stopped waves are resumed at the end of the stop
+         cycle, even if no WAVE_STOP event was reported for them.  */
+      g_waves_to_resume.insert_or_assign (wave_id.handle, stop_reason);
 
-      std::optional<amd_dbgapi_global_address_t> kernel_entry;
-      amd_dbgapi_dispatch_id_t dispatch_id;
-      if (auto status
-          = amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_DISPATCH,
-                                      sizeof (dispatch_id), &dispatch_id);
-          status == AMD_DBGAPI_STATUS_SUCCESS)
+      if (!g_wave_filter.match_stop_reason (stop_reason))
         {
-          DBGAPI_CHECK (amd_dbgapi_dispatch_get_info (
-              dispatch_id, AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS,
-              sizeof (decltype (kernel_entry)::value_type),
-              &kernel_entry.emplace ()));
+          ++filtered_waves;
+          continue;
+        }
+
+      if (g_wave_filter.filters_agents ())
+        {
+          amd_dbgapi_agent_id_t agent_id;
+          DBGAPI_CHECK (amd_dbgapi_wave_get_info (
+              wave_id, AMD_DBGAPI_WAVE_INFO_AGENT, sizeof (agent_id),
+              &agent_id));
+
+          auto [it, inserted] = os_agent_ids.try_emplace (agent_id.handle);
+          if (inserted)
+            DBGAPI_CHECK (amd_dbgapi_agent_get_info (
+                agent_id, AMD_DBGAPI_AGENT_INFO_OS_ID, sizeof (it->second),
+                &it->second));
+
+          if (!g_wave_filter.match_agent (it->second))
+            {
+              ++filtered_waves;
+              continue;
+            }
+        }
+
+      std::optional<amd_dbgapi_dispatch_id_t> dispatch_id;
+      if (auto status = amd_dbgapi_wave_get_info (
+              wave_id, AMD_DBGAPI_WAVE_INFO_DISPATCH,
+              sizeof (decltype (dispatch_id)::value_type),
+              &dispatch_id.emplace ());
+          status != AMD_DBGAPI_STATUS_SUCCESS)
+        {
+          /* The only possible error is NOT_AVAILABLE if the ttmp registers
+             weren't initialized when the wave was created.  */
+          if (status != AMD_DBGAPI_STATUS_ERROR_NOT_AVAILABLE)
+            agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)", status);
+          dispatch_id.reset ();
         }
-      /* The only possible error is NOT_AVAILABLE if the ttmp registers weren't
-         initialized when the wave was created.  */
-      else if (status != AMD_DBGAPI_STATUS_ERROR_NOT_AVAILABLE)
+
+      if (!g_wave_filter.match_dispatch (
+              dispatch_id ? std::make_optional (dispatch_id->handle)
+                          : std::nullopt))
         {
-          agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)", status);
+          ++filtered_waves;
+          continue;
         }
 
+      amd_dbgapi_global_address_t pc;
+      DBGAPI_CHECK (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_PC,
+                                              sizeof (pc), &pc));
+
+      std::optional<amd_dbgapi_global_address_t> kernel_entry;
+      if (dispatch_id)
+        DBGAPI_CHECK (amd_dbgapi_dispatch_get_info (
+            *dispatch_id, AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS,
+            sizeof (decltype (kernel_entry)::value_type),
+            &kernel_entry.emplace ()));
+
       /* Find the code object that contains this pc.  */
-      code_object_t *code_object_found{ nullptr };
-      if (auto it = code_object_map.upper_bound (pc);
-          it != code_object_map.begin ())
-        if (auto &&[load_address, code_object] = *std::prev (it);
-            (pc - load_address) <= code_object.mem_size ())
-          code_object_found = &code_object;
+      code_object_t *code_object_found
+          = find_code_object (code_object_map, pc);
 
-      if (i)
-        agent_out << std::endl;
+      wave_info_t wave_info{ wave_id.handle, pc, stop_reason, kernel_entry,
+                             std::nullopt, std::nullopt };
+      if (dispatch_id)
+        wave_info.m_dispatch_id.emplace (dispatch_id->handle);
 
-      agent_out << "--------------------------------------------------------"
-                << std::endl;
+      if (kernel_entry && code_object_found)
+        if (auto symbol = code_object_found->find_symbol (*kernel_entry))
+          wave_info.m_kernel_name.emplace (symbol->m_name);
+
+      if (!g_wave_filter.match_kernel_name (wave_info.m_kernel_name))
+        {
+          ++filtered_waves;
+          continue;
+        }
 
-      agent_out << "wave_" << std::dec << wave_id.handle << ": pc=0x"
-                << std::hex << pc << " (kernel_code_entry=";
+      if (auto max_waves = g_wave_filter.max_waves ();
+          max_waves && waves.size () == *max_waves)
+        {
+          agent_log (log_level_t::info,
+                     "the dump was limited to %zu wavefronts", *max_waves);
+          break;
+        }
 
-      if (kernel_entry)
+      if (g_dispatch_history)
         {
-          agent_out << "0x" << std::hex << *kernel_entry;
+          amd_dbgapi_queue_id_t queue_id;
+          DBGAPI_CHECK (amd_dbgapi_wave_get_info (
+              wave_id, AMD_DBGAPI_WAVE_INFO_QUEUE, sizeof (queue_id),
+              &queue_id));
+
+          auto [it, inserted] = queue_ids.try_emplace (queue_id.handle);
+          if (inserted)
+            {
+              amd_dbgapi_global_address_t address;
+              DBGAPI_CHECK (amd_dbgapi_queue_get_info (
+                  queue_id, AMD_DBGAPI_QUEUE_INFO_ADDRESS, sizeof (address),
+                  &address));
+              it->second = g_dispatch_history->queue_id (address);
+            }
 
-          if (code_object_found)
-            if (auto symbol = code_object_found->find_symbol (*kernel_entry))
-              agent_out << " <" << symbol->m_name << ">";
+          wave_info.m_queue_id = it->second;
         }
-      else
-        agent_out << "not available";
 
-      agent_out << ")";
+      waves.push_back ({ wave_id, std::move (wave_info), code_object_found });
+    }
 
-      std::string stop_reason_str;
-      auto stop_reason_bits{ stop_reason };
-      do
-        {
-          /* Consume one bit from the stop reason.  */
-          auto one_bit
-              = stop_reason_bits ^ (stop_reason_bits & (stop_reason_bits - 1));
-          stop_reason_bits ^= one_bit;
+  free (wave_ids);
 
-          if (!stop_reason_str.empty ())
-            stop_reason_str += "|";
+  if (filtered_waves)
+    agent_log (log_level_t::info, "%zu wavefronts were filtered out",
+               filtered_waves);
 
-          stop_reason_str += [] (amd_dbgapi_wave_stop_reasons_t reason) {
-            switch (reason)
-              {
-              case AMD_DBGAPI_WAVE_STOP_REASON_NONE:
-                return "NONE";
-              case AMD_DBGAPI_WAVE_STOP_REASON_BREAKPOINT:
-                return "BREAKPOINT";
-              case AMD_DBGAPI_WAVE_STOP_REASON_WATCHPOINT:
-                return "WATCHPOINT";
-              case AMD_DBGAPI_WAVE_STOP_REASON_SINGLE_STEP:
-                return "SINGLE_STEP";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_INPUT_DENORMAL:
-                return "FP_INPUT_DENORMAL";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_DIVIDE_BY_0:
-                return "FP_DIVIDE_BY_0";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_OVERFLOW:
-                return "FP_OVERFLOW";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_UNDERFLOW:
-                return "FP_UNDERFLOW";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_INEXACT:
-                return "FP_INEXACT";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FP_INVALID_OPERATION:
-                return "FP_INVALID_OPERATION";
-              case AMD_DBGAPI_WAVE_STOP_REASON_INT_DIVIDE_BY_0:
-                return "INT_DIVIDE_BY_0";
-              case AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP:
-                return "DEBUG_TRAP";
-              case AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP:
-                return "ASSERT_TRAP";
-              case AMD_DBGAPI_WAVE_STOP_REASON_TRAP:
-                return "TRAP";
-              case AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION:
-                return "MEMORY_VIOLATION";
-              case AMD_DBGAPI_WAVE_STOP_REASON_ADDRESS_ERROR:
-                return "ADDRESS_ERROR";
-              case AMD_DBGAPI_WAVE_STOP_REASON_ILLEGAL_INSTRUCTION:
-                return "ILLEGAL_INSTRUCTION";
-              case AMD_DBGAPI_WAVE_STOP_REASON_ECC_ERROR:
-                return "ECC_ERROR";
-              case AMD_DBGAPI_WAVE_STOP_REASON_FATAL_HALT:
-                return "FATAL_HALT";
-#if AMD_DBGAPI_VERSION_MAJOR == 0 && AMD_DBGAPI_VERSION_MINOR < 58
-              case AMD_DBGAPI_WAVE_STOP_REASON_RESERVED:
-                return "RESERVED";
-#endif
-              }
-            return "";
-          }(static_cast<amd_dbgapi_wave_stop_reasons_t> (one_bit));
-      } while (stop_reason_bits);
+  auto print_registers = [] (const dumped_wave_t &wave) {
+    if (g_dump_detail < dump_detail_t::registers)
+      return;
 
-      agent_out << " (";
-      if (stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_NONE)
-        agent_out << "stopped, reason: " << stop_reason_str;
-      else
-        agent_out << "running";
-      agent_out << ")" << std::endl;
+    auto classes = collect_registers (wave.m_wave_id);
 
-      print_registers (wave_id);
-      print_local_memory (wave_id);
+    stats::scoped_timer_t timer (stats::timer_t::output);
+    g_dump_writer->registers (wave.m_info.m_wave_id, classes);
+  };
 
-      if (code_object_found)
-        {
-          amd_dbgapi_architecture_id_t architecture_id;
-          DBGAPI_CHECK (amd_dbgapi_wave_get_info (
-              wave_id, AMD_DBGAPI_WAVE_INFO_ARCHITECTURE,
-              sizeof (architecture_id), &architecture_id));
+  auto print_memory_and_code = [] (const dumped_wave_t &wave) {
+    if (g_dump_detail < dump_detail_t::full)
+      return;
 
-          /* Disassemble instructions around `pc`  */
-          code_object_found->disassemble (architecture_id, pc);
-        }
-      else
+    auto contents = read_local_memory (wave.m_wave_id);
+    {
+      stats::scoped_timer_t timer (stats::timer_t::output);
+      g_dump_writer->local_memory (wave.m_info.m_wave_id, contents);
+    }
+
+    if (wave.m_code_object)
+      {
+        amd_dbgapi_architecture_id_t architecture_id;
+        DBGAPI_CHECK (amd_dbgapi_wave_get_info (
+            wave.m_wave_id, AMD_DBGAPI_WAVE_INFO_ARCHITECTURE,
+            sizeof (architecture_id), &architecture_id));
+
+        /* Disassemble instructions around `pc`  */
+        std::optional<stats::scoped_timer_t> timer;
+        timer.emplace (stats::timer_t::disassembly);
+        auto disassembly = wave.m_code_object->disassemble (
+            architecture_id, wave.m_info.m_pc);
+
+        timer.emplace (stats::timer_t::output);
+        g_dump_writer->disassembly (wave.m_info.m_wave_id, disassembly);
+      }
+    else
+      {
+        /* TODO: Add disassembly even if we did not find a code object  */
+      }
+  };
+
+  if (!g_dump_budget)
+    {
+      for (auto &&wave : waves)
         {
-          /* TODO: Add disassembly even if we did not find a code object  */
+          g_dump_writer->wave (wave.m_info);
+          print_registers (wave);
+          print_memory_and_code (wave);
+          g_dump_writer->end_wave (wave.m_info.m_wave_id);
         }
     }
+  else
+    {
+      /* Print the dump in passes of increasing cost, so that the most useful
+         information is printed first if the budget is exhausted: a summary
+         of every wave, the registers of the waves that stopped because of
+         an exception, then their local memory and disassembly, and finally
+         the details of the other waves.  Each wave is printed once, in the
+         first pass; the writers attach the details printed by the later
+         passes to it using its wave id.  */
+      auto faulting = [] (const dumped_wave_t &wave) {
+        return wave.m_info.m_stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_NONE;
+      };
 
-  free (wave_ids);
+      bool complete = [&] () {
+        for (auto &&wave : waves)
+          {
+            if (budget_exhausted ())
+              return false;
+            g_dump_writer->wave (wave.m_info);
+            g_dump_writer->end_wave (wave.m_info.m_wave_id);
+          }
+
+        if (g_dump_detail == dump_detail_t::summary)
+          return true;
+
+        for (auto &&wave : waves)
+          if (faulting (wave))
+            {
+              if (budget_exhausted ())
+                return false;
+              print_registers (wave);
+              g_dump_writer->end_wave (wave.m_info.m_wave_id);
+            }
+
+        for (auto &&wave : waves)
+          if (faulting (wave) && g_dump_detail == dump_detail_t::full)
+            {
+              if (budget_exhausted ())
+                return false;
+              print_memory_and_code (wave);
+              g_dump_writer->end_wave (wave.m_info.m_wave_id);
+            }
+
+        for (auto &&wave : waves)
+          if (!faulting (wave))
+            {
+              if (budget_exhausted ())
+                return false;
+              print_registers (wave);
+              print_memory_and_code (wave);
+              g_dump_writer->end_wave (wave.m_info.m_wave_id);
+            }
+
+        return true;
+      }();
+
+      if (!complete)
+        agent_warning ("the wavefront dump was truncated because its budget "
+                       "was exhausted");
+    }
+
+  stats::add (stats::counter_t::waves_dumped, waves.size ());
+  end_dump ();
 }
 
 void
@@ -791,6 +1468,224 @@ print_usage ()
             << "                              "
                "is redirected to stderr."
             << std::endl;
+  std::cerr << "  -f, --format={text|binary|json}"
+            << std::endl
+            << "                              "
+               "Select the format of the wavefront dumps. The"
+            << std::endl
+            << "                              "
+               "binary format requires --output, and is"
+            << std::endl
+            << "                              "
+               "rendered by rocm-debug-agent-print. The json"
+            << std::endl
+            << "                              "
+               "format writes one JSON object per line. The"
+            << std::endl
+            << "                              "
+               "default format is 'text'."
+            << std::endl;
+  std::cerr << "      --flush-interval=MS     "
+               "Write the buffered output from a separate thread"
+            << std::endl
+            << "                              "
+               "at least every MS milliseconds. By default, the"
+            << std::endl
+            << "                              "
+               "output is written at the end of each dump."
+            << std::endl;
+  std::cerr << "      --stop-reason=LIST      "
+               "Only print the wavefronts stopped for one of the"
+            << std::endl
+            << "                              "
+               "comma separated stop reasons in LIST (e.g."
+            << std::endl
+            << "                              "
+               "memory_violation,assert_trap)."
+            << std::endl;
+  std::cerr << "      --kernel=PATTERN        "
+               "Only print the wavefronts executing a kernel"
+            << std::endl
+            << "                              "
+               "whose name matches the shell wildcard PATTERN."
+            << std::endl
+            << "                              "
+               "Can be repeated."
+            << std::endl;
+  std::cerr << "      --agent=LIST            "
+               "Only print the wavefronts running on one of the"
+            << std::endl
+            << "                              "
+               "agents with a KFD gpu_id in LIST."
+            << std::endl;
+  std::cerr << "      --dispatch=LIST         "
+               "Only print the wavefronts created by one of the"
+            << std::endl
+            << "                              "
+               "dispatches with an id in LIST, as printed in"
+            << std::endl
+            << "                              "
+               "the json and binary wavefront records."
+            << std::endl;
+  std::cerr << "      --max-waves=N           "
+               "Print at most N wavefronts per dump."
+            << std::endl;
+  std::cerr << "      --dump-budget=LIMITS    "
+               "Limit the duration and/or the size of a dump,"
+            << std::endl
+            << "                              "
+               "e.g. 5s,200MB. The most useful information is"
+            << std::endl
+            << "                              "
+               "printed first, and the dump is truncated when"
+            << std::endl
+            << "                              "
+               "either limit is exceeded. Opening the code"
+            << std::endl
+            << "                              "
+               "objects, stopping and selecting the wavefronts"
+            << std::endl
+            << "                              "
+               "count towards the duration but are always"
+            << std::endl
+            << "                              "
+               "completed."
+            << std::endl;
+  std::cerr << "      --hot-spots             "
+               "Instead of printing the wavefronts, print how"
+            << std::endl
+            << "                              "
+               "many are stopped at each function and source"
+            << std::endl
+            << "                              "
+               "line."
+            << std::endl;
+  std::cerr << "      --stop-timeout=MS       "
+               "Wait at most MS milliseconds for the wavefronts"
+            << std::endl
+            << "                              "
+               "to stop with --all, then print the wavefronts"
+            << std::endl
+            << "                              "
+               "that are stopped."
+            << std::endl;
+  std::cerr << "      --coalesce=MS           "
+               "Wait MS milliseconds for more exceptions before"
+            << std::endl
+            << "                              "
+               "printing the wavefronts, and print them all in"
+            << std::endl
+            << "                              "
+               "a single dump."
+            << std::endl;
+  std::cerr << "      --throttle=N            "
+               "Only print the first N dumps of the same exception"
+            << std::endl
+            << "                              "
+               "(kernel, pc and stop reason), and count the next"
+            << std::endl
+            << "                              "
+               "ones."
+            << std::endl;
+  std::cerr << "      --throttle-summary=S    "
+               "Summarize the throttled dumps every S seconds"
+            << std::endl
+            << "                              "
+               "(default 60)."
+            << std::endl;
+  std::cerr << "      --dispatch-history[=N]  "
+               "Record the kernels dispatched to each queue, and"
+            << std::endl
+            << "                              "
+               "print the last N (default 16) with the wavefronts."
+            << std::endl;
+  std::cerr << "      --stats                 "
+               "Collect timing statistics about the agent, and"
+            << std::endl
+            << "                              "
+               "print them on exit and after each SIGQUIT dump."
+            << std::endl;
+  std::cerr << "      --control-socket[=PATH] "
+               "Serve requests for code objects, wavefront"
+            << std::endl
+            << "                              "
+               "counts, statistics, and filtered dumps on a Unix"
+            << std::endl
+            << "                              "
+               "socket (default $XDG_RUNTIME_DIR/"
+            << std::endl
+            << "                              "
+               "rocm-debug-agent.PID)."
+            << std::endl;
+  std::cerr << "      --profile=HZ            "
+               "Sample the pc of all the wavefronts HZ times per"
+            << std::endl
+            << "                              "
+               "second (at most 10000), and write the profile on"
+            << std::endl
+            << "                              "
+               "exit."
+            << std::endl;
+  std::cerr << "      --profile-output=PREFIX "
+               "Write the profile to PREFIX.folded and PREFIX.pb"
+            << std::endl
+            << "                              "
+               "(default rocm-debug-agent.PID)."
+            << std::endl;
+  std::cerr << "      --hang-threshold=MS     "
+               "Print all the wavefronts when a host thread has"
+            << std::endl
+            << "                              "
+               "been waiting on an HSA signal for MS milliseconds"
+            << std::endl
+            << "                              "
+               "(at most once per minute)."
+            << std::endl;
+  std::cerr << "      --flight-recorder[=KB]  "
+               "Record the messages that are not printed because"
+            << std::endl
+            << "                              "
+               "of the log level in a KB kilobytes ring buffer"
+            << std::endl
+            << "                              "
+               "(1024 by default), and print them before an"
+            << std::endl
+            << "                              "
+               "exception or hang dump, a dump requested by a"
+            << std::endl
+            << "                              "
+               "signal, and an error."
+            << std::endl;
+  std::cerr << "      --defer-attach          "
+               "Attach to the process when the first executable"
+            << std::endl
+            << "                              "
+               "is frozen instead of when the agent is loaded, so"
+            << std::endl
+            << "                              "
+               "that processes that never load GPU code do not"
+            << std::endl
+            << "                              "
+               "pay for it.  The signals received, and the"
+            << std::endl
+            << "                              "
+               "errors of the kernels ROCr runs internally (blit"
+            << std::endl
+            << "                              "
+               "kernels), before the application freezes its"
+            << std::endl
+            << "                              "
+               "first executable are not reported."
+            << std::endl;
+  std::cerr << "      --signals=LIST          "
+               "Print all the wavefronts when one of the signals"
+            << std::endl
+            << "                              "
+               "in LIST, a comma separated list of names or"
+            << std::endl
+            << "                              "
+               "numbers, is received (default QUIT)."
+            << std::endl;
   std::cerr << "  -d, --disable-linux-signals "
                "Disable installing a SIGQUIT signal handler, so"
             << std::endl
@@ -815,58 +1710,401 @@ print_usage ()
   abort ();
 }
 
-/* Called when we expect dbgapi events to be present.  Fetch all events from
-   dbgapi and act on the required events.  */
+/* Parse STR as an unsigned decimal number.  Return an empty optional if STR
+   is not a valid number.  */
 
-void
-process_dbgapi_events (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
+std::optional<uint64_t>
+parse_unsigned (const std::string &str)
 {
-  /* Consume all events available in the queue.  */
-  bool need_print_waves = false;
-  bool wave_need_resume = false;
-  while (true)
-    {
-      amd_dbgapi_event_id_t event_id;
-      amd_dbgapi_event_kind_t event_kind;
-      DBGAPI_CHECK (amd_dbgapi_process_next_pending_event (
-          process_id, &event_id, &event_kind));
+  if (str.empty () || !isdigit (str[0]))
+    return std::nullopt;
 
-      if (event_kind == AMD_DBGAPI_EVENT_KIND_NONE)
-        break;
+  char *end;
+  errno = 0;
+  uint64_t value = strtoull (str.c_str (), &end, 10);
+  if (errno || *end != '\0')
+    return std::nullopt;
 
-      switch (event_kind)
-        {
-        case AMD_DBGAPI_EVENT_KIND_WAVE_STOP:
-          {
-            /* Fetch the stop reason.  For a debug trap, we just resume
-               execution.  */
-            amd_dbgapi_wave_stop_reasons_t stop_reason;
-            amd_dbgapi_wave_id_t wave_id;
-            DBGAPI_CHECK (amd_dbgapi_event_get_info (
-                event_id, AMD_DBGAPI_EVENT_INFO_WAVE, sizeof (wave_id),
-                &wave_id));
-            DBGAPI_CHECK (amd_dbgapi_wave_get_info (
-                wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON,
-                sizeof (stop_reason), &stop_reason));
+  return value;
+}
 
-            if (stop_reason == AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP)
-              {
-                /* This wave will be silently resumed at the end of this
-                   procedure.  */
-                wave_need_resume = true;
-              }
-            else
-              need_print_waves = true;
-            break;
-          }
+/* Parse STR, a comma separated list of signal names, with or without their
+   "SIG" prefix (e.g. "QUIT,SIGUSR1"), or numbers.  Return an empty optional
+   if STR is not valid, or contains a signal whose default action cannot be
+   replaced by a dump request.  */
 
-        case AMD_DBGAPI_EVENT_KIND_QUEUE_ERROR:
-          {
-            need_print_waves = true;
-            break;
-          }
+std::optional<std::vector<int>>
+parse_signals (const std::string &str)
+{
+  static const std::pair<const char *, int> signal_names[]
+      = { { "HUP", SIGHUP },   { "INT", SIGINT },   { "QUIT", SIGQUIT },
+          { "USR1", SIGUSR1 }, { "USR2", SIGUSR2 }, { "TERM", SIGTERM },
+          { "WINCH", SIGWINCH }, { "PWR", SIGPWR } };
 
-        case AMD_DBGAPI_EVENT_KIND_RUNTIME:
+  /* The signals sent on faults, or that cannot be caught.  */
+  static const int reserved_signals[]
+      = { SIGILL, SIGTRAP, SIGABRT, SIGBUS, SIGFPE,
+          SIGKILL, SIGSEGV, SIGSTOP, SIGSYS };
+
+  std::vector<int> signals;
+  std::istringstream stream (str);
+  std::string name;
+
+  while (std::getline (stream, name, ','))
+    {
+      std::transform (name.begin (), name.end (), name.begin (),
+                      [] (unsigned char c) { return toupper (c); });
+      if (name.compare (0, 3, "SIG") == 0)
+        name.erase (0, 3);
+
+      std::optional<int> signal;
+      if (auto number = parse_unsigned (name))
+        {
+          if (*number > 0 && *number < static_cast<uint64_t> (NSIG))
+            signal = *number;
+        }
+      else
+        for (auto &&[signal_name, signal_number] : signal_names)
+          if (name == signal_name)
+            signal = signal_number;
+
+      if (!signal
+          || std::find (std::begin (reserved_signals),
+                        std::end (reserved_signals), *signal)
+                 != std::end (reserved_signals))
+        return std::nullopt;
+
+      signals.emplace_back (*signal);
+    }
+
+  if (signals.empty ())
+    return std::nullopt;
+
+  return signals;
+}
+
+/* Parse STR, a comma separated list of a duration (e.g. "500ms", "5s" or
+   "2min") and/or a size (e.g. "64KB", "200MB" or "1GB"), into a dump budget.
+   Return an empty optional if STR is not valid.  */
+
+std::optional<dump_budget_t>
+parse_dump_budget (const std::string &str)
+{
+  dump_budget_t budget;
+  std::istringstream stream (str);
+  std::string limit;
+
+  while (std::getline (stream, limit, ','))
+    {
+      size_t unit_pos = limit.find_first_not_of ("0123456789");
+      if (unit_pos == 0 || unit_pos == std::string::npos)
+        return std::nullopt;
+
+      auto value = parse_unsigned (limit.substr (0, unit_pos));
+      if (!value)
+        return std::nullopt;
+
+      std::string unit = limit.substr (unit_pos);
+      std::transform (unit.begin (), unit.end (), unit.begin (),
+                      [] (unsigned char c) { return tolower (c); });
+
+      if (unit == "ms")
+        budget.m_time.emplace (*value);
+      else if (unit == "s")
+        budget.m_time.emplace (*value * 1000);
+      else if (unit == "min")
+        budget.m_time.emplace (*value * 60 * 1000);
+      else if (unit == "b")
+        budget.m_size.emplace (*value);
+      else if (unit == "k" || unit == "kb" || unit == "kib")
+        budget.m_size.emplace (*value << 10);
+      else if (unit == "m" || unit == "mb" || unit == "mib")
+        budget.m_size.emplace (*value << 20);
+      else if (unit == "g" || unit == "gb" || unit == "gib")
+        budget.m_size.emplace (*value << 30);
+      else
+        return std::nullopt;
+    }
+
+  if (!budget.m_time && !budget.m_size)
+    return std::nullopt;
+
+  return budget;
+}
+
+/* Return the exceptions to deliver to the runtime when resuming a wave
+   stopped for STOP_REASON.  */
+
+amd_dbgapi_exceptions_t
+resume_exceptions (uint64_t stop_reason)
+{
+  std::underlying_type_t<amd_dbgapi_exceptions_t> resume_exceptions = 0;
+  auto stop_reason_bits{ stop_reason };
+
+  while (stop_reason_bits != 0)
+    {
+      auto one_bit
+          = stop_reason_bits ^ (stop_reason_bits & (stop_reason_bits - 1));
+      stop_reason_bits ^= one_bit;
+
+      switch (one_bit)
+        {
+        case AMD_DBGAPI_WAVE_STOP_REASON_NONE:
+        case AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_NONE;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_BREAKPOINT:
+        case AMD_DBGAPI_WAVE_STOP_REASON_WATCHPOINT:
+        case AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP:
+        case AMD_DBGAPI_WAVE_STOP_REASON_TRAP:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_TRAP;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_SINGLE_STEP:
+          /* Is this even possible?  */
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_NONE;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_INPUT_DENORMAL:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_DIVIDE_BY_0:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_OVERFLOW:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_UNDERFLOW:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_INEXACT:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FP_INVALID_OPERATION:
+        case AMD_DBGAPI_WAVE_STOP_REASON_INT_DIVIDE_BY_0:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_MATH_ERROR;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_MEMORY_VIOLATION;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_ADDRESS_ERROR:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_ADDRESS_ERROR;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_ILLEGAL_INSTRUCTION:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_ILLEGAL_INSTRUCTION;
+          break;
+
+        case AMD_DBGAPI_WAVE_STOP_REASON_ECC_ERROR:
+        case AMD_DBGAPI_WAVE_STOP_REASON_FATAL_HALT:
+          resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_ABORT;
+          break;
+
+#if AMD_DBGAPI_VERSION_MAJOR == 0 && AMD_DBGAPI_VERSION_MINOR < 58
+        case AMD_DBGAPI_WAVE_STOP_REASON_RESERVED:
+          break;
+#endif
+        }
+    }
+
+  return static_cast<amd_dbgapi_exceptions_t> (resume_exceptions);
+}
+
+/* Resume the waves in g_waves_to_resume, and clear it.  The memory cached
+   while they were stopped is dropped.  */
+
+void
+resume_stopped_waves ()
+{
+  g_memory_cache->disable ();
+
+  for (auto &&[handle, stop_reason] : g_waves_to_resume)
+    {
+      amd_dbgapi_wave_id_t wave_id{ handle };
+
+      if (!stop_reason)
+        {
+          std::underlying_type_t<amd_dbgapi_wave_stop_reasons_t> reason;
+          if (amd_dbgapi_status_t status = amd_dbgapi_wave_get_info (
+                  wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON, sizeof (reason),
+                  &reason);
+              status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
+            {
+              /* The wave terminated while it was stopped (for example, its
+                 queue was destroyed).  There is nothing to resume.  */
+              continue;
+            }
+          else if (status != AMD_DBGAPI_STATUS_SUCCESS)
+            agent_error ("amd_dbgapi_wave_get_info failed (rc=%d)", status);
+          stop_reason.emplace (reason);
+        }
+
+      if (amd_dbgapi_status_t status
+          = amd_dbgapi_wave_resume (wave_id, AMD_DBGAPI_RESUME_MODE_NORMAL,
+                                    resume_exceptions (*stop_reason));
+          status == AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
+        agent_log (log_level_t::info, "wave_%ld terminated while stopped",
+                   handle);
+      else if (status != AMD_DBGAPI_STATUS_SUCCESS)
+        agent_error ("amd_dbgapi_wave_resume failed (rc=%d)", status);
+    }
+
+  g_waves_to_resume.clear ();
+}
+
+/* Report the r_debug breakpoint hit to dbgapi if code object list updates
+   were requested since the last report, so that dbgapi reads the new code
+   object list.  */
+
+void
+report_code_object_list_updates ()
+{
+  if (!g_code_object_update_pending.exchange (false,
+                                              std::memory_order_acq_rel))
+    return;
+
+  if (g_rbrk_breakpoint_id)
+    {
+      amd_dbgapi_breakpoint_action_t bpaction;
+      DBGAPI_CHECK (amd_dbgapi_report_breakpoint_hit (*g_rbrk_breakpoint_id,
+                                                      0, &bpaction));
+    }
+
+  stats::add (stats::counter_t::code_object_reports);
+}
+
+/* Halt the process, print the waves if NEED_PRINT_WAVES, and resume the waves
+   that were stopped.  */
+
+void
+print_and_resume_waves (amd_dbgapi_process_id_t process_id,
+                        bool need_print_waves, bool all_wavefronts)
+{
+  /* The code objects unloaded since the last report are still in the dbgapi
+     code object list, make sure it is current before using it.  */
+  report_code_object_list_updates ();
+
+  /* TODO, we  should have a RAII object to handle forward progress wave
+     creation mode override.  */
+  DBGAPI_CHECK (amd_dbgapi_process_set_progress (
+      process_id, AMD_DBGAPI_PROGRESS_NO_FORWARD));
+
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_STOP);
+
+  if (need_print_waves)
+    print_wavefronts (process_id, all_wavefronts);
+
+  /* We now need to resume execution of the waves that were stopped.  This
+     will allow any exception to be delivered to the runtime who will be able
+     to act on it if required.  */
+  resume_stopped_waves ();
+
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_NORMAL);
+
+  DBGAPI_CHECK (amd_dbgapi_process_set_progress (process_id,
+                                                 AMD_DBGAPI_PROGRESS_NORMAL));
+}
+
+/* Check the signal waits of the host threads, and print the waves if one of
+   them has been waiting for longer than the hang threshold.  */
+
+void
+check_hangs (amd_dbgapi_process_id_t process_id)
+{
+  const auto now = std::chrono::steady_clock::now ();
+  if (!g_hang_detector || now < g_next_hang_check)
+    return;
+  g_next_hang_check = now + g_hang_check_period;
+
+  auto hangs = g_hang_detector->check ();
+  if (hangs.empty ())
+    return;
+
+  using msec = std::chrono::duration<double, std::milli>;
+  for (auto &&hang : hangs)
+    agent_warning ("thread %d has been waiting on signal %#llx for %.0f ms",
+                   hang.m_thread_id,
+                   static_cast<unsigned long long> (hang.m_signal),
+                   msec (hang.m_duration).count ());
+
+  if (g_last_hang_dump && now - *g_last_hang_dump < hang_dump_interval)
+    {
+      agent_log (log_level_t::info,
+                 "the hang dump was suppressed, one was printed less than "
+                 "%ld s ago",
+                 static_cast<long> (hang_dump_interval.count ()));
+      return;
+    }
+  g_last_hang_dump = now;
+
+  write_flight_recorder ();
+  print_and_resume_waves (process_id, true, true);
+}
+
+/* Consume all the events available in the dbgapi event queue.  The stopped
+   waves are recorded in g_waves_to_resume.  Return true if the waves need to
+   be printed.  */
+
+bool
+drain_dbgapi_events (amd_dbgapi_process_id_t process_id)
+{
+  bool need_print_waves = false;
+  /* The straggling waves that stopped without an exception.  */
+  std::vector<amd_dbgapi_wave_id_t> late_waves;
+
+  while (true)
+    {
+      amd_dbgapi_event_id_t event_id;
+      amd_dbgapi_event_kind_t event_kind;
+      DBGAPI_CHECK (amd_dbgapi_process_next_pending_event (
+          process_id, &event_id, &event_kind));
+
+      if (event_kind == AMD_DBGAPI_EVENT_KIND_NONE)
+        break;
+
+      switch (event_kind)
+        {
+        case AMD_DBGAPI_EVENT_KIND_WAVE_STOP:
+          {
+            /* Fetch the stop reason.  For a debug trap, we just resume
+               execution.  */
+            amd_dbgapi_wave_stop_reasons_t stop_reason;
+            amd_dbgapi_wave_id_t wave_id;
+            DBGAPI_CHECK (amd_dbgapi_event_get_info (
+                event_id, AMD_DBGAPI_EVENT_INFO_WAVE, sizeof (wave_id),
+                &wave_id));
+            DBGAPI_CHECK (amd_dbgapi_wave_get_info (
+                wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON,
+                sizeof (stop_reason), &stop_reason));
+
+            /* A straggling wave stopped after the stop cycle that requested
+               it, it only needs to be resumed.  */
+            if (g_straggling_waves.erase (wave_id.handle)
+                && stop_reason == AMD_DBGAPI_WAVE_STOP_REASON_NONE)
+              {
+                late_waves.push_back (wave_id);
+                break;
+              }
+
+            /* This wave will be resumed at the end of the stop cycle.  */
+            g_waves_to_resume.insert_or_assign (wave_id.handle, stop_reason);
+
+            if (stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP)
+              need_print_waves = true;
+            break;
+          }
+
+        case AMD_DBGAPI_EVENT_KIND_QUEUE_ERROR:
+          {
+            need_print_waves = true;
+            break;
+          }
+
+        case AMD_DBGAPI_EVENT_KIND_WAVE_COMMAND_TERMINATED:
+          {
+            /* A straggling wave terminated before it stopped.  */
+            amd_dbgapi_wave_id_t wave_id;
+            DBGAPI_CHECK (amd_dbgapi_event_get_info (
+                event_id, AMD_DBGAPI_EVENT_INFO_WAVE, sizeof (wave_id),
+                &wave_id));
+            g_straggling_waves.erase (wave_id.handle);
+            break;
+          }
+
+        case AMD_DBGAPI_EVENT_KIND_RUNTIME:
         case AMD_DBGAPI_EVENT_KIND_CODE_OBJECT_LIST_UPDATED:
         case AMD_DBGAPI_EVENT_KIND_BREAKPOINT_RESUME:
           /* Ignore.  */
@@ -883,128 +2121,635 @@ process_dbgapi_events (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
       DBGAPI_CHECK (amd_dbgapi_event_processed (event_id));
     }
 
-  /* Some events do not require us to do anythig more.  If so, just return
-     early.  */
-  if (!need_print_waves && !wave_need_resume)
+  for (auto &&wave_id : late_waves)
+    {
+      agent_log (log_level_t::info,
+                 "wave_%ld stopped after the stop timeout, resuming it",
+                 wave_id.handle);
+
+      if (amd_dbgapi_status_t status
+          = amd_dbgapi_wave_resume (wave_id, AMD_DBGAPI_RESUME_MODE_NORMAL,
+                                    AMD_DBGAPI_EXCEPTION_NONE);
+          status != AMD_DBGAPI_STATUS_SUCCESS
+          && status != AMD_DBGAPI_STATUS_ERROR_INVALID_WAVE_ID)
+        agent_error ("amd_dbgapi_wave_resume failed (rc=%d)", status);
+    }
+
+  return need_print_waves;
+}
+
+/* Return the signature of the exception raised by each wave in
+   g_waves_to_resume.  A queue error that is not reported with a wave
+   exception has a signature of its own.  */
+
+std::vector<dump_throttle_t::signature_t>
+exception_signatures ()
+{
+  std::vector<dump_throttle_t::signature_t> signatures;
+
+  for (auto &&[handle, stop_reason] : g_waves_to_resume)
+    {
+      if (!stop_reason || *stop_reason == AMD_DBGAPI_WAVE_STOP_REASON_NONE
+          || *stop_reason == AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP)
+        continue;
+
+      amd_dbgapi_wave_id_t wave_id{ handle };
+      dump_throttle_t::signature_t signature{ 0, 0, *stop_reason };
+
+      DBGAPI_CHECK (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_PC,
+                                              sizeof (signature.m_pc),
+                                              &signature.m_pc));
+
+      amd_dbgapi_dispatch_id_t dispatch_id;
+      if (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_DISPATCH,
+                                    sizeof (dispatch_id), &dispatch_id)
+          == AMD_DBGAPI_STATUS_SUCCESS)
+        DBGAPI_CHECK (amd_dbgapi_dispatch_get_info (
+            dispatch_id, AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS,
+            sizeof (signature.m_kernel_entry), &signature.m_kernel_entry));
+
+      signatures.push_back (signature);
+    }
+
+  if (signatures.empty ())
+    signatures.push_back ({ 0, 0, AMD_DBGAPI_WAVE_STOP_REASON_NONE });
+
+  return signatures;
+}
+
+/* Return true if a wave in g_waves_to_resume stopped on an exception.  The
+   stop reasons that are not known yet are read.  */
+
+bool
+stopped_on_exception ()
+{
+  bool exception = false;
+
+  for (auto &&[handle, stop_reason] : g_waves_to_resume)
+    {
+      if (!stop_reason)
+        {
+          std::underlying_type_t<amd_dbgapi_wave_stop_reasons_t> reason;
+          if (amd_dbgapi_wave_get_info (
+                  amd_dbgapi_wave_id_t{ handle },
+                  AMD_DBGAPI_WAVE_INFO_STOP_REASON, sizeof (reason), &reason)
+              != AMD_DBGAPI_STATUS_SUCCESS)
+            continue;
+          stop_reason.emplace (reason);
+        }
+
+      if (*stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_NONE
+          && *stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP)
+        exception = true;
+    }
+
+  return exception;
+}
+
+/* Print a one line summary of the dumps suppressed by g_dump_throttle if it
+   is due, or if FORCE is true.  */
+
+void
+print_throttle_summary (bool force)
+{
+  auto now = std::chrono::steady_clock::now ();
+  auto summary = g_dump_throttle.take_summary (now, force);
+  if (!summary)
     return;
 
-  /* TODO, we  should have a RAII object to handle forward progress wave
-     creation mode override.  */
+  agent_warning (
+      "suppressed %zu dumps of %zu exception signatures (%zu wavefronts) "
+      "in the last %lld s",
+      summary->m_dump_count, summary->m_signature_count,
+      summary->m_wave_count,
+      static_cast<long long> (
+          std::chrono::duration_cast<std::chrono::seconds> (summary->m_period)
+              .count ()));
+}
+
+/* Print the waves stopped by an exception in this stop cycle, and resume
+   them.  */
+
+void
+print_exception_waves (amd_dbgapi_process_id_t process_id,
+                       bool all_wavefronts)
+{
+  /* If all the exceptions were already dumped enough times, only count them
+     and resume the waves.  */
+  if (g_dump_throttle.enabled ()
+      && !g_dump_throttle.record (exception_signatures (),
+                                  std::chrono::steady_clock::now ()))
+    {
+      agent_log (log_level_t::verbose,
+                 "suppressed the dump of %zu stopped wavefronts",
+                 g_waves_to_resume.size ());
+
+      resume_stopped_waves ();
+      print_throttle_summary (false);
+      return;
+    }
+
+  write_flight_recorder ();
+  print_and_resume_waves (process_id, true, all_wavefronts);
+}
+
+/* The code objects containing the sampled pcs.  They are kept open so that
+   the profile can be symbolized at the end, even if they were unloaded.  A
+   code object replaced by another one at the same address is closed, the
+   pcs sampled in it are attributed to the new one.  */
+code_object_map_t g_profile_code_objects;
+
+/* The kernel code entry address of the dispatches seen by the profiler.  */
+std::unordered_map<decltype (amd_dbgapi_dispatch_id_t::handle),
+                   amd_dbgapi_global_address_t>
+    g_profile_kernel_entries;
+
+/* Open the code objects loaded since the last call.  */
+
+void
+update_profile_code_objects (amd_dbgapi_process_id_t process_id)
+{
+  report_code_object_list_updates ();
+
+  amd_dbgapi_code_object_id_t *code_objects_id;
+  size_t code_object_count;
+  DBGAPI_CHECK (amd_dbgapi_process_code_object_list (
+      process_id, &code_object_count, &code_objects_id, nullptr));
+
+  for (size_t i = 0; i < code_object_count; ++i)
+    {
+      code_object_t code_object (code_objects_id[i]);
+
+      auto it = g_profile_code_objects.find (code_object.load_address ());
+      if (it != g_profile_code_objects.end ()
+          && it->second.uri () == code_object.uri ())
+        continue;
+
+      code_object.open ();
+      if (!code_object.is_open ())
+        continue;
+
+      if (it != g_profile_code_objects.end ())
+        g_profile_code_objects.erase (it);
+      g_profile_code_objects.emplace (code_object.load_address (),
+                                      std::move (code_object));
+    }
+  free (code_objects_id);
+}
+
+/* Stop all the waves, count the kernel entry and pc of each in the profile,
+   and resume them.  Only these are read while the waves are stopped, the
+   code objects needed to symbolize new pcs are opened after the waves are
+   resumed.  If a wave stopped on an exception meanwhile, the waves are
+   printed as if its event had been processed.  */
+
+void
+sample_wavefronts (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
+{
+  const auto start = std::chrono::steady_clock::now ();
+
   DBGAPI_CHECK (amd_dbgapi_process_set_progress (
       process_id, AMD_DBGAPI_PROGRESS_NO_FORWARD));
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_STOP);
+
+  bool need_print_waves = stop_all_wavefronts (process_id);
+  /* See print_wavefronts.  */
+  if (g_straggling_waves.empty ())
+    g_memory_cache->enable ();
+  bool need_code_objects = false;
+
+  for (auto &&[handle, stop_reason] : g_waves_to_resume)
+    {
+      amd_dbgapi_wave_id_t wave_id{ handle };
 
-  DBGAPI_CHECK (amd_dbgapi_process_set_wave_creation (
-      process_id, AMD_DBGAPI_WAVE_CREATION_STOP));
+      amd_dbgapi_global_address_t pc;
+      if (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_PC,
+                                    sizeof (pc), &pc)
+          != AMD_DBGAPI_STATUS_SUCCESS)
+        continue;
+
+      if (!stop_reason)
+        {
+          std::underlying_type_t<amd_dbgapi_wave_stop_reasons_t> reason;
+          DBGAPI_CHECK (amd_dbgapi_wave_get_info (
+              wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON, sizeof (reason),
+              &reason));
+          stop_reason.emplace (reason);
+        }
+
+      if (*stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_NONE
+          && *stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP)
+        need_print_waves = true;
+
+      amd_dbgapi_global_address_t kernel_entry{ 0 };
+      amd_dbgapi_dispatch_id_t dispatch_id;
+      if (amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_DISPATCH,
+                                    sizeof (dispatch_id), &dispatch_id)
+          == AMD_DBGAPI_STATUS_SUCCESS)
+        {
+          auto [it, inserted]
+              = g_profile_kernel_entries.try_emplace (dispatch_id.handle);
+          if (inserted
+              && amd_dbgapi_dispatch_get_info (
+                     dispatch_id,
+                     AMD_DBGAPI_DISPATCH_INFO_KERNEL_CODE_ENTRY_ADDRESS,
+                     sizeof (it->second), &it->second)
+                     != AMD_DBGAPI_STATUS_SUCCESS)
+            it->second = 0;
+          kernel_entry = it->second;
+        }
+
+      g_profile->add_sample (kernel_entry, pc);
+      if (!find_code_object (g_profile_code_objects, pc))
+        need_code_objects = true;
+    }
 
   if (need_print_waves)
-    print_wavefronts (process_id, all_wavefronts);
+    print_exception_waves (process_id, all_wavefronts);
+  else
+    resume_stopped_waves ();
 
-  /* We now need to resume execution of the waves present.  This will allow any
-     exception to be delivered to the runtime who will be able to act on it if
-     required.  */
-  amd_dbgapi_wave_id_t *wave_ids;
-  size_t wave_count;
-  DBGAPI_CHECK (amd_dbgapi_process_wave_list (process_id, &wave_count,
-                                              &wave_ids, nullptr));
-  std::unique_ptr<amd_dbgapi_wave_id_t, decltype (free) *> wave_ids_cleaner (
-      wave_ids, free);
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_NORMAL);
+  DBGAPI_CHECK (amd_dbgapi_process_set_progress (process_id,
+                                                 AMD_DBGAPI_PROGRESS_NORMAL));
 
-  for (size_t i = 0; i < wave_count; ++i)
+  const auto pause = std::chrono::steady_clock::now () - start;
+  g_profile->add_tick (pause);
+  stats::record (stats::timer_t::profile_sample, pause);
+
+  if (need_code_objects)
+    update_profile_code_objects (process_id);
+
+  /* The dispatches are not reused, forget the old ones.  */
+  if (g_profile_kernel_entries.size () > 4096)
+    g_profile_kernel_entries.clear ();
+}
+
+/* Write the profile to the files starting with g_profile_output, and print
+   its summary.  */
+
+void
+write_profile ()
+{
+  auto symbolizer = [] (uint64_t kernel_entry, uint64_t pc) {
+    return source_location (g_profile_code_objects, kernel_entry, pc);
+  };
+
+  const std::string folded_path = g_profile_output + ".folded";
+  if (std::ofstream out (folded_path); out)
+    g_profile->write_folded (out, symbolizer);
+  else
+    agent_warning ("could not create %s", folded_path.c_str ());
+
+  const std::string pprof_path = g_profile_output + ".pb";
+  if (std::ofstream out (pprof_path, std::ios::binary); out)
+    g_profile->write_pprof (out, symbolizer);
+  else
+    agent_warning ("could not create %s", pprof_path.c_str ());
+
+  g_profile->print_summary (agent_out, symbolizer, 10);
+  agent_log (log_level_t::info, "wrote the profile to %s and %s",
+             folded_path.c_str (), pprof_path.c_str ());
+}
+
+/* Called when we expect dbgapi events to be present.  Fetch all events from
+   dbgapi and act on the required events.  */
+
+void
+process_dbgapi_events (amd_dbgapi_process_id_t process_id, bool all_wavefronts)
+{
+  bool need_print_waves = drain_dbgapi_events (process_id);
+
+  /* Merge the events reported during the coalescing window into the same
+     stop cycle, so that the process is only halted and printed once when
+     many waves fault at about the same time.  */
+  if (need_print_waves && g_coalesce_window)
     {
-      amd_dbgapi_wave_id_t wave_id = wave_ids[i];
+      const auto deadline
+          = std::chrono::steady_clock::now () + *g_coalesce_window;
 
-      amd_dbgapi_wave_state_t state;
-      DBGAPI_CHECK (amd_dbgapi_wave_get_info (
-          wave_id, AMD_DBGAPI_WAVE_INFO_STATE, sizeof (state), &state));
+      size_t batch_count = 1;
+      while (wait_for_dbgapi_events (process_id, deadline))
+        {
+          drain_dbgapi_events (process_id);
+          ++batch_count;
+        }
 
-      if (state != AMD_DBGAPI_WAVE_STATE_STOP)
-        continue;
+      agent_log (log_level_t::verbose, "coalesced %zu event batches",
+                 batch_count);
+    }
 
-      std::underlying_type_t<amd_dbgapi_wave_stop_reasons_t> stop_reason;
-      DBGAPI_CHECK (
-          amd_dbgapi_wave_get_info (wave_id, AMD_DBGAPI_WAVE_INFO_STOP_REASON,
-                                    sizeof (stop_reason), &stop_reason));
-      auto stop_reason_bits{ stop_reason };
+  /* Some events do not require us to do anythig more.  If so, just return
+     early.  */
+  if (!need_print_waves && g_waves_to_resume.empty ())
+    return;
 
-      std::underlying_type_t<amd_dbgapi_exceptions_t> resume_exceptions = 0;
-      do
+  /* If the only waves to resume stopped on a debug trap, resume them right
+     away.  There is nothing to print, so there is no need to halt the rest
+     of the process.  */
+  if (!need_print_waves)
+    {
+      stats::add (stats::counter_t::debug_traps, g_waves_to_resume.size ());
+      agent_log (log_level_t::verbose, "resuming %zu debug trap waves",
+                 g_waves_to_resume.size ());
+
+      resume_stopped_waves ();
+      return;
+    }
+
+  print_exception_waves (process_id, all_wavefronts);
+}
+
+/* Run the commands in the list starting at COMMANDS.  Return false if the
+   worker thread should exit its event loop.  */
+
+bool
+run_commands (amd_dbgapi_process_id_t process_id, command_t *commands)
+{
+  bool continue_event_loop = true;
+  bool update_code_objects = false;
+  std::vector<completion_t *> completions;
+
+  for (command_t *command = commands; command;)
+    {
+      /* The command may be destroyed as soon as it is complete, or pushed
+         again once it is taken.  */
+      command_t *next = command->m_next;
+      if (command->m_completion)
+        completions.push_back (command->m_completion);
+
+      switch (command->m_kind)
         {
-          auto one_bit
-              = stop_reason_bits ^ (stop_reason_bits & (stop_reason_bits - 1));
-          stop_reason_bits ^= one_bit;
+        case command_kind_t::print_waves:
+          g_print_waves_queued.clear (std::memory_order_release);
 
-          switch (stop_reason)
-            {
-            case AMD_DBGAPI_WAVE_STOP_REASON_NONE:
-            case AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP:
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_NONE;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_BREAKPOINT:
-            case AMD_DBGAPI_WAVE_STOP_REASON_WATCHPOINT:
-            case AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP:
-            case AMD_DBGAPI_WAVE_STOP_REASON_TRAP:
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_TRAP;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_SINGLE_STEP:
-              /* Is this even possible?  */
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_NONE;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_INPUT_DENORMAL:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_DIVIDE_BY_0:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_OVERFLOW:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_UNDERFLOW:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_INEXACT:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FP_INVALID_OPERATION:
-            case AMD_DBGAPI_WAVE_STOP_REASON_INT_DIVIDE_BY_0:
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_MATH_ERROR;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION:
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_MEMORY_VIOLATION;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_ADDRESS_ERROR:
-              resume_exceptions
-                  |= AMD_DBGAPI_EXCEPTION_WAVE_ADDRESS_ERROR;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_ILLEGAL_INSTRUCTION:
-              resume_exceptions
-                  |= AMD_DBGAPI_EXCEPTION_WAVE_ILLEGAL_INSTRUCTION;
-              break;
-
-            case AMD_DBGAPI_WAVE_STOP_REASON_ECC_ERROR:
-            case AMD_DBGAPI_WAVE_STOP_REASON_FATAL_HALT:
-              resume_exceptions |= AMD_DBGAPI_EXCEPTION_WAVE_ABORT;
-              break;
+          if (size_t signals = g_print_waves_signals.exchange (0);
+              signals > 1)
+            agent_log (log_level_t::verbose,
+                       "%zu signals were coalesced into one dump", signals);
 
-#if AMD_DBGAPI_VERSION_MAJOR == 0 && AMD_DBGAPI_VERSION_MINOR < 58
-            case AMD_DBGAPI_WAVE_STOP_REASON_RESERVED:
-              break;
-#endif
-            }
-      } while (stop_reason_bits != 0);
+          /* Start on a new line, after the "^\" echoed by the terminal.  */
+          agent_out << '\n';
+          write_flight_recorder ();
+          print_and_resume_waves (process_id, true, true);
+
+          if (stats::enabled ())
+            stats::print (agent_out);
+          break;
 
-      DBGAPI_CHECK (amd_dbgapi_wave_resume (
-          wave_id, AMD_DBGAPI_RESUME_MODE_NORMAL,
-          static_cast<amd_dbgapi_exceptions_t> (resume_exceptions)));
+        case command_kind_t::update_code_objects:
+          /* All the updates requested by the commands in this list are
+             reported once.  */
+          update_code_objects = true;
+          break;
+
+        case command_kind_t::stop:
+          /* It is time to exit the main event loop and detach dbgapi.  */
+          continue_event_loop = false;
+          break;
+        }
+
+      command = next;
+    }
+
+  if (update_code_objects)
+    {
+      agent_assert (g_rbrk_breakpoint_id.has_value ());
+      report_code_object_list_updates ();
+    }
+
+  for (auto *completion : completions)
+    completion->signal ();
+
+  return continue_event_loop;
+}
+
+/* Print the waves for a control socket request.  WORDS are the arguments of
+   the "dump" request, which select the format, the waves and the details
+   printed.  The dump is written to OUT, which sends it to the client while
+   it is produced, instead of the agent's output.  Return an error message
+   if the request is invalid.  */
+
+std::string
+dump_for_request (amd_dbgapi_process_id_t process_id,
+                  const std::vector<std::string> &words, std::ostream &out)
+{
+  output_format_t format{ output_format_t::text };
+  wave_filter_t filter;
+  dump_detail_t detail{ dump_detail_t::full };
+  bool hot_spots{ false };
+
+  for (auto &&word : words)
+    {
+      auto equal = word.find ('=');
+      std::string key = word.substr (0, equal);
+      std::string value
+          = equal != std::string::npos ? word.substr (equal + 1) : "";
+
+      bool valid = true;
+      if (key == "format" && value == "text")
+        format = output_format_t::text;
+      else if (key == "format" && value == "json")
+        format = output_format_t::json;
+      else if (key == "format" && value == "binary")
+        format = output_format_t::binary;
+      else if (key == "detail" && value == "summary")
+        detail = dump_detail_t::summary;
+      else if (key == "detail" && value == "registers")
+        detail = dump_detail_t::registers;
+      else if (key == "detail" && value == "full")
+        detail = dump_detail_t::full;
+      else if (key == "hot-spots" && equal == std::string::npos)
+        hot_spots = true;
+      else if (key == "stop-reason")
+        valid = filter.set_stop_reasons (value);
+      else if (key == "agent")
+        valid = filter.set_agents (value);
+      else if (key == "dispatch")
+        valid = filter.set_dispatches (value);
+      else if (key == "kernel" && !value.empty ())
+        filter.add_kernel_pattern (value);
+      else if (key == "max-waves")
+        {
+          auto count = parse_unsigned (value);
+          valid = count.has_value ();
+          if (valid)
+            filter.set_max_waves (*count);
+        }
+      else
+        valid = false;
+
+      if (!valid)
+        return "error: invalid dump argument '" + word + "'\n";
+    }
+
+  /* Handle the events reported before the request first, so that the waves
+     that stopped on an exception are printed to the agent's output.  */
+  process_dbgapi_events (process_id, g_all_wavefronts);
+
+  /* Temporarily replace the writer and the settings of the dumps, this is
+     the only thread printing the waves.  */
+  std::unique_ptr<dump_writer_t> writer = make_dump_writer (format, out);
+
+  std::swap (g_dump_writer, writer);
+  std::swap (g_wave_filter, filter);
+  std::swap (g_dump_detail, detail);
+  std::swap (g_hot_spots, hot_spots);
+
+  report_code_object_list_updates ();
+  DBGAPI_CHECK (amd_dbgapi_process_set_progress (
+      process_id, AMD_DBGAPI_PROGRESS_NO_FORWARD));
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_STOP);
+
+  print_wavefronts (process_id, true);
+
+  std::swap (g_dump_writer, writer);
+  std::swap (g_wave_filter, filter);
+  std::swap (g_dump_detail, detail);
+  std::swap (g_hot_spots, hot_spots);
+
+  /* A wave may have stopped on an exception while the waves were stopped
+     for the request.  Its stop event was consumed, so print the waves to
+     the agent's output as well before it is resumed, like the sampler
+     does.  */
+  if (stopped_on_exception ())
+    print_exception_waves (process_id, g_all_wavefronts);
+  else
+    resume_stopped_waves ();
+
+  set_wave_creation (process_id, AMD_DBGAPI_WAVE_CREATION_NORMAL);
+  DBGAPI_CHECK (amd_dbgapi_process_set_progress (process_id,
+                                                 AMD_DBGAPI_PROGRESS_NORMAL));
+
+  return {};
+}
+
+/* Serve a REQUEST received on the control socket, and return the reply.  The
+   dumps, which may be large, are written to DUMP_OUT instead.  */
+
+std::string
+handle_control_request (amd_dbgapi_process_id_t process_id,
+                        const std::string &request, std::ostream &dump_out)
+{
+  std::istringstream in (request);
+  std::vector<std::string> words{ std::istream_iterator<std::string> (in),
+                                  std::istream_iterator<std::string> () };
+  std::ostringstream out;
+
+  agent_log (log_level_t::info, "control socket request: %s",
+             request.c_str ());
+
+  if (words.empty () || words[0] == "help")
+    {
+      out << "requests:\n"
+             "  code-objects    list the loaded code objects\n"
+             "  waves           count the wavefronts by agent and state\n"
+             "  stats           print the agent's statistics (--stats)\n"
+             "  log             print and clear the flight recorder\n"
+             "                  (--flight-recorder)\n"
+             "  dump [format={text|json|binary}] "
+             "[detail={summary|registers|full}]\n"
+             "       [hot-spots] [stop-reason=LIST] [agent=LIST] "
+             "[dispatch=LIST]\n"
+             "       [kernel=PATTERN]... [max-waves=N]\n"
+             "                  print the wavefronts\n";
+    }
+  else if (words[0] == "code-objects")
+    {
+      report_code_object_list_updates ();
+
+      amd_dbgapi_code_object_id_t *code_objects_id;
+      size_t code_object_count;
+      DBGAPI_CHECK (amd_dbgapi_process_code_object_list (
+          process_id, &code_object_count, &code_objects_id, nullptr));
+
+      for (size_t i = 0; i < code_object_count; ++i)
+        {
+          code_object_t code_object (code_objects_id[i]);
+          out << "0x" << std::hex << std::setfill ('0') << std::setw (16)
+              << code_object.load_address () << std::dec << ' '
+              << code_object.uri () << '\n';
+        }
+      free (code_objects_id);
+    }
+  else if (words[0] == "waves")
+    {
+      amd_dbgapi_wave_id_t *wave_ids;
+      size_t wave_count;
+      DBGAPI_CHECK (amd_dbgapi_process_wave_list (process_id, &wave_count,
+                                                  &wave_ids, nullptr));
+
+      /* The number of running, single-stepping, and stopped waves of each
+         agent, by operating system agent id.  */
+      std::map<amd_dbgapi_os_agent_id_t, std::array<size_t, 3>> counts;
+      for (size_t i = 0; i < wave_count; ++i)
+        {
+          amd_dbgapi_agent_id_t agent_id;
+          amd_dbgapi_os_agent_id_t os_agent_id;
+          amd_dbgapi_wave_state_t state;
+          if (amd_dbgapi_wave_get_info (wave_ids[i],
+                                        AMD_DBGAPI_WAVE_INFO_AGENT,
+                                        sizeof (agent_id), &agent_id)
+                  != AMD_DBGAPI_STATUS_SUCCESS
+              || amd_dbgapi_agent_get_info (agent_id,
+                                            AMD_DBGAPI_AGENT_INFO_OS_ID,
+                                            sizeof (os_agent_id),
+                                            &os_agent_id)
+                     != AMD_DBGAPI_STATUS_SUCCESS
+              || amd_dbgapi_wave_get_info (wave_ids[i],
+                                           AMD_DBGAPI_WAVE_INFO_STATE,
+                                           sizeof (state), &state)
+                     != AMD_DBGAPI_STATUS_SUCCESS)
+            /* The wave may have terminated since it was listed.  */
+            continue;
+
+          auto &count = counts[os_agent_id];
+          if (state == AMD_DBGAPI_WAVE_STATE_RUN)
+            ++count[0];
+          else if (state == AMD_DBGAPI_WAVE_STATE_SINGLE_STEP)
+            ++count[1];
+          else
+            ++count[2];
+        }
+      free (wave_ids);
+
+      out << wave_count << " wavefronts\n";
+      for (auto &&[os_agent_id, count] : counts)
+        out << "agent " << os_agent_id << ": " << count[0] << " running, "
+            << count[1] << " single-stepping, " << count[2] << " stopped\n";
+    }
+  else if (words[0] == "stats")
+    {
+      if (stats::enabled ())
+        stats::print (out);
+      else
+        out << "error: the statistics are not collected, use --stats\n";
     }
+  else if (words[0] == "log")
+    {
+      if (flight_recorder_enabled ())
+        out << flight_recorder_messages ();
+      else
+        out << "error: the messages are not recorded, use "
+               "--flight-recorder\n";
+    }
+  else if (words[0] == "dump")
+    {
+      return dump_for_request (
+          process_id,
+          std::vector<std::string> (words.begin () + 1, words.end ()),
+          dump_out);
+    }
+  else
+    out << "error: unknown request '" << words[0] << "', try 'help'\n";
 
-  DBGAPI_CHECK (amd_dbgapi_process_set_wave_creation (
-      process_id, AMD_DBGAPI_WAVE_CREATION_NORMAL));
-
-  DBGAPI_CHECK (amd_dbgapi_process_set_progress (process_id,
-                                                 AMD_DBGAPI_PROGRESS_NORMAL));
+  return out.str ();
 }
 
-/* Main function of the accessory thread used to handle dbgapi.  The LISTEN_FD
-   parameter is the read end of a pipe where the main application can write
-   to instruct the worker thread to stop.  */
+/* Main function of the accessory thread used to handle dbgapi.  The worker
+   thread waits for dbgapi events and for the commands in g_commands.  */
 void
-dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
+dbgapi_worker (bool all_wavefronts, bool precise_memory)
 {
   amd_dbgapi_process_id_t process_id;
   amd_dbgapi_event_id_t event_id;
@@ -1013,6 +2758,10 @@ dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
   int epoll_fd;
   epoll_event ev{};
 
+  g_dump_thread = true;
+
+  const auto attach_start = std::chrono::steady_clock::now ();
+
   /* Enable and attach dbgapi.  */
   DBGAPI_CHECK (amd_dbgapi_initialize (&dbgapi_callbacks));
 
@@ -1021,9 +2770,10 @@ dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
     agent_error ("Failed to open /proc/self/mem: %s\n", strerror (errno));
   std::unique_ptr<int, std::function<void (int *)>> self_mem_fd_closer (
       &self_mem_fd, [] (int *fd) { close (*fd); });
+  g_memory_cache.emplace (self_mem_fd);
 
   DBGAPI_CHECK (amd_dbgapi_process_attach (
-      reinterpret_cast<amd_dbgapi_client_process_id_t> (&self_mem_fd),
+      reinterpret_cast<amd_dbgapi_client_process_id_t> (&*g_memory_cache),
       &process_id));
 
   /* Runtime has been activated just before tools are loaded.  We do expect
@@ -1063,9 +2813,9 @@ dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
   if (epoll_fd == -1)
     agent_error ("unable to create epoll instance: %s", strerror (errno));
 
-  ev.data.fd = listen_fd;
+  ev.data.fd = g_commands.fd ();
   ev.events = EPOLLIN;
-  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) == -1)
+  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, g_commands.fd (), &ev) == -1)
     agent_error ("Unable to add rocr notifier to the epoll instance: %s",
                  strerror (errno));
 
@@ -1075,6 +2825,55 @@ dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
     agent_error ("Unable to add dbgapi notifier to the epoll instance: %s",
                  strerror (errno));
 
+  if (g_control_socket_path)
+    {
+      if (!g_control_socket.open (*g_control_socket_path))
+        agent_warning ("could not create the control socket %s: %s",
+                       g_control_socket_path->c_str (), strerror (errno));
+      else
+        {
+          ev.data.fd = g_control_socket.fd ();
+          ev.events = EPOLLIN;
+          if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, g_control_socket.fd (), &ev)
+              == -1)
+            agent_error ("Unable to add the control socket to the epoll "
+                         "instance: %s",
+                         strerror (errno));
+
+          agent_log (log_level_t::info, "serving requests on %s",
+                     g_control_socket_path->c_str ());
+        }
+    }
+
+  /* Sample the waves periodically if profiling.  */
+  int profile_timer_fd = -1;
+  if (g_profile)
+    {
+      profile_timer_fd
+          = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+      if (profile_timer_fd == -1)
+        agent_error ("unable to create the profile timer: %s",
+                     strerror (errno));
+
+      const auto period = g_profile->period ();
+      itimerspec interval{};
+      interval.it_interval.tv_sec
+          = std::chrono::duration_cast<std::chrono::seconds> (period).count ();
+      interval.it_interval.tv_nsec
+          = (period % std::chrono::seconds (1)).count ();
+      interval.it_value = interval.it_interval;
+      if (timerfd_settime (profile_timer_fd, 0, &interval, nullptr) == -1)
+        agent_error ("unable to start the profile timer: %s",
+                     strerror (errno));
+
+      ev.data.fd = profile_timer_fd;
+      ev.events = EPOLLIN;
+      if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, profile_timer_fd, &ev) == -1)
+        agent_error ("Unable to add the profile timer to the epoll "
+                     "instance: %s",
+                     strerror (errno));
+    }
+
   if (precise_memory)
     {
       amd_dbgapi_status_t r = amd_dbgapi_set_memory_precision (
@@ -1089,78 +2888,89 @@ dbgapi_worker (int listen_fd, bool all_wavefronts, bool precise_memory)
         }
     }
 
+  stats::record (stats::timer_t::attach,
+                 std::chrono::steady_clock::now () - attach_start);
+
   for (bool continue_event_loop = true; continue_event_loop;)
     {
-      /* We can wait for events on at most 2 file descriptors.  */
-      constexpr size_t max_events = 2;
+      /* We can wait for events on at most 4 file descriptors.  */
+      constexpr size_t max_events = 4;
       epoll_event evs[max_events];
 
-      int nfd = epoll_wait (epoll_fd, evs, max_events, -1);
+      /* Wake up when the suppressed dumps should be summarized, and when
+         the signal waits should be checked.  */
+      std::optional<std::chrono::steady_clock::time_point> wake_up
+          = g_dump_throttle.next_summary ();
+      if (g_hang_detector && (!wake_up || g_next_hang_check < *wake_up))
+        wake_up = g_next_hang_check;
+
+      int timeout = -1;
+      if (wake_up)
+        timeout = std::max<int> (
+            std::chrono::ceil<std::chrono::milliseconds> (
+                *wake_up - std::chrono::steady_clock::now ())
+                .count (),
+            0);
+
+      int nfd = epoll_wait (epoll_fd, evs, max_events, timeout);
       if (nfd == -1 && errno == EINTR)
         continue;
 
       if (nfd == -1)
         agent_error ("epoll_wait failed: %s", strerror (errno));
 
+      print_throttle_summary (false);
+      check_hangs (process_id);
+
       for (int i = 0; i < nfd; i++)
         {
-          /* Make sure we purge all data from the pipe.  */
-          if (evs[i].data.fd == listen_fd)
+          if (evs[i].data.fd == g_commands.fd ())
             {
-              char buf = '\0';
-              while (read (evs[i].data.fd, &buf, 1) == -1 && errno == EINTR)
-                ;
-
-              switch (buf)
-                {
-                case 'p':
-                  print_wavefronts (process_id, true);
-                  break;
-                case 'q':
-                  /* It is time to exit the main event loop and detach dbgapi.
-                   */
-                  continue_event_loop = false;
-                  break;
-                case 'b':
-                  {
-                    /* We need the atomic load to ensure that the promise
-                       object we try to access is consistent with the
-                       requesting thread.  */
-                    [[maybe_unused]] bool promise_available
-                        = g_rbrk_sync.guard.load (
-                            std::memory_order::memory_order_acquire);
-
-                    agent_assert (promise_available);
-                    agent_assert (g_rbrk_sync.promise.has_value ());
-
-                    agent_assert (g_rbrk_breakpoint_id.has_value ());
-                    amd_dbgapi_breakpoint_action_t bpaction;
-                    DBGAPI_CHECK (amd_dbgapi_report_breakpoint_hit (
-                        g_rbrk_breakpoint_id.value (), 0, &bpaction));
-
-                    g_rbrk_sync.promise->set_value ();
-                    break;
-                  }
-                }
+              if (!run_commands (process_id, g_commands.take_all ()))
+                continue_event_loop = false;
             }
           else if (evs[i].data.fd == notifier)
             {
-              /* Drain the pipe.  */
-              int r;
-              do
-                {
-                  char buf;
-                  r = read (evs[i].data.fd, &buf, 1);
-              } while (r >= 0 || (r == -1 && errno == EINTR));
+              drain_notifier (notifier);
               process_dbgapi_events (process_id, all_wavefronts);
             }
+          else if (g_control_socket.is_open ()
+                   && evs[i].data.fd == g_control_socket.fd ())
+            g_control_socket.serve ([process_id] (const std::string &request,
+                                                  std::ostream &out) {
+              return handle_control_request (process_id, request, out);
+            });
+          else if (evs[i].data.fd == profile_timer_fd)
+            {
+              /* The intervals missed while the waves were printed are not
+                 sampled.  */
+              uint64_t expirations;
+              if (read (profile_timer_fd, &expirations, sizeof (expirations))
+                  == sizeof (expirations))
+                sample_wavefronts (process_id, all_wavefronts);
+            }
           else
             agent_error ("Unknown file descriptor %d", evs[i].data.fd);
         }
     }
 
+  g_control_socket.close ();
+  if (profile_timer_fd != -1)
+    close (profile_timer_fd);
+
   DBGAPI_CHECK (amd_dbgapi_process_detach (process_id));
   DBGAPI_CHECK (amd_dbgapi_finalize ());
+
+  /* Do not leave threads waiting for commands that will never run.  */
+  for (command_t *command = g_commands.close (); command;)
+    {
+      command_t *next = command->m_next;
+      if (command->m_completion)
+        command->m_completion->signal ();
+      command = next;
+    }
+
+  close (epoll_fd);
 }
 
 class DebugAgentWorker
@@ -1174,90 +2984,32 @@ public:
   DebugAgentWorker &operator= (const DebugAgentWorker &) = delete;
   DebugAgentWorker &operator= (DebugAgentWorker &&) = delete;
 
-  void query_print_waves () const;
-  void update_code_object_list () const;
-
 private:
   std::thread m_worker_thread;
-  int m_write_pipe = -1;
 };
 
 DebugAgentWorker::DebugAgentWorker ()
 {
-  int pipefd[2];
-  if (pipe2 (pipefd, O_CLOEXEC) == -1)
-    agent_error ("failed to create pipe: %s", strerror (errno));
-
-  if (fcntl (pipefd[0], F_SETFL, O_NONBLOCK)
-      || fcntl (pipefd[1], F_SETFL, O_NONBLOCK))
-    agent_error ("failed to set pipe non-blocking: %s", strerror (errno));
+  if (!g_commands.open ())
+    agent_error ("failed to create eventfd: %s", strerror (errno));
 
-  m_write_pipe = pipefd[1];
-
-  m_worker_thread = std::thread (dbgapi_worker, pipefd[0], g_all_wavefronts,
-                                 g_precise_emmory);
+  m_worker_thread
+      = std::thread (dbgapi_worker, g_all_wavefronts, g_precise_emmory);
 
   auto pthread_thread = m_worker_thread.native_handle ();
   if (pthread_setname_np (pthread_thread, "RocrDebugAgent") == -1)
     agent_error ("Failed to set thread name: %s", strerror (errno));
 }
 
-void
-DebugAgentWorker::query_print_waves () const
-{
-  agent_assert (m_write_pipe != -1);
-  char msg = 'p';
-  ssize_t written = write (m_write_pipe, &msg, 1);
-  if (written == -1)
-    agent_error ("Failed to notify RocrDebugAgent thread (%s)",
-                 strerror (errno));
-  agent_assert (written == 1);
-}
-
-void
-DebugAgentWorker::update_code_object_list () const
-{
-  agent_assert (m_write_pipe != -1);
-  /* It is OK to have this load removed if the assertion is not compiled in.
-     It does not have a role in synchronization.  */
-  agent_assert (
-      !g_rbrk_sync.guard.load (std::memory_order::memory_order_acquire));
-  agent_assert (!g_rbrk_sync.promise.has_value ());
-
-  /* Create the promise/future pair and make sure the promise is visible by
-     the worker thread.  */
-  g_rbrk_sync.promise.emplace ();
-  auto update_brk_future = g_rbrk_sync.promise->get_future ();
-  g_rbrk_sync.guard.store (true, std::memory_order::memory_order_release);
-
-  /* Use the pipe to notify the thread a code object list is requested.  */
-  char msg = 'b';
-  ssize_t written = write (m_write_pipe, &msg, 1);
-  if (written == -1)
-    agent_error ("Failed to notify RocrDebugAgent thread (%s)",
-                 strerror (errno));
-  agent_assert (written == 1);
-
-  /* Wait for the worker thread to acknoledge code object update has proceded
-     and reset the synch structure so it can be reused in a later call.  */
-  update_brk_future.wait ();
-  g_rbrk_sync.promise.reset ();
-  g_rbrk_sync.guard.store (false, std::memory_order::memory_order_release);
-}
-
 DebugAgentWorker::~DebugAgentWorker ()
 {
-  if (m_write_pipe != -1)
+  if (m_worker_thread.joinable ())
     {
-      char msg = 'q';
-      ssize_t written = write (m_write_pipe, &msg, 1);
-      if (written == -1)
-        agent_error ("Failed to notify RocrDebugAgent thread (%s)",
-                     strerror (errno));
-      agent_assert (written == 1);
+      /* The worker thread closes the queue when it exits, the command is
+         only read before that.  */
+      command_t stop{ command_kind_t::stop };
+      g_commands.push (stop);
       m_worker_thread.join ();
-      close (m_write_pipe);
-      m_write_pipe = -1;
     }
 }
 
@@ -1300,18 +3052,6 @@ public:
       m_worker.reset ();
   }
 
-  void update_code_object_list ()
-  {
-    if (m_worker.has_value ())
-      m_worker->update_code_object_list ();
-  }
-
-  void query_print_waves ()
-  {
-    if (m_worker.has_value ())
-      m_worker->query_print_waves ();
-  }
-
 private:
   std::lock_guard<std::mutex> m_lock;
   std::optional<DebugAgentWorker> &m_worker;
@@ -1348,13 +3088,183 @@ decltype (CoreApiTable::hsa_executable_destroy_fn)
     original_hsa_executable_destroy
     = {};
 
+/* Ask the worker thread to print all the wavefronts.  This is called by the
+   signal handler, so it must be async-signal-safe: the command is pushed on
+   the lock-free command queue, whose eventfd wakes up the worker thread.  A
+   signal received while the command is still queued only counts.  */
+
+void
+query_print_waves ()
+{
+  static command_t command{ command_kind_t::print_waves };
+
+  /* Writing to the eventfd may change errno in the interrupted thread.  */
+  int saved_errno = errno;
+
+  g_print_waves_signals.fetch_add (1, std::memory_order_relaxed);
+  if (!g_print_waves_queued.test_and_set (std::memory_order_acquire)
+      && !g_commands.push (command))
+    g_print_waves_queued.clear (std::memory_order_release);
+
+  errno = saved_errno;
+}
+
+/* Request a code object list update, and wait until it is reported to
+   dbgapi if WAIT is true.  The updates requested by all the threads whose
+   commands are pending when the worker thread takes them are reported
+   once.  */
+
+void
+update_code_object_list (bool wait)
+{
+  g_code_object_update_pending.store (true, std::memory_order_release);
+  if (!wait)
+    return;
+
+  completion_t completion;
+  command_t command{ command_kind_t::update_code_objects, &completion };
+
+  /* If the worker thread is not running, there is nothing to wait for.  */
+  if (!g_commands.push (command))
+    return;
+
+  completion.wait ();
+}
+
+decltype (CoreApiTable::hsa_queue_create_fn) original_hsa_queue_create = {};
+decltype (CoreApiTable::hsa_queue_destroy_fn) original_hsa_queue_destroy = {};
+
+decltype (CoreApiTable::hsa_signal_store_relaxed_fn)
+    original_hsa_signal_store_relaxed
+    = {};
+
+decltype (CoreApiTable::hsa_signal_store_screlease_fn)
+    original_hsa_signal_store_screlease
+    = {};
+
+decltype (CoreApiTable::hsa_signal_wait_relaxed_fn)
+    original_hsa_signal_wait_relaxed
+    = {};
+
+decltype (CoreApiTable::hsa_signal_wait_scacquire_fn)
+    original_hsa_signal_wait_scacquire
+    = {};
+
+hsa_status_t
+debug_agent_hsa_queue_create (hsa_agent_t agent, uint32_t size,
+                              hsa_queue_type32_t type,
+                              void (*callback) (hsa_status_t status,
+                                                hsa_queue_t *source,
+                                                void *data),
+                              void *data, uint32_t private_segment_size,
+                              uint32_t group_segment_size,
+                              hsa_queue_t **queue)
+{
+  auto v = original_hsa_queue_create (agent, size, type, callback, data,
+                                      private_segment_size,
+                                      group_segment_size, queue);
+
+  if (v == HSA_STATUS_SUCCESS)
+    g_dispatch_history->add_queue (*queue);
+  return v;
+}
+
+hsa_status_t
+debug_agent_hsa_queue_destroy (hsa_queue_t *queue)
+{
+  g_dispatch_history->remove_queue (queue);
+  return original_hsa_queue_destroy (queue);
+}
+
+/* The doorbell stores make the dispatch packets visible to the packet
+   processor, record them before the packets can be reused.  */
+
+void
+debug_agent_hsa_signal_store_relaxed (hsa_signal_t signal,
+                                      hsa_signal_value_t value)
+{
+  g_dispatch_history->doorbell_store (signal, value);
+  original_hsa_signal_store_relaxed (signal, value);
+}
+
+void
+debug_agent_hsa_signal_store_screlease (hsa_signal_t signal,
+                                        hsa_signal_value_t value)
+{
+  g_dispatch_history->doorbell_store (signal, value);
+  original_hsa_signal_store_screlease (signal, value);
+}
+
+/* Return true if VALUE satisfies the wait CONDITION on COMPARE_VALUE.  */
+
+bool
+wait_satisfied (hsa_signal_value_t value, hsa_signal_condition_t condition,
+                hsa_signal_value_t compare_value)
+{
+  switch (condition)
+    {
+    case HSA_SIGNAL_CONDITION_EQ:
+      return value == compare_value;
+    case HSA_SIGNAL_CONDITION_NE:
+      return value != compare_value;
+    case HSA_SIGNAL_CONDITION_LT:
+      return value < compare_value;
+    case HSA_SIGNAL_CONDITION_GTE:
+      return value >= compare_value;
+    }
+  return true;
+}
+
+/* The signal waits are timed to detect the hung kernels.  */
+
+hsa_signal_value_t
+debug_agent_hsa_signal_wait_relaxed (hsa_signal_t signal,
+                                     hsa_signal_condition_t condition,
+                                     hsa_signal_value_t compare_value,
+                                     uint64_t timeout_hint,
+                                     hsa_wait_state_t wait_state_hint)
+{
+  g_hang_detector->begin_wait (signal.handle);
+  auto v = original_hsa_signal_wait_relaxed (signal, condition, compare_value,
+                                             timeout_hint, wait_state_hint);
+  g_hang_detector->end_wait (wait_satisfied (v, condition, compare_value));
+  return v;
+}
+
+hsa_signal_value_t
+debug_agent_hsa_signal_wait_scacquire (hsa_signal_t signal,
+                                       hsa_signal_condition_t condition,
+                                       hsa_signal_value_t compare_value,
+                                       uint64_t timeout_hint,
+                                       hsa_wait_state_t wait_state_hint)
+{
+  g_hang_detector->begin_wait (signal.handle);
+  auto v = original_hsa_signal_wait_scacquire (
+      signal, condition, compare_value, timeout_hint, wait_state_hint);
+  g_hang_detector->end_wait (wait_satisfied (v, condition, compare_value));
+  return v;
+}
+
 hsa_status_t
 debug_agent_hsa_executable_freeze (hsa_executable_t executable,
                                    const char *options)
 {
+  /* Attach dbgapi before the code objects are loaded, as OnLoad would
+     have, so that the code object list is reported to dbgapi the same way
+     below.  The other threads freezing an executable wait until the worker
+     thread is started.  */
+  if (g_defer_attach)
+    std::call_once (g_deferred_attach,
+                    [] () { get_worker_thread ().start (); });
+
   auto v = original_hsa_executable_freeze (executable, options);
 
-  get_worker_thread ().update_code_object_list ();
+  stats::scoped_timer_t timer (stats::timer_t::freeze_hook);
+  stats::add (stats::counter_t::freezes);
+
+  /* The code objects must be known to dbgapi before the kernels they contain
+     can be dispatched.  */
+  update_code_object_list (true);
   return v;
 }
 
@@ -1363,7 +3273,12 @@ debug_agent_hsa_executable_destroy (hsa_executable_t executable)
 {
   auto v = original_hsa_executable_destroy (executable);
 
-  get_worker_thread ().update_code_object_list ();
+  stats::scoped_timer_t timer (stats::timer_t::destroy_hook);
+  stats::add (stats::counter_t::destroys);
+
+  /* The unloaded code objects are removed from the dbgapi code object list
+     by the next freeze or dump, there is no need to wait.  */
+  update_code_object_list (false);
   return v;
 }
 
@@ -1374,7 +3289,15 @@ extern "C" bool __attribute__ ((visibility ("default")))
 OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
         const char *const *failed_tool_names)
 {
+  const auto on_load_start = std::chrono::steady_clock::now ();
+
   bool disable_sigquit{ false };
+  std::vector<int> dump_signals{ SIGQUIT };
+  std::optional<std::chrono::milliseconds> hang_threshold;
+  bool dispatch_history{ false };
+  output_format_t output_format{ output_format_t::text };
+  std::optional<std::string> output_path;
+  std::optional<std::chrono::milliseconds> flush_interval;
 
   set_log_level (log_level_t::warning);
 
@@ -1391,13 +3314,67 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
   char *const *argv = const_cast<char *const *> (args.data ());
   int argc = args.size ();
 
+  /* Values returned by getopt_long for the options without a short form.  */
+  enum
+  {
+    opt_flush_interval = 256,
+    opt_stop_reason,
+    opt_kernel,
+    opt_agent,
+    opt_dispatch,
+    opt_max_waves,
+    opt_dump_budget,
+    opt_hot_spots,
+    opt_stop_timeout,
+    opt_coalesce,
+    opt_throttle,
+    opt_throttle_summary,
+    opt_dispatch_history,
+    opt_stats,
+    opt_control_socket,
+    opt_signals,
+    opt_profile,
+    opt_profile_output,
+    opt_hang_threshold,
+    opt_flight_recorder,
+    opt_defer_attach,
+  };
+
   static struct option options[]
       = { { "all", no_argument, nullptr, 'a' },
           { "disable-linux-signals", no_argument, nullptr, 'd' },
           { "log-level", required_argument, nullptr, 'l' },
           { "output", required_argument, nullptr, 'o' },
+          { "format", required_argument, nullptr, 'f' },
           { "save-code-objects", optional_argument, nullptr, 's' },
           { "precise-memory", no_argument, nullptr, 'p' },
+          { "flush-interval", required_argument, nullptr, opt_flush_interval },
+          { "stop-reason", required_argument, nullptr, opt_stop_reason },
+          { "kernel", required_argument, nullptr, opt_kernel },
+          { "agent", required_argument, nullptr, opt_agent },
+          { "dispatch", required_argument, nullptr, opt_dispatch },
+          { "max-waves", required_argument, nullptr, opt_max_waves },
+          { "dump-budget", required_argument, nullptr, opt_dump_budget },
+          { "hot-spots", no_argument, nullptr, opt_hot_spots },
+          { "stop-timeout", required_argument, nullptr, opt_stop_timeout },
+          { "coalesce", required_argument, nullptr, opt_coalesce },
+          { "throttle", required_argument, nullptr, opt_throttle },
+          { "throttle-summary", required_argument, nullptr,
+            opt_throttle_summary },
+          { "dispatch-history", optional_argument, nullptr,
+            opt_dispatch_history },
+          { "stats", no_argument, nullptr, opt_stats },
+          { "control-socket", optional_argument, nullptr,
+            opt_control_socket },
+          { "signals", required_argument, nullptr, opt_signals },
+          { "profile", required_argument, nullptr, opt_profile },
+          { "profile-output", required_argument, nullptr,
+            opt_profile_output },
+          { "hang-threshold", required_argument, nullptr,
+            opt_hang_threshold },
+          { "flight-recorder", optional_argument, nullptr,
+            opt_flight_recorder },
+          { "defer-attach", no_argument, nullptr, opt_defer_attach },
           { "help", no_argument, nullptr, 'h' },
           { 0 } };
 
@@ -1406,7 +3383,7 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
   int saved_optind = optind;
   optind = 1;
 
-  while (int c = getopt_long (argc, argv, ":as::o:dpl:h", options, nullptr))
+  while (int c = getopt_long (argc, argv, ":as::o:f:dpl:h", options, nullptr))
     {
       if (c == -1)
         break;
@@ -1476,14 +3453,218 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
           if (!argument)
             print_usage ();
 
-          agent_out.open (*argument);
-          if (!agent_out.is_open ())
+          output_path = *argument;
+          break;
+
+        case 'f': /* -f or --format  */
+          if (argument == "text")
+            output_format = output_format_t::text;
+          else if (argument == "binary")
+            output_format = output_format_t::binary;
+          else if (argument == "json")
+            output_format = output_format_t::json;
+          else
+            print_usage ();
+          break;
+
+        case opt_flush_interval: /* --flush-interval  */
+          {
+            std::optional<uint64_t> interval;
+            if (argument)
+              interval = parse_unsigned (*argument);
+            if (!interval || !*interval)
+              print_usage ();
+
+            flush_interval.emplace (*interval);
+            break;
+          }
+
+        case opt_stop_reason: /* --stop-reason  */
+          if (!argument || !g_wave_filter.set_stop_reasons (*argument))
+            print_usage ();
+          break;
+
+        case opt_kernel: /* --kernel  */
+          if (!argument)
+            print_usage ();
+
+          g_wave_filter.add_kernel_pattern (*argument);
+          break;
+
+        case opt_agent: /* --agent  */
+          if (!argument || !g_wave_filter.set_agents (*argument))
+            print_usage ();
+          break;
+
+        case opt_dispatch: /* --dispatch  */
+          if (!argument || !g_wave_filter.set_dispatches (*argument))
+            print_usage ();
+          break;
+
+        case opt_max_waves: /* --max-waves  */
+          {
+            std::optional<uint64_t> count;
+            if (argument)
+              count = parse_unsigned (*argument);
+            if (!count)
+              print_usage ();
+
+            g_wave_filter.set_max_waves (*count);
+            break;
+          }
+
+        case opt_dump_budget: /* --dump-budget  */
+          if (argument)
+            g_dump_budget = parse_dump_budget (*argument);
+          if (!g_dump_budget)
+            print_usage ();
+          break;
+
+        case opt_hot_spots: /* --hot-spots  */
+          g_hot_spots = true;
+          break;
+
+        case opt_stop_timeout: /* --stop-timeout  */
+          {
+            std::optional<uint64_t> timeout;
+            if (argument)
+              timeout = parse_unsigned (*argument);
+            if (!timeout)
+              print_usage ();
+
+            g_stop_timeout.emplace (*timeout);
+            break;
+          }
+
+        case opt_coalesce: /* --coalesce  */
+          {
+            std::optional<uint64_t> window;
+            if (argument)
+              window = parse_unsigned (*argument);
+            if (!window)
+              print_usage ();
+
+            if (*window)
+              g_coalesce_window.emplace (*window);
+            break;
+          }
+
+        case opt_throttle: /* --throttle  */
+          {
+            std::optional<uint64_t> count;
+            if (argument)
+              count = parse_unsigned (*argument);
+            if (!count)
+              print_usage ();
+
+            g_dump_throttle.set_max_dumps (*count);
+            break;
+          }
+
+        case opt_throttle_summary: /* --throttle-summary  */
+          {
+            std::optional<uint64_t> interval;
+            if (argument)
+              interval = parse_unsigned (*argument);
+            if (!interval || !*interval)
+              print_usage ();
+
+            g_dump_throttle.set_summary_interval (
+                std::chrono::seconds (*interval));
+            break;
+          }
+
+        case opt_dispatch_history: /* --dispatch-history  */
+          if (argument)
+            {
+              auto length = parse_unsigned (*argument);
+              if (!length || !*length)
+                print_usage ();
+
+              g_dispatch_history_length = *length;
+            }
+          dispatch_history = true;
+          break;
+
+        case opt_stats: /* --stats  */
+          stats::enable ();
+          break;
+
+        case opt_control_socket: /* --control-socket  */
+          if (argument && argument->empty ())
+            print_usage ();
+
+          if (argument)
+            g_control_socket_path = *argument;
+          else
             {
-              std::cerr << "could not open `" << *argument << "'" << std::endl;
-              abort ();
+              const char *runtime_dir = getenv ("XDG_RUNTIME_DIR");
+              g_control_socket_path
+                  = std::string (runtime_dir ? runtime_dir : "/tmp")
+                    + "/rocm-debug-agent." + std::to_string (getpid ());
             }
           break;
 
+        case opt_signals: /* --signals  */
+          {
+            std::optional<std::vector<int>> signals;
+            if (argument)
+              signals = parse_signals (*argument);
+            if (!signals)
+              print_usage ();
+
+            dump_signals = std::move (*signals);
+            break;
+          }
+
+        case opt_profile: /* --profile  */
+          {
+            std::optional<uint64_t> frequency;
+            if (argument)
+              frequency = parse_unsigned (*argument);
+            if (!frequency || !*frequency || *frequency > 10000)
+              print_usage ();
+
+            g_profile.emplace (std::chrono::nanoseconds (1000000000)
+                               / *frequency);
+            break;
+          }
+
+        case opt_profile_output: /* --profile-output  */
+          if (!argument || argument->empty ())
+            print_usage ();
+
+          g_profile_output = *argument;
+          break;
+
+        case opt_hang_threshold: /* --hang-threshold  */
+          {
+            std::optional<uint64_t> threshold;
+            if (argument)
+              threshold = parse_unsigned (*argument);
+            if (!threshold || !*threshold)
+              print_usage ();
+
+            hang_threshold.emplace (*threshold);
+            break;
+          }
+
+        case opt_flight_recorder: /* --flight-recorder  */
+          {
+            std::optional<uint64_t> size{ 1024 };
+            if (argument)
+              size = parse_unsigned (*argument);
+            if (!size || *size < 64 || *size > 1024 * 1024)
+              print_usage ();
+
+            enable_flight_recorder (*size * 1024);
+            break;
+          }
+
+        case opt_defer_attach: /* --defer-attach  */
+          g_defer_attach = true;
+          break;
+
         case '?': /* Unrecognized option  */
         case 'h': /* -h or --help */
         default:
@@ -1494,16 +3675,66 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
   /* Restore the global optind.  */
   optind = saved_optind;
 
+  set_dbgapi_log_level ();
+
+  if (g_profile && g_profile_output.empty ())
+    g_profile_output = "rocm-debug-agent." + std::to_string (getpid ());
+
   std::for_each (args.begin (), args.end (), [] (char *str) { free (str); });
 
-  if (!agent_out.is_open ())
+  /* Binary and JSON dumps are written to their own file, and only the log
+     messages are sent to agent_out.  JSON dumps go to agent_out, interleaved
+     with the log messages, if no output file is given.  */
+  const bool separate_dump_file
+      = output_format == output_format_t::binary
+        || (output_format == output_format_t::json && output_path);
+
+  if (separate_dump_file)
     {
-      agent_out.copyfmt (std::cerr);
-      agent_out.clear (std::cerr.rdstate ());
-      agent_out.basic_ios<char>::rdbuf (std::cerr.rdbuf ());
+      if (!output_path)
+        {
+          std::cerr << "error: --format=binary requires --output"
+                    << std::endl;
+          print_usage ();
+        }
+
+      g_dump_out.open (*output_path, std::ios::out | std::ios::binary);
+      if (!g_dump_out.is_open ())
+        {
+          std::cerr << "could not open `" << *output_path << "'" << std::endl;
+          abort ();
+        }
+    }
+  else if (output_path && !agent_out.open (*output_path))
+    {
+      std::cerr << "could not open `" << *output_path << "'" << std::endl;
+      abort ();
     }
 
-  get_worker_thread ().start ();
+  if (flush_interval)
+    agent_out.start_writer_thread (*flush_interval);
+
+  /* Format the info and verbose messages off the threads that log them.  */
+  if (log_level >= log_level_t::info)
+    start_log_thread (std::chrono::milliseconds (10));
+
+  std::ostream &dump_out = separate_dump_file
+                               ? static_cast<std::ostream &> (g_dump_out)
+                               : agent_out;
+  g_dump_writer = make_dump_writer (output_format, dump_out);
+
+  /* Write the end of a dump in progress before the process is aborted.  */
+  set_abort_hook ([] () {
+    if (!g_dump_thread)
+      return;
+
+    g_dump_writer->flush ();
+    if (g_dump_out.is_open ())
+      g_dump_out.flush ();
+  });
+
+  if (!g_defer_attach)
+    get_worker_thread ().start ();
 
   if (!disable_sigquit)
     {
@@ -1513,13 +3744,29 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
       sigemptyset (&sig_action.sa_mask);
 
       sig_action.sa_sigaction = [] (int signal, siginfo_t *, void *) {
-        agent_out << std::endl;
-        get_worker_thread ().query_print_waves ();
+        query_print_waves ();
       };
 
-      /* Install a SIGQUIT (Ctrl-\) handler.  */
-      sig_action.sa_flags = SA_RESTART;
-      sigaction (SIGQUIT, &sig_action, nullptr);
+      /* Install the handler of the signals requesting a dump, SIGQUIT
+         (Ctrl-\) by default.  */
+      sig_action.sa_flags = SA_RESTART | SA_SIGINFO;
+      for (int signal : dump_signals)
+        {
+          struct sigaction old_action;
+          if (sigaction (signal, &sig_action, &old_action) == -1)
+            {
+              agent_warning ("could not install a handler for signal %d "
+                             "(%s): %s",
+                             signal, strsignal (signal), strerror (errno));
+              continue;
+            }
+
+          if (old_action.sa_handler != SIG_DFL
+              && old_action.sa_handler != SIG_IGN)
+            agent_warning ("replaced the handler of signal %d (%s) "
+                           "installed by the application",
+                           signal, strsignal (signal));
+        }
     }
 
   CoreApiTable *core_table = reinterpret_cast<HsaApiTable *> (table)->core_;
@@ -1530,6 +3777,48 @@ OnLoad (void *table, uint64_t runtime_version, uint64_t failed_tool_count,
   core_table->hsa_executable_freeze_fn = debug_agent_hsa_executable_freeze;
   core_table->hsa_executable_destroy_fn = debug_agent_hsa_executable_destroy;
 
+  if (dispatch_history)
+    {
+      /* Each thread keeps more dispatches than printed per queue, since
+         a thread may dispatch to several queues.  */
+      g_dispatch_history = new dispatch_history_t (
+          std::max<size_t> (g_dispatch_history_length, 256));
+
+      original_hsa_queue_create = core_table->hsa_queue_create_fn;
+      original_hsa_queue_destroy = core_table->hsa_queue_destroy_fn;
+      original_hsa_signal_store_relaxed
+          = core_table->hsa_signal_store_relaxed_fn;
+      original_hsa_signal_store_screlease
+          = core_table->hsa_signal_store_screlease_fn;
+
+      core_table->hsa_queue_create_fn = debug_agent_hsa_queue_create;
+      core_table->hsa_queue_destroy_fn = debug_agent_hsa_queue_destroy;
+      core_table->hsa_signal_store_relaxed_fn
+          = debug_agent_hsa_signal_store_relaxed;
+      core_table->hsa_signal_store_screlease_fn
+          = debug_agent_hsa_signal_store_screlease;
+    }
+
+  if (hang_threshold)
+    {
+      g_hang_detector = new hang_detector_t (*hang_threshold);
+      g_hang_check_period = std::max<std::chrono::nanoseconds> (
+          *hang_threshold / 4, std::chrono::milliseconds (1));
+      g_next_hang_check = std::chrono::steady_clock::now ();
+
+      original_hsa_signal_wait_relaxed
+          = core_table->hsa_signal_wait_relaxed_fn;
+      original_hsa_signal_wait_scacquire
+          = core_table->hsa_signal_wait_scacquire_fn;
+
+      core_table->hsa_signal_wait_relaxed_fn
+          = debug_agent_hsa_signal_wait_relaxed;
+      core_table->hsa_signal_wait_scacquire_fn
+          = debug_agent_hsa_signal_wait_scacquire;
+    }
+
+  stats::record (stats::timer_t::on_load,
+                 std::chrono::steady_clock::now () - on_load_start);
   return true;
 }
 
@@ -1537,4 +3826,32 @@ void
 OnUnload ()
 {
   get_worker_thread ().stop ();
+
+  if (g_profile)
+    write_profile ();
+
+  if (stats::enabled ())
+    stats::print (agent_out);
+
+  if (g_dump_throttle.enabled ())
+    {
+      print_throttle_summary (true);
+
+      for (auto &&[signature, counters] : g_dump_throttle.counters ())
+        if (counters.m_stop_count != counters.m_dump_count)
+          agent_warning (
+              "%s at pc %#llx (kernel entry %#llx): %zu wavefronts in %zu "
+              "stops, %zu dumped",
+              stop_reason_string (signature.m_stop_reason).c_str (),
+              static_cast<unsigned long long> (signature.m_pc),
+              static_cast<unsigned long long> (signature.m_kernel_entry),
+              counters.m_wave_count, counters.m_stop_count,
+              counters.m_dump_count);
+    }
+
+  stop_log_thread ();
+  flush_log ();
+
+  agent_out.stop_writer_thread ();
+  agent_out.flush ();
 }
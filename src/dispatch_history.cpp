@@ -0,0 +1,336 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "dispatch_history.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <tuple>
+
+namespace amd::debug_agent
+{
+
+/* Do not record more than this number of packets for a single doorbell
+   store.  */
+constexpr uint64_t max_packets_per_store = 16;
+
+/* A marker for a queue whose packets were not recorded yet.  */
+constexpr uint64_t no_packet_id = ~uint64_t{ 0 };
+
+/* A marker for a removed queue in the queue table.  */
+constexpr uint64_t removed_doorbell = ~uint64_t{ 0 };
+
+/* The records are copied to and from the rings as words, so that a record
+   overwritten while it is being read is detected instead of being a data
+   race.  */
+constexpr size_t record_words
+    = (sizeof (dispatch_record_t) + sizeof (uint64_t) - 1) / sizeof (uint64_t);
+
+struct dispatch_history_t::ring_t
+{
+  struct slot_t
+  {
+    /* Odd while the slot is being written, 2 * (index + 1) once the record
+       at index is complete.  */
+    std::atomic<uint64_t> m_sequence{ 0 };
+    std::atomic<uint64_t> m_words[record_words];
+  };
+
+  explicit ring_t (size_t capacity)
+      : m_capacity (capacity), m_slots (new slot_t[capacity])
+  {
+  }
+
+  void push (const dispatch_record_t &record);
+  void read (std::vector<dispatch_record_t> &records) const;
+
+  const size_t m_capacity;
+  std::unique_ptr<slot_t[]> m_slots;
+
+  /* The number of records written in this ring.  */
+  std::atomic<uint64_t> m_count{ 0 };
+  /* True while a thread owns this ring.  */
+  std::atomic<bool> m_owned{ true };
+  ring_t *m_next{ nullptr };
+};
+
+struct dispatch_history_t::queue_slot_t
+{
+  /* The doorbell signal handle, 0 if the slot was never used, or
+     removed_doorbell.  */
+  std::atomic<uint64_t> m_doorbell{ 0 };
+  std::atomic<hsa_queue_t *> m_queue{ nullptr };
+  std::atomic<uint64_t> m_last_packet_id{ no_packet_id };
+  /* A copy of the queue's ring buffer address and id, which can be read
+     while the queue is being destroyed.  */
+  std::atomic<uint64_t> m_address{ 0 };
+  std::atomic<uint64_t> m_queue_id{ 0 };
+};
+
+void
+dispatch_history_t::ring_t::push (const dispatch_record_t &record)
+{
+  /* Only the owner thread writes to the ring.  */
+  const uint64_t index = m_count.load (std::memory_order_relaxed);
+  slot_t &slot = m_slots[index % m_capacity];
+
+  uint64_t words[record_words] = {};
+  memcpy (words, &record, sizeof (record));
+
+  slot.m_sequence.store (2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence (std::memory_order_release);
+  for (size_t i = 0; i < record_words; ++i)
+    slot.m_words[i].store (words[i], std::memory_order_relaxed);
+  slot.m_sequence.store (2 * (index + 1), std::memory_order_release);
+
+  m_count.store (index + 1, std::memory_order_release);
+}
+
+void
+dispatch_history_t::ring_t::read (
+    std::vector<dispatch_record_t> &records) const
+{
+  const uint64_t count = m_count.load (std::memory_order_acquire);
+  const uint64_t first = count > m_capacity ? count - m_capacity : 0;
+
+  for (uint64_t index = first; index < count; ++index)
+    {
+      const slot_t &slot = m_slots[index % m_capacity];
+
+      const uint64_t sequence
+          = slot.m_sequence.load (std::memory_order_acquire);
+      if (sequence != 2 * (index + 1))
+        continue;
+
+      uint64_t words[record_words];
+      for (size_t i = 0; i < record_words; ++i)
+        words[i] = slot.m_words[i].load (std::memory_order_relaxed);
+
+      /* Skip the record if it was overwritten while it was read.  */
+      std::atomic_thread_fence (std::memory_order_acquire);
+      if (slot.m_sequence.load (std::memory_order_relaxed) != sequence)
+        continue;
+
+      dispatch_record_t record;
+      memcpy (&record, words, sizeof (record));
+      records.push_back (record);
+    }
+}
+
+dispatch_history_t::dispatch_history_t (size_t ring_capacity)
+    : m_ring_capacity (std::max<size_t> (ring_capacity, 1)),
+      m_queues (new queue_slot_t[queue_table_size])
+{
+}
+
+dispatch_history_t::ring_t *
+dispatch_history_t::thread_ring ()
+{
+  if (ring_t *ring = m_rings.thread_slot ())
+    return ring;
+  return m_rings.acquire ([this] { return new ring_t (m_ring_capacity); });
+}
+
+dispatch_history_t::queue_slot_t *
+dispatch_history_t::find_queue (uint64_t doorbell)
+{
+  /* Signal handles are addresses, ignore their alignment bits.  */
+  size_t index = (doorbell >> 4) % queue_table_size;
+
+  for (size_t probe = 0; probe < queue_table_size; ++probe)
+    {
+      queue_slot_t &slot = m_queues[(index + probe) % queue_table_size];
+
+      uint64_t slot_doorbell
+          = slot.m_doorbell.load (std::memory_order_acquire);
+      if (slot_doorbell == doorbell)
+        return &slot;
+      if (!slot_doorbell)
+        break;
+    }
+
+  return nullptr;
+}
+
+void
+dispatch_history_t::add_queue (hsa_queue_t *queue)
+{
+  std::lock_guard<std::mutex> lock (m_queues_mutex);
+
+  const uint64_t doorbell = queue->doorbell_signal.handle;
+  size_t index = (doorbell >> 4) % queue_table_size;
+
+  for (size_t probe = 0; probe < queue_table_size; ++probe)
+    {
+      queue_slot_t &slot = m_queues[(index + probe) % queue_table_size];
+
+      uint64_t slot_doorbell
+          = slot.m_doorbell.load (std::memory_order_relaxed);
+      if (slot_doorbell && slot_doorbell != removed_doorbell)
+        continue;
+
+      slot.m_queue.store (queue, std::memory_order_relaxed);
+      slot.m_last_packet_id.store (no_packet_id, std::memory_order_relaxed);
+      slot.m_address.store (reinterpret_cast<uintptr_t> (queue->base_address),
+                            std::memory_order_relaxed);
+      slot.m_queue_id.store (queue->id, std::memory_order_relaxed);
+      slot.m_doorbell.store (doorbell, std::memory_order_release);
+      return;
+    }
+
+  /* The table is full, the dispatches to this queue are not recorded.  */
+}
+
+void
+dispatch_history_t::remove_queue (hsa_queue_t *queue)
+{
+  std::lock_guard<std::mutex> lock (m_queues_mutex);
+
+  if (queue_slot_t *slot = find_queue (queue->doorbell_signal.handle))
+    {
+      slot->m_queue.store (nullptr, std::memory_order_relaxed);
+      slot->m_doorbell.store (removed_doorbell, std::memory_order_release);
+    }
+}
+
+void
+dispatch_history_t::doorbell_store (hsa_signal_t signal,
+                                    hsa_signal_value_t value)
+{
+  queue_slot_t *slot = find_queue (signal.handle);
+  if (!slot || value < 0)
+    return;
+
+  hsa_queue_t *queue = slot->m_queue.load (std::memory_order_acquire);
+  if (!queue)
+    return;
+
+  /* Only record the packets that were not recorded by a previous store.  A
+     packet is missed if the doorbell of a multi-producer queue is rung out
+     of order, the flight recorder is best effort.  */
+  const uint64_t packet_id = value;
+  uint64_t last = slot->m_last_packet_id.load (std::memory_order_relaxed);
+  do
+    if (last != no_packet_id && last >= packet_id)
+      return;
+  while (!slot->m_last_packet_id.compare_exchange_weak (
+      last, packet_id, std::memory_order_relaxed));
+
+  /* Never read more packets than the queue holds.  */
+  const uint64_t span = std::min<uint64_t> (
+      { max_packets_per_store, queue->size, packet_id + 1 });
+  const uint64_t first = last != no_packet_id
+                             ? std::max (last + 1, packet_id + 1 - span)
+                             : packet_id;
+
+  const uint64_t timestamp
+      = std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ())
+            .count ();
+
+  ring_t *ring = nullptr;
+  for (uint64_t id = first; id <= packet_id; ++id)
+    {
+      const auto *packet
+          = static_cast<const hsa_kernel_dispatch_packet_t *> (
+                queue->base_address)
+            + (id % queue->size);
+
+      uint16_t header = __atomic_load_n (&packet->header, __ATOMIC_ACQUIRE);
+      if (((header >> HSA_PACKET_HEADER_TYPE)
+           & ((1 << HSA_PACKET_HEADER_WIDTH_TYPE) - 1))
+          != HSA_PACKET_TYPE_KERNEL_DISPATCH)
+        continue;
+
+      if (!ring)
+        ring = thread_ring ();
+
+      ring->push ({ timestamp,
+                    queue->id,
+                    id,
+                    packet->kernel_object,
+                    { packet->grid_size_x, packet->grid_size_y,
+                      packet->grid_size_z },
+                    { packet->workgroup_size_x, packet->workgroup_size_y,
+                      packet->workgroup_size_z } });
+    }
+}
+
+std::vector<dispatch_record_t>
+dispatch_history_t::last_dispatches (size_t count) const
+{
+  std::vector<dispatch_record_t> records;
+  for (const ring_t *ring = m_rings.first (); ring; ring = ring->m_next)
+    ring->read (records);
+
+  std::sort (records.begin (), records.end (),
+             [] (const dispatch_record_t &lhs, const dispatch_record_t &rhs) {
+               return std::tie (lhs.m_queue_id, lhs.m_packet_id)
+                      < std::tie (rhs.m_queue_id, rhs.m_packet_id);
+             });
+
+  /* Only keep the last COUNT dispatches of each queue.  */
+  std::vector<dispatch_record_t> last;
+  for (size_t i = 0; i < records.size (); ++i)
+    {
+      size_t queue_end = i;
+      while (queue_end < records.size ()
+             && records[queue_end].m_queue_id == records[i].m_queue_id)
+        ++queue_end;
+
+      const size_t queue_first
+          = queue_end - std::min (count, queue_end - i);
+      last.insert (last.end (), records.begin () + queue_first,
+                   records.begin () + queue_end);
+      i = queue_end - 1;
+    }
+
+  return last;
+}
+
+std::optional<uint64_t>
+dispatch_history_t::queue_id (uint64_t address) const
+{
+  for (size_t i = 0; i < queue_table_size; ++i)
+    {
+      const queue_slot_t &slot = m_queues[i];
+
+      const uint64_t doorbell
+          = slot.m_doorbell.load (std::memory_order_acquire);
+      if (doorbell && doorbell != removed_doorbell
+          && slot.m_address.load (std::memory_order_relaxed) == address)
+        return slot.m_queue_id.load (std::memory_order_relaxed);
+    }
+
+  return std::nullopt;
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,118 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_DISPATCH_HISTORY_H
+#define _ROCM_DEBUG_AGENT_DISPATCH_HISTORY_H 1
+
+#include "thread_slots.h"
+
+#include <hsa/hsa.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* A kernel dispatch packet submitted to a queue.  */
+struct dispatch_record_t
+{
+  /* The steady_clock time the doorbell was rung, in nanoseconds.  */
+  uint64_t m_timestamp;
+  uint64_t m_queue_id;
+  uint64_t m_packet_id;
+  uint64_t m_kernel_object;
+  uint32_t m_grid_size[3];
+  uint16_t m_workgroup_size[3];
+};
+
+/* A flight recorder of the kernels dispatched by the application.  The
+   doorbell stores are intercepted, and the kernel dispatch packets made
+   visible to the packet processor by each store are recorded in a ring
+   buffer owned by the storing thread.  Recording takes no lock and does not
+   allocate memory, except for the first dispatch of a thread.  The rings
+   are only read when a dump is printed.  */
+
+class dispatch_history_t
+{
+public:
+  /* Keep RING_CAPACITY dispatches per thread.  */
+  explicit dispatch_history_t (size_t ring_capacity);
+
+  dispatch_history_t (const dispatch_history_t &) = delete;
+  dispatch_history_t &operator= (const dispatch_history_t &) = delete;
+
+  /* Start and stop watching the doorbell of QUEUE.  */
+  void add_queue (hsa_queue_t *queue);
+  void remove_queue (hsa_queue_t *queue);
+
+  /* Record the kernel dispatch packets up to PACKET_ID if SIGNAL is the
+     doorbell of a watched queue.  This must be called before the doorbell is
+     stored, while the packets are still in the queue.  */
+  void doorbell_store (hsa_signal_t signal, hsa_signal_value_t packet_id);
+
+  /* Return the last COUNT dispatches of each queue, sorted by queue and
+     by packet id.  */
+  std::vector<dispatch_record_t> last_dispatches (size_t count) const;
+
+  /* Return the id recorded in the dispatches of the watched queue whose ring
+     buffer is at ADDRESS, if there is one.  */
+  std::optional<uint64_t> queue_id (uint64_t address) const;
+
+private:
+  struct ring_t;
+  struct queue_slot_t;
+
+  ring_t *thread_ring ();
+  queue_slot_t *find_queue (uint64_t doorbell);
+
+  const size_t m_ring_capacity;
+
+  /* The rings of all the threads that dispatched kernels.  The ring of a
+     thread that exited is reused by the next thread that needs one.  The
+     rings are never freed, see thread_slots_t.  */
+  thread_slots_t<ring_t> m_rings;
+
+  /* An open addressing hash table of the watched queues, indexed by their
+     doorbell signal handle.  Lookups take no lock, insertions and removals
+     are serialized by m_queues_mutex.  */
+  static constexpr size_t queue_table_size = 4096;
+  std::unique_ptr<queue_slot_t[]> m_queues;
+  std::mutex m_queues_mutex;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_DISPATCH_HISTORY_H */
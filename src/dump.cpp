@@ -0,0 +1,543 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "dump.h"
+#include "debug.h"
+#include "logging.h"
+
+#include <amd-dbgapi/amd-dbgapi.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+std::string
+hex_string (const std::vector<uint8_t> &value)
+{
+  std::string value_string;
+  value_string.reserve (2 * value.size ());
+
+  for (size_t pos = value.size (); pos > 0; --pos)
+    {
+      static constexpr char hex_digits[] = "0123456789abcdef";
+      value_string.push_back (hex_digits[value[pos - 1] >> 4]);
+      value_string.push_back (hex_digits[value[pos - 1] & 0xF]);
+    }
+
+  return value_string;
+}
+
+std::string
+register_value_string (const std::string &register_type,
+                       const std::vector<uint8_t> &register_value)
+{
+  /* handle vector types..  */
+  if (size_t pos = register_type.find_last_of ('['); pos != std::string::npos)
+    {
+      const std::string element_type = register_type.substr (0, pos);
+      const size_t element_count = std::stoi (register_type.substr (pos + 1));
+      const size_t element_size = register_value.size () / element_count;
+
+      agent_assert ((register_value.size () % element_size) == 0);
+
+      std::stringstream ss;
+      for (size_t i = 0; i < element_count; ++i)
+        {
+          if (i != 0)
+            ss << " ";
+          ss << "[" << i << "] ";
+
+          std::vector<uint8_t> element_value (
+              &register_value[element_size * i],
+              &register_value[element_size * (i + 1)]);
+
+          ss << register_value_string (element_type, element_value);
+        }
+      return ss.str ();
+    }
+
+  return hex_string (register_value);
+}
+
+/* A stream buffer that forwards its output to another stream buffer and
+   counts the number of bytes written.  */
+
+class counting_buffer_t : public std::streambuf
+{
+public:
+  counting_buffer_t (std::streambuf *target) : m_target (target) {}
+
+  uint64_t count () const { return m_count; }
+
+protected:
+  std::streamsize xsputn (const char *data, std::streamsize size) override
+  {
+    std::streamsize written = m_target->sputn (data, size);
+    m_count += written;
+    return written;
+  }
+
+  int_type overflow (int_type c) override
+  {
+    if (traits_type::eq_int_type (c, traits_type::eof ()))
+      return traits_type::not_eof (c);
+
+    ++m_count;
+    return m_target->sputc (traits_type::to_char_type (c));
+  }
+
+  int sync () override { return m_target->pubsync (); }
+
+private:
+  std::streambuf *m_target;
+  uint64_t m_count{ 0 };
+};
+
+/* Format the dump records as human readable text.  This is the format the
+   debug agent has always produced.  */
+
+class text_writer_t : public dump_writer_t
+{
+public:
+  text_writer_t (std::ostream &out)
+      : m_buffer (out.rdbuf ()), m_out (&m_buffer)
+  {
+  }
+
+  void begin_dump () override
+  {
+    m_first_wave = true;
+    m_current_wave.reset ();
+  }
+  void end_dump () override { m_out.flush (); }
+  void flush () override { m_out.flush (); }
+
+  void code_object (const code_object_info_t &code_object) override {}
+  void wave (const wave_info_t &wave) override;
+  void registers (uint64_t wave_id,
+                  const std::vector<register_class_t> &classes) override;
+  void local_memory (uint64_t wave_id,
+                     const std::vector<uint8_t> &contents) override;
+  void disassembly (uint64_t wave_id,
+                    const disassembly_t &disassembly) override;
+  void end_wave (uint64_t wave_id) override {}
+  void hot_spots (uint64_t wave_count,
+                  const std::vector<hot_spot_t> &hot_spots) override;
+  void
+  dispatch_history (const std::vector<dispatch_info_t> &dispatches) override;
+
+  uint64_t bytes_written () const override { return m_buffer.count (); }
+
+private:
+  /* Print a separator, unless this is the first record of the dump.  */
+  void separator ();
+  /* The details of a wave printed after other records are preceded by a
+     continuation header so that they can be identified.  */
+  void continue_wave (uint64_t wave_id);
+
+  counting_buffer_t m_buffer;
+  std::ostream m_out;
+  bool m_first_wave{ true };
+  /* The wave whose details the next records belong to.  */
+  std::optional<uint64_t> m_current_wave;
+};
+
+void
+text_writer_t::separator ()
+{
+  if (!m_first_wave)
+    m_out << '\n';
+  m_first_wave = false;
+
+  m_out << "--------------------------------------------------------"
+        << '\n';
+}
+
+void
+text_writer_t::continue_wave (uint64_t wave_id)
+{
+  if (m_current_wave == wave_id)
+    return;
+
+  separator ();
+  m_out << "wave_" << std::dec << wave_id << " (continued):" << '\n';
+  m_current_wave.emplace (wave_id);
+}
+
+void
+text_writer_t::wave (const wave_info_t &wave)
+{
+  scoped_format_t format (m_out);
+
+  separator ();
+  m_current_wave.emplace (wave.m_wave_id);
+
+  m_out << "wave_" << std::dec << wave.m_wave_id << ": pc=0x" << std::hex
+        << wave.m_pc << " (kernel_code_entry=";
+
+  if (wave.m_kernel_entry)
+    {
+      m_out << "0x" << std::hex << *wave.m_kernel_entry;
+
+      if (wave.m_kernel_name)
+        m_out << " <" << *wave.m_kernel_name << ">";
+    }
+  else
+    m_out << "not available";
+
+  m_out << ")";
+
+  /* The dispatch and queue ids are left to the json and binary records, the
+     tools that parse this line expect its original format.  */
+  m_out << " (";
+  if (wave.m_stop_reason != AMD_DBGAPI_WAVE_STOP_REASON_NONE)
+    m_out << "stopped, reason: " << stop_reason_string (wave.m_stop_reason);
+  else
+    m_out << "running";
+  m_out << ")" << '\n';
+}
+
+void
+text_writer_t::hot_spots (uint64_t wave_count,
+                          const std::vector<hot_spot_t> &hot_spots)
+{
+  scoped_format_t format (m_out);
+
+  separator ();
+  m_current_wave.reset ();
+  m_out << "Hot spots (" << std::dec << wave_count << " wavefronts):" << '\n';
+
+  for (auto &&hot_spot : hot_spots)
+    {
+      m_out << '\n'
+            << std::dec << std::setw (8) << hot_spot.m_wave_count << " ("
+            << std::fixed << std::setprecision (1) << std::setw (5)
+            << (100.0 * hot_spot.m_wave_count / wave_count) << "%)  ";
+
+      if (hot_spot.m_function_name)
+        m_out << *hot_spot.m_function_name;
+      else
+        m_out << "<unknown function>";
+
+      if (hot_spot.m_file_name)
+        m_out << " at " << *hot_spot.m_file_name << ":" << hot_spot.m_line;
+
+      if (hot_spot.m_kernel_name
+          && hot_spot.m_kernel_name != hot_spot.m_function_name)
+        m_out << " (kernel " << *hot_spot.m_kernel_name << ")";
+
+      m_out << '\n';
+
+      for (auto &&pc : hot_spot.m_pcs)
+        m_out << "                  " << std::dec << std::setw (8)
+              << pc.m_wave_count << "  pc=0x" << std::hex << pc.m_pc
+              << '\n';
+    }
+}
+
+void
+text_writer_t::dispatch_history (
+    const std::vector<dispatch_info_t> &dispatches)
+{
+  scoped_format_t format (m_out);
+
+  separator ();
+  m_current_wave.reset ();
+  m_out << "Dispatch history (most recent last):" << '\n';
+
+  std::optional<uint64_t> queue_id;
+  for (auto &&dispatch : dispatches)
+    {
+      if (dispatch.m_queue_id != queue_id)
+        {
+          queue_id = dispatch.m_queue_id;
+          m_out << '\n' << "queue " << std::dec << *queue_id << ":" << '\n';
+        }
+
+      m_out << "  packet " << std::dec << std::left << std::setw (8)
+            << dispatch.m_packet_id << std::right << std::fixed
+            << std::setprecision (3) << std::setw (12)
+            << dispatch.m_age / 1e6 << " ms ago  kernel_object=0x" << std::hex
+            << dispatch.m_kernel_object;
+
+      if (dispatch.m_kernel_name)
+        m_out << " <" << *dispatch.m_kernel_name << ">";
+
+      m_out << std::dec << " grid=[" << dispatch.m_grid_size[0] << ","
+            << dispatch.m_grid_size[1] << "," << dispatch.m_grid_size[2]
+            << "] workgroup=[" << dispatch.m_workgroup_size[0] << ","
+            << dispatch.m_workgroup_size[1] << ","
+            << dispatch.m_workgroup_size[2] << "]" << '\n';
+    }
+}
+
+void
+text_writer_t::registers (uint64_t wave_id,
+                          const std::vector<register_class_t> &classes)
+{
+  scoped_format_t format (m_out);
+
+  continue_wave (wave_id);
+
+  for (auto &&register_class : classes)
+    {
+      m_out << '\n' << register_class.m_name << " registers:";
+
+      size_t last_register_size = 0;
+      size_t column = 0;
+      for (auto &&reg : register_class.m_registers)
+        {
+          const size_t register_size = reg.m_value.size ();
+          const size_t num_register_per_line = 16 / register_size;
+
+          if (register_size > sizeof (uint64_t) /* Registers larger than a
+                                                   uint64_t are printed each
+                                                   on a separate line.  */
+              || register_size != last_register_size
+              || (column++ % num_register_per_line) == 0)
+            {
+              m_out << '\n';
+              column = 1;
+            }
+
+          last_register_size = register_size;
+
+          m_out << std::right << std::setfill (' ') << std::setw (16)
+                << (reg.m_name + ": ")
+                << register_value_string (reg.m_type, reg.m_value);
+        }
+
+      m_out << '\n';
+    }
+}
+
+void
+text_writer_t::local_memory (uint64_t wave_id,
+                             const std::vector<uint8_t> &contents)
+{
+  scoped_format_t format (m_out);
+
+  if (contents.empty ())
+    return;
+
+  continue_wave (wave_id);
+  m_out << '\n' << "Local memory content:";
+
+  for (size_t offset = 0; offset + sizeof (uint32_t) <= contents.size ();
+       offset += sizeof (uint32_t))
+    {
+      if ((offset % (8 * sizeof (uint32_t))) == 0)
+        m_out << '\n'
+              << "    0x" << std::right << std::hex << std::setfill ('0')
+              << std::setw (4) << offset << ":";
+
+      uint32_t word = contents[offset] | contents[offset + 1] << 8
+                      | contents[offset + 2] << 16
+                      | static_cast<uint32_t> (contents[offset + 3]) << 24;
+
+      m_out << " " << std::hex << std::setfill ('0') << std::setw (8)
+            << word;
+    }
+
+  m_out << '\n';
+}
+
+void
+text_writer_t::disassembly (uint64_t wave_id, const disassembly_t &disassembly)
+{
+  scoped_format_t format (m_out);
+
+  continue_wave (wave_id);
+  m_out << '\n' << "Disassembly";
+  if (disassembly.m_function_name)
+    m_out << " for function " << *disassembly.m_function_name;
+  m_out << ":" << '\n';
+
+  m_out << "    code object: " << disassembly.m_uri << '\n';
+  m_out << "    loaded at: "
+        << "[0x" << std::hex << disassembly.m_load_address << "-"
+        << "0x" << std::hex
+        << (disassembly.m_load_address + disassembly.m_mem_size) << "]"
+        << '\n';
+
+  for (auto &&line : disassembly.m_lines)
+    switch (line.m_kind)
+      {
+      case disassembly_line_t::kind_t::blank:
+        m_out << '\n';
+        break;
+
+      case disassembly_line_t::kind_t::file:
+        m_out << line.m_text << ":" << '\n';
+        break;
+
+      case disassembly_line_t::kind_t::source:
+        m_out << std::setfill (' ') << std::setw (8) << std::left << std::dec
+              << line.m_value << line.m_text << '\n';
+        break;
+
+      case disassembly_line_t::kind_t::ellipsis:
+        m_out << "    ..." << '\n';
+        break;
+
+      case disassembly_line_t::kind_t::instruction:
+        {
+          const uint64_t addr = line.m_value;
+          m_out << ((addr == disassembly.m_pc) ? " => " : "    ");
+
+          m_out << "0x" << std::hex << addr;
+          if (auto function_address = disassembly.m_function_address)
+            {
+              m_out << " <";
+              if (addr >= *function_address)
+                m_out << "+" << std::dec << (addr - *function_address);
+              else
+                m_out << "-" << std::dec << (*function_address - addr);
+              m_out << ">";
+            }
+
+          m_out << ":    " << line.m_text << '\n';
+          break;
+        }
+
+      case disassembly_line_t::kind_t::memory_error:
+        m_out << "Cannot access memory at address 0x" << std::hex
+              << line.m_value << '\n';
+        break;
+      }
+
+  m_out << '\n' << "End of disassembly." << '\n';
+}
+
+} /* namespace */
+
+const char *
+stop_reason_name (uint64_t stop_reason_bit)
+{
+  switch (static_cast<amd_dbgapi_wave_stop_reasons_t> (stop_reason_bit))
+    {
+    case AMD_DBGAPI_WAVE_STOP_REASON_NONE:
+      return "NONE";
+    case AMD_DBGAPI_WAVE_STOP_REASON_BREAKPOINT:
+      return "BREAKPOINT";
+    case AMD_DBGAPI_WAVE_STOP_REASON_WATCHPOINT:
+      return "WATCHPOINT";
+    case AMD_DBGAPI_WAVE_STOP_REASON_SINGLE_STEP:
+      return "SINGLE_STEP";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_INPUT_DENORMAL:
+      return "FP_INPUT_DENORMAL";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_DIVIDE_BY_0:
+      return "FP_DIVIDE_BY_0";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_OVERFLOW:
+      return "FP_OVERFLOW";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_UNDERFLOW:
+      return "FP_UNDERFLOW";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_INEXACT:
+      return "FP_INEXACT";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FP_INVALID_OPERATION:
+      return "FP_INVALID_OPERATION";
+    case AMD_DBGAPI_WAVE_STOP_REASON_INT_DIVIDE_BY_0:
+      return "INT_DIVIDE_BY_0";
+    case AMD_DBGAPI_WAVE_STOP_REASON_DEBUG_TRAP:
+      return "DEBUG_TRAP";
+    case AMD_DBGAPI_WAVE_STOP_REASON_ASSERT_TRAP:
+      return "ASSERT_TRAP";
+    case AMD_DBGAPI_WAVE_STOP_REASON_TRAP:
+      return "TRAP";
+    case AMD_DBGAPI_WAVE_STOP_REASON_MEMORY_VIOLATION:
+      return "MEMORY_VIOLATION";
+    case AMD_DBGAPI_WAVE_STOP_REASON_ADDRESS_ERROR:
+      return "ADDRESS_ERROR";
+    case AMD_DBGAPI_WAVE_STOP_REASON_ILLEGAL_INSTRUCTION:
+      return "ILLEGAL_INSTRUCTION";
+    case AMD_DBGAPI_WAVE_STOP_REASON_ECC_ERROR:
+      return "ECC_ERROR";
+    case AMD_DBGAPI_WAVE_STOP_REASON_FATAL_HALT:
+      return "FATAL_HALT";
+#if AMD_DBGAPI_VERSION_MAJOR == 0 && AMD_DBGAPI_VERSION_MINOR < 58
+    case AMD_DBGAPI_WAVE_STOP_REASON_RESERVED:
+      return "RESERVED";
+#endif
+    }
+  return "";
+}
+
+std::string
+stop_reason_string (uint64_t stop_reason)
+{
+  std::string stop_reason_str;
+  auto stop_reason_bits{ stop_reason };
+  do
+    {
+      /* Consume one bit from the stop reason.  */
+      auto one_bit
+          = stop_reason_bits ^ (stop_reason_bits & (stop_reason_bits - 1));
+      stop_reason_bits ^= one_bit;
+
+      if (!stop_reason_str.empty ())
+        stop_reason_str += "|";
+
+      stop_reason_str += stop_reason_name (one_bit);
+    }
+  while (stop_reason_bits);
+
+  return stop_reason_str;
+}
+
+std::unique_ptr<dump_writer_t>
+detail::make_text_writer (std::ostream &out)
+{
+  return std::make_unique<text_writer_t> (out);
+}
+
+std::unique_ptr<dump_writer_t>
+make_dump_writer (output_format_t format, std::ostream &out)
+{
+  switch (format)
+    {
+    case output_format_t::text:
+      return detail::make_text_writer (out);
+    case output_format_t::binary:
+      return detail::make_binary_writer (out);
+    case output_format_t::json:
+      return detail::make_json_writer (out);
+    }
+
+  agent_error ("invalid output format %d", static_cast<int> (format));
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,238 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_DUMP_H
+#define _ROCM_DEBUG_AGENT_DUMP_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* A wavefront dump is collected from dbgapi as a sequence of snapshot
+   records which are handed to a dump_writer_t.  The writer decides how the
+   records are formatted, which allows the same collection code to produce
+   the human readable text, or a compact binary stream that is rendered into
+   text later by rocm-debug-agent-print.  */
+
+enum class output_format_t
+{
+  /* Human readable text (the default).  */
+  text,
+  /* Versioned, length-prefixed binary records.  */
+  binary,
+  /* Newline delimited JSON, one self-contained object per record.  */
+  json
+};
+
+struct code_object_info_t
+{
+  uint64_t m_load_address;
+  uint64_t m_mem_size;
+  std::string m_uri;
+};
+
+struct wave_info_t
+{
+  uint64_t m_wave_id;
+  uint64_t m_pc;
+  /* A mask of amd_dbgapi_wave_stop_reasons_t bits.  */
+  uint64_t m_stop_reason;
+  std::optional<uint64_t> m_kernel_entry;
+  std::optional<std::string> m_kernel_name;
+  /* The dbgapi id of the dispatch that created the wave, as matched by
+     --dispatch.  */
+  std::optional<uint64_t> m_dispatch_id;
+  /* The id of the HSA queue of the wave, as printed by the dispatch
+     history.  */
+  std::optional<uint64_t> m_queue_id;
+};
+
+struct register_value_t
+{
+  std::string m_name;
+  std::string m_type;
+  std::vector<uint8_t> m_value;
+};
+
+struct register_class_t
+{
+  std::string m_name;
+  std::vector<register_value_t> m_registers;
+};
+
+struct disassembly_line_t
+{
+  enum class kind_t : uint8_t
+  {
+    /* An empty line.  */
+    blank = 0,
+    /* The name of the source file (m_text) for the following lines.  */
+    file = 1,
+    /* Source line number m_value, its text is m_text.  */
+    source = 2,
+    /* "..." to show that instructions were omitted.  */
+    ellipsis = 3,
+    /* The instruction at address m_value, disassembled as m_text.  */
+    instruction = 4,
+    /* The memory at address m_value could not be read.  */
+    memory_error = 5
+  };
+
+  kind_t m_kind;
+  uint64_t m_value;
+  std::string m_text;
+};
+
+struct disassembly_t
+{
+  /* The function that contains the pc, if known.  */
+  std::optional<std::string> m_function_name;
+  std::optional<uint64_t> m_function_address;
+
+  std::string m_uri;
+  uint64_t m_load_address;
+  uint64_t m_mem_size;
+  uint64_t m_pc;
+
+  std::vector<disassembly_line_t> m_lines;
+};
+
+/* A location where wavefronts are stopped, used to summarize a dump.  */
+struct hot_spot_t
+{
+  struct pc_t
+  {
+    uint64_t m_pc;
+    uint64_t m_wave_count;
+  };
+
+  /* The kernel being executed, and the function and source line containing
+     the pcs, if known.  */
+  std::optional<std::string> m_kernel_name;
+  std::optional<std::string> m_function_name;
+  std::optional<std::string> m_file_name;
+  uint64_t m_line;
+
+  uint64_t m_wave_count;
+  /* The pcs of the waves at this location, most frequent first.  */
+  std::vector<pc_t> m_pcs;
+};
+
+/* A kernel dispatch recorded by the dispatch history.  */
+struct dispatch_info_t
+{
+  uint64_t m_queue_id;
+  uint64_t m_packet_id;
+  uint64_t m_kernel_object;
+  /* The name of the dispatched kernel, if known.  */
+  std::optional<std::string> m_kernel_name;
+  uint32_t m_grid_size[3];
+  uint32_t m_workgroup_size[3];
+  /* The time between the dispatch and the dump, in nanoseconds.  */
+  uint64_t m_age;
+};
+
+class dump_writer_t
+{
+public:
+  virtual ~dump_writer_t () = default;
+
+  virtual void begin_dump () = 0;
+  virtual void end_dump () = 0;
+
+  virtual void code_object (const code_object_info_t &code_object) = 0;
+  virtual void wave (const wave_info_t &wave) = 0;
+  virtual void registers (uint64_t wave_id,
+                          const std::vector<register_class_t> &classes)
+      = 0;
+  virtual void local_memory (uint64_t wave_id,
+                             const std::vector<uint8_t> &contents)
+      = 0;
+  virtual void disassembly (uint64_t wave_id, const disassembly_t &disassembly)
+      = 0;
+  /* No more details of WAVE_ID follow the ones printed since its last
+     record.  */
+  virtual void end_wave (uint64_t wave_id) = 0;
+
+  /* The locations of the WAVE_COUNT waves listed by the dump, most frequent
+     first.  */
+  virtual void hot_spots (uint64_t wave_count,
+                          const std::vector<hot_spot_t> &hot_spots)
+      = 0;
+
+  /* The last kernels dispatched to each queue, sorted by queue and by
+     packet id.  */
+  virtual void
+  dispatch_history (const std::vector<dispatch_info_t> &dispatches)
+      = 0;
+
+  /* Write the complete records that are still buffered.  */
+  virtual void flush () = 0;
+
+  /* Return the number of bytes of output produced by this writer so far,
+     including the output that is still buffered.  */
+  virtual uint64_t bytes_written () const = 0;
+};
+
+/* Return the name of the stop reason STOP_REASON_BIT, which must have at most
+   one bit set.  */
+const char *stop_reason_name (uint64_t stop_reason_bit);
+
+/* Return a '|' separated list of the names of the STOP_REASON bits.  */
+std::string stop_reason_string (uint64_t stop_reason);
+
+std::unique_ptr<dump_writer_t> make_dump_writer (output_format_t format,
+                                                 std::ostream &out);
+
+namespace detail
+{
+
+std::unique_ptr<dump_writer_t> make_text_writer (std::ostream &out);
+std::unique_ptr<dump_writer_t> make_binary_writer (std::ostream &out);
+std::unique_ptr<dump_writer_t> make_json_writer (std::ostream &out);
+
+} /* namespace detail */
+
+/* Read a binary dump from IN and replay its records into WRITER.  Return
+   false if IN is not a binary dump, is truncated, or has a register whose
+   value does not match its size or type.  */
+bool read_binary_dump (std::istream &in, dump_writer_t &writer);
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_DUMP_H */
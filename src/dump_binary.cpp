@@ -0,0 +1,685 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "dump.h"
+#include "debug.h"
+#include "logging.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/* The binary dump format.
+
+   The file starts with a header made of the 8 byte magic "RDADUMP\0"
+   followed by a 32-bit format version and a 32-bit byte order mark.  The
+   header is followed by a sequence of records.  Each record is a 32-bit
+   record type, a 32-bit payload size, and the payload.  All integers are
+   stored in the byte order of the process that wrote the dump, strings and
+   byte vectors are stored as a 32-bit length followed by the data.
+
+   Readers must skip records of an unknown type, and ignore trailing bytes
+   in the payload of known records, so that fields can be appended to a
+   record without bumping the format version.  */
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+constexpr char binary_dump_magic[8] = { 'R', 'D', 'A', 'D', 'U', 'M', 'P', 0 };
+constexpr uint32_t binary_dump_version = 1;
+constexpr uint32_t binary_dump_byte_order_mark = 0x01020304;
+
+enum class record_type_t : uint32_t
+{
+  begin_dump = 1,
+  end_dump = 2,
+  code_object = 3,
+  wave = 4,
+  registers = 5,
+  local_memory = 6,
+  disassembly = 7,
+  hot_spots = 8,
+  dispatch_history = 9
+};
+
+/* Records are accumulated in a large buffer and written to the output stream
+   in as few writes as possible.  */
+constexpr size_t flush_threshold = 1024 * 1024;
+
+class binary_writer_t : public dump_writer_t
+{
+public:
+  binary_writer_t (std::ostream &out);
+  ~binary_writer_t () override { flush (); }
+
+  void begin_dump () override;
+  void end_dump () override;
+
+  void code_object (const code_object_info_t &code_object) override;
+  void wave (const wave_info_t &wave) override;
+  void registers (uint64_t wave_id,
+                  const std::vector<register_class_t> &classes) override;
+  void local_memory (uint64_t wave_id,
+                     const std::vector<uint8_t> &contents) override;
+  void disassembly (uint64_t wave_id,
+                    const disassembly_t &disassembly) override;
+  void end_wave (uint64_t wave_id) override {}
+  void hot_spots (uint64_t wave_count,
+                  const std::vector<hot_spot_t> &hot_spots) override;
+  void
+  dispatch_history (const std::vector<dispatch_info_t> &dispatches) override;
+
+  void flush () override;
+
+  uint64_t bytes_written () const override
+  {
+    return m_bytes_flushed + m_buffer.size ();
+  }
+
+private:
+  template <typename T> void put (T value)
+  {
+    static_assert (std::is_trivially_copyable_v<T>);
+    const char *bytes = reinterpret_cast<const char *> (&value);
+    m_buffer.insert (m_buffer.end (), bytes, bytes + sizeof (value));
+  }
+
+  void put_bytes (const void *data, size_t size)
+  {
+    put (static_cast<uint32_t> (size));
+    const char *bytes = static_cast<const char *> (data);
+    m_buffer.insert (m_buffer.end (), bytes, bytes + size);
+  }
+
+  void put (const std::string &value)
+  {
+    put_bytes (value.data (), value.size ());
+  }
+
+  void put (const std::vector<uint8_t> &value)
+  {
+    put_bytes (value.data (), value.size ());
+  }
+
+  void begin_record (record_type_t type);
+  void end_record ();
+
+  std::ostream &m_out;
+  std::vector<char> m_buffer;
+  /* Offset in m_buffer of the current record's payload size.  */
+  size_t m_record_start{ 0 };
+  bool m_in_record{ false };
+  uint64_t m_bytes_flushed{ 0 };
+};
+
+binary_writer_t::binary_writer_t (std::ostream &out) : m_out (out)
+{
+  m_buffer.reserve (2 * flush_threshold);
+
+  m_buffer.insert (m_buffer.end (), std::begin (binary_dump_magic),
+                   std::end (binary_dump_magic));
+  put (binary_dump_version);
+  put (binary_dump_byte_order_mark);
+  flush ();
+}
+
+void
+binary_writer_t::begin_record (record_type_t type)
+{
+  put (static_cast<uint32_t> (type));
+  m_record_start = m_buffer.size ();
+  m_in_record = true;
+  put (uint32_t{ 0 });
+}
+
+void
+binary_writer_t::end_record ()
+{
+  uint32_t payload_size
+      = m_buffer.size () - m_record_start - sizeof (uint32_t);
+  std::memcpy (&m_buffer[m_record_start], &payload_size,
+               sizeof (payload_size));
+  m_in_record = false;
+
+  if (m_buffer.size () >= flush_threshold)
+    flush ();
+}
+
+void
+binary_writer_t::flush ()
+{
+  /* Keep the record being written, its payload size is not known yet.  */
+  const size_t size = m_in_record
+                          ? m_record_start - sizeof (record_type_t)
+                          : m_buffer.size ();
+  if (size == 0)
+    return;
+
+  m_out.write (m_buffer.data (), size);
+  m_out.flush ();
+  m_bytes_flushed += size;
+  m_buffer.erase (m_buffer.begin (), m_buffer.begin () + size);
+  if (m_in_record)
+    m_record_start -= size;
+}
+
+void
+binary_writer_t::begin_dump ()
+{
+  timespec now;
+  clock_gettime (CLOCK_REALTIME, &now);
+
+  begin_record (record_type_t::begin_dump);
+  put (static_cast<uint64_t> (now.tv_sec) * 1000000000 + now.tv_nsec);
+  put (static_cast<uint32_t> (getpid ()));
+  end_record ();
+}
+
+void
+binary_writer_t::end_dump ()
+{
+  begin_record (record_type_t::end_dump);
+  end_record ();
+  flush ();
+}
+
+void
+binary_writer_t::code_object (const code_object_info_t &code_object)
+{
+  begin_record (record_type_t::code_object);
+  put (code_object.m_load_address);
+  put (code_object.m_mem_size);
+  put (code_object.m_uri);
+  end_record ();
+}
+
+void
+binary_writer_t::wave (const wave_info_t &wave)
+{
+  begin_record (record_type_t::wave);
+  put (wave.m_wave_id);
+  put (wave.m_pc);
+  put (wave.m_stop_reason);
+  put (static_cast<uint8_t> (wave.m_kernel_entry.has_value ()));
+  put (wave.m_kernel_entry.value_or (0));
+  put (static_cast<uint8_t> (wave.m_kernel_name.has_value ()));
+  put (wave.m_kernel_name.value_or (""));
+  put (static_cast<uint8_t> (wave.m_dispatch_id.has_value ()));
+  put (wave.m_dispatch_id.value_or (0));
+  put (static_cast<uint8_t> (wave.m_queue_id.has_value ()));
+  put (wave.m_queue_id.value_or (0));
+  end_record ();
+}
+
+void
+binary_writer_t::registers (uint64_t wave_id,
+                            const std::vector<register_class_t> &classes)
+{
+  begin_record (record_type_t::registers);
+  put (wave_id);
+  put (static_cast<uint32_t> (classes.size ()));
+  for (auto &&register_class : classes)
+    {
+      put (register_class.m_name);
+      put (static_cast<uint32_t> (register_class.m_registers.size ()));
+      for (auto &&reg : register_class.m_registers)
+        {
+          put (reg.m_name);
+          put (reg.m_type);
+          put (reg.m_value);
+        }
+    }
+  end_record ();
+}
+
+void
+binary_writer_t::local_memory (uint64_t wave_id,
+                               const std::vector<uint8_t> &contents)
+{
+  begin_record (record_type_t::local_memory);
+  put (wave_id);
+  put (contents);
+  end_record ();
+}
+
+void
+binary_writer_t::disassembly (uint64_t wave_id,
+                              const disassembly_t &disassembly)
+{
+  begin_record (record_type_t::disassembly);
+  put (wave_id);
+  put (static_cast<uint8_t> (disassembly.m_function_name.has_value ()));
+  put (disassembly.m_function_name.value_or (""));
+  put (static_cast<uint8_t> (disassembly.m_function_address.has_value ()));
+  put (disassembly.m_function_address.value_or (0));
+  put (disassembly.m_uri);
+  put (disassembly.m_load_address);
+  put (disassembly.m_mem_size);
+  put (disassembly.m_pc);
+  put (static_cast<uint32_t> (disassembly.m_lines.size ()));
+  for (auto &&line : disassembly.m_lines)
+    {
+      put (static_cast<uint8_t> (line.m_kind));
+      put (line.m_value);
+      put (line.m_text);
+    }
+  end_record ();
+}
+
+void
+binary_writer_t::hot_spots (uint64_t wave_count,
+                            const std::vector<hot_spot_t> &hot_spots)
+{
+  begin_record (record_type_t::hot_spots);
+  put (wave_count);
+  put (static_cast<uint32_t> (hot_spots.size ()));
+  for (auto &&hot_spot : hot_spots)
+    {
+      put (static_cast<uint8_t> (hot_spot.m_kernel_name.has_value ()));
+      put (hot_spot.m_kernel_name.value_or (""));
+      put (static_cast<uint8_t> (hot_spot.m_function_name.has_value ()));
+      put (hot_spot.m_function_name.value_or (""));
+      put (static_cast<uint8_t> (hot_spot.m_file_name.has_value ()));
+      put (hot_spot.m_file_name.value_or (""));
+      put (hot_spot.m_line);
+      put (hot_spot.m_wave_count);
+      put (static_cast<uint32_t> (hot_spot.m_pcs.size ()));
+      for (auto &&pc : hot_spot.m_pcs)
+        {
+          put (pc.m_pc);
+          put (pc.m_wave_count);
+        }
+    }
+  end_record ();
+}
+
+void
+binary_writer_t::dispatch_history (
+    const std::vector<dispatch_info_t> &dispatches)
+{
+  begin_record (record_type_t::dispatch_history);
+  put (static_cast<uint32_t> (dispatches.size ()));
+  for (auto &&dispatch : dispatches)
+    {
+      put (dispatch.m_queue_id);
+      put (dispatch.m_packet_id);
+      put (dispatch.m_kernel_object);
+      put (static_cast<uint8_t> (dispatch.m_kernel_name.has_value ()));
+      put (dispatch.m_kernel_name.value_or (""));
+      for (uint32_t size : dispatch.m_grid_size)
+        put (size);
+      for (uint32_t size : dispatch.m_workgroup_size)
+        put (size);
+      put (dispatch.m_age);
+    }
+  end_record ();
+}
+
+/* Decode the payload of a record.  Reading past the end of the payload
+   clears m_ok and returns zero/empty values.  */
+
+class payload_reader_t
+{
+public:
+  payload_reader_t (const std::vector<char> &payload) : m_payload (payload) {}
+
+  bool ok () const { return m_ok; }
+
+  /* Return the number of bytes of the payload not read yet.  The fields
+     appended to a record are only present if bytes remain.  */
+  size_t remaining () const { return m_payload.size () - m_pos; }
+
+  template <typename T> T get ()
+  {
+    static_assert (std::is_trivially_copyable_v<T>);
+    T value{};
+    if (!check (sizeof (value)))
+      return value;
+    std::memcpy (&value, &m_payload[m_pos], sizeof (value));
+    m_pos += sizeof (value);
+    return value;
+  }
+
+  std::string get_string ()
+  {
+    uint32_t size = get<uint32_t> ();
+    if (!check (size))
+      return {};
+    std::string value (&m_payload[m_pos], size);
+    m_pos += size;
+    return value;
+  }
+
+  std::vector<uint8_t> get_bytes ()
+  {
+    uint32_t size = get<uint32_t> ();
+    if (!check (size))
+      return {};
+    std::vector<uint8_t> value (&m_payload[m_pos], &m_payload[m_pos] + size);
+    m_pos += size;
+    return value;
+  }
+
+  /* Read a string preceded by a presence flag.  */
+  std::optional<std::string> get_optional_string ()
+  {
+    bool present = get<uint8_t> ();
+    std::string value = get_string ();
+    if (!present)
+      return std::nullopt;
+    return value;
+  }
+
+  /* Read a value preceded by a presence flag.  */
+  template <typename T> std::optional<T> get_optional ()
+  {
+    bool present = get<uint8_t> ();
+    T value = get<T> ();
+    if (!present)
+      return std::nullopt;
+    return value;
+  }
+
+  /* Read an element count, and check that the payload is large enough to
+     hold that many elements of at least MIN_SIZE bytes.  */
+  size_t get_count (size_t min_size)
+  {
+    uint32_t count = get<uint32_t> ();
+    if (!check (static_cast<size_t> (count) * min_size))
+      return 0;
+    return count;
+  }
+
+private:
+  bool check (size_t size)
+  {
+    if (m_ok && size <= (m_payload.size () - m_pos))
+      return true;
+    m_ok = false;
+    return false;
+  }
+
+  const std::vector<char> &m_payload;
+  size_t m_pos{ 0 };
+  bool m_ok{ true };
+};
+
+/* Return true if the value of REG can be printed as its type: the value is
+   not empty, and a vector type "ELEMENT_TYPE[N]" has N > 0 elements of the
+   same size.  The element types are not vectors.  */
+
+bool
+valid_register_value (const register_value_t &reg)
+{
+  if (reg.m_value.empty ())
+    return false;
+
+  const size_t pos = reg.m_type.find ('[');
+  if (pos == std::string::npos)
+    return reg.m_type.find (']') == std::string::npos;
+
+  const std::string count_string = reg.m_type.substr (pos + 1);
+  if (count_string.size () < 2 || count_string.back () != ']'
+      || count_string.find_first_not_of ("0123456789")
+             != count_string.size () - 1
+      || count_string.size () > 10 /* At most 9 digits.  */)
+    return false;
+
+  const size_t element_count = std::stoul (count_string);
+  return element_count != 0 && reg.m_value.size () % element_count == 0
+         && reg.m_value.size () >= element_count;
+}
+
+} /* namespace */
+
+std::unique_ptr<dump_writer_t>
+detail::make_binary_writer (std::ostream &out)
+{
+  return std::make_unique<binary_writer_t> (out);
+}
+
+bool
+read_binary_dump (std::istream &in, dump_writer_t &writer)
+{
+  char magic[sizeof (binary_dump_magic)];
+  uint32_t version, byte_order_mark;
+
+  if (!in.read (magic, sizeof (magic))
+      || std::memcmp (magic, binary_dump_magic, sizeof (magic)) != 0)
+    return false;
+
+  if (!in.read (reinterpret_cast<char *> (&version), sizeof (version))
+      || !in.read (reinterpret_cast<char *> (&byte_order_mark),
+                   sizeof (byte_order_mark))
+      || version == 0 || version > binary_dump_version
+      || byte_order_mark != binary_dump_byte_order_mark)
+    return false;
+
+  std::vector<char> payload;
+  while (true)
+    {
+      uint32_t type, size;
+      if (!in.read (reinterpret_cast<char *> (&type), sizeof (type)))
+        /* A clean end of file can only happen on a record boundary.  */
+        return in.eof () && !in.gcount ();
+
+      if (!in.read (reinterpret_cast<char *> (&size), sizeof (size)))
+        return false;
+
+      payload.resize (size);
+      if (!in.read (payload.data (), size))
+        return false;
+
+      payload_reader_t reader (payload);
+      switch (static_cast<record_type_t> (type))
+        {
+        case record_type_t::begin_dump:
+          writer.begin_dump ();
+          break;
+
+        case record_type_t::end_dump:
+          writer.end_dump ();
+          break;
+
+        case record_type_t::code_object:
+          {
+            code_object_info_t code_object;
+            code_object.m_load_address = reader.get<uint64_t> ();
+            code_object.m_mem_size = reader.get<uint64_t> ();
+            code_object.m_uri = reader.get_string ();
+            if (!reader.ok ())
+              return false;
+
+            writer.code_object (code_object);
+            break;
+          }
+
+        case record_type_t::wave:
+          {
+            wave_info_t wave;
+            wave.m_wave_id = reader.get<uint64_t> ();
+            wave.m_pc = reader.get<uint64_t> ();
+            wave.m_stop_reason = reader.get<uint64_t> ();
+            if (reader.get<uint8_t> ())
+              wave.m_kernel_entry.emplace (reader.get<uint64_t> ());
+            else
+              reader.get<uint64_t> ();
+            if (reader.get<uint8_t> ())
+              wave.m_kernel_name.emplace (reader.get_string ());
+            else
+              reader.get_string ();
+            if (reader.remaining ())
+              wave.m_dispatch_id = reader.get_optional<uint64_t> ();
+            if (reader.remaining ())
+              wave.m_queue_id = reader.get_optional<uint64_t> ();
+            if (!reader.ok ())
+              return false;
+
+            writer.wave (wave);
+            break;
+          }
+
+        case record_type_t::registers:
+          {
+            uint64_t wave_id = reader.get<uint64_t> ();
+            std::vector<register_class_t> classes (
+                reader.get_count (2 * sizeof (uint32_t)));
+            for (auto &&register_class : classes)
+              {
+                register_class.m_name = reader.get_string ();
+                register_class.m_registers.resize (
+                    reader.get_count (3 * sizeof (uint32_t)));
+                for (auto &&reg : register_class.m_registers)
+                  {
+                    reg.m_name = reader.get_string ();
+                    reg.m_type = reader.get_string ();
+                    reg.m_value = reader.get_bytes ();
+                    if (reader.ok () && !valid_register_value (reg))
+                      return false;
+                  }
+                if (!reader.ok ())
+                  return false;
+              }
+
+            writer.registers (wave_id, classes);
+            break;
+          }
+
+        case record_type_t::local_memory:
+          {
+            uint64_t wave_id = reader.get<uint64_t> ();
+            std::vector<uint8_t> contents = reader.get_bytes ();
+            if (!reader.ok ())
+              return false;
+
+            writer.local_memory (wave_id, contents);
+            break;
+          }
+
+        case record_type_t::disassembly:
+          {
+            uint64_t wave_id = reader.get<uint64_t> ();
+            disassembly_t disassembly;
+            if (reader.get<uint8_t> ())
+              disassembly.m_function_name.emplace (reader.get_string ());
+            else
+              reader.get_string ();
+            if (reader.get<uint8_t> ())
+              disassembly.m_function_address.emplace (
+                  reader.get<uint64_t> ());
+            else
+              reader.get<uint64_t> ();
+            disassembly.m_uri = reader.get_string ();
+            disassembly.m_load_address = reader.get<uint64_t> ();
+            disassembly.m_mem_size = reader.get<uint64_t> ();
+            disassembly.m_pc = reader.get<uint64_t> ();
+            disassembly.m_lines.resize (reader.get_count (
+                sizeof (uint8_t) + sizeof (uint64_t) + sizeof (uint32_t)));
+            for (auto &&line : disassembly.m_lines)
+              {
+                line.m_kind = static_cast<disassembly_line_t::kind_t> (
+                    reader.get<uint8_t> ());
+                line.m_value = reader.get<uint64_t> ();
+                line.m_text = reader.get_string ();
+                if (!reader.ok ())
+                  return false;
+              }
+
+            writer.disassembly (wave_id, disassembly);
+            break;
+          }
+
+        case record_type_t::hot_spots:
+          {
+            uint64_t wave_count = reader.get<uint64_t> ();
+            std::vector<hot_spot_t> hot_spots (reader.get_count (
+                3 * (sizeof (uint8_t) + sizeof (uint32_t))
+                + 2 * sizeof (uint64_t) + sizeof (uint32_t)));
+            for (auto &&hot_spot : hot_spots)
+              {
+                hot_spot.m_kernel_name = reader.get_optional_string ();
+                hot_spot.m_function_name = reader.get_optional_string ();
+                hot_spot.m_file_name = reader.get_optional_string ();
+                hot_spot.m_line = reader.get<uint64_t> ();
+                hot_spot.m_wave_count = reader.get<uint64_t> ();
+                hot_spot.m_pcs.resize (
+                    reader.get_count (2 * sizeof (uint64_t)));
+                for (auto &&pc : hot_spot.m_pcs)
+                  {
+                    pc.m_pc = reader.get<uint64_t> ();
+                    pc.m_wave_count = reader.get<uint64_t> ();
+                  }
+                if (!reader.ok ())
+                  return false;
+              }
+
+            writer.hot_spots (wave_count, hot_spots);
+            break;
+          }
+
+        case record_type_t::dispatch_history:
+          {
+            std::vector<dispatch_info_t> dispatches (reader.get_count (
+                4 * sizeof (uint64_t) + sizeof (uint8_t)
+                + 7 * sizeof (uint32_t)));
+            for (auto &&dispatch : dispatches)
+              {
+                dispatch.m_queue_id = reader.get<uint64_t> ();
+                dispatch.m_packet_id = reader.get<uint64_t> ();
+                dispatch.m_kernel_object = reader.get<uint64_t> ();
+                dispatch.m_kernel_name = reader.get_optional_string ();
+                for (uint32_t &size : dispatch.m_grid_size)
+                  size = reader.get<uint32_t> ();
+                for (uint32_t &size : dispatch.m_workgroup_size)
+                  size = reader.get<uint32_t> ();
+                dispatch.m_age = reader.get<uint64_t> ();
+                if (!reader.ok ())
+                  return false;
+              }
+
+            writer.dispatch_history (dispatches);
+            break;
+          }
+
+        default:
+          /* Skip unknown records.  */
+          break;
+        }
+    }
+}
+
+} /* namespace amd::debug_agent */
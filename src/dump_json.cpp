@@ -0,0 +1,710 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "dump.h"
+#include "debug.h"
+#include "logging.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+/* The JSON dump format.
+
+   Each record is a single line holding a self-contained JSON object, so that
+   a consumer can process a dump while it is still being written.  Every
+   object has a "type" ("dump_begin", "code_object", "wave", "registers",
+   "local_memory", "disassembly" or "dump_end"), the "pid" of the process,
+   and the sequence number of the "dump" it belongs to.  Registers and local
+   memory are folded into the wave object when they immediately follow it.
+   Each record is flushed as soon as it is complete, so that a consumer
+   tailing the output sees every record of a long dump as it is written.
+   Addresses are hexadecimal strings, register and memory contents are
+   hexadecimal strings in the same byte order as the text format.  */
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+/* A streaming JSON emitter.  Values are escaped and converted directly into
+   a fixed size buffer which is written to the output stream when full, or
+   when flushed, so emitting a record does not allocate.  */
+
+class json_stream_t
+{
+public:
+  json_stream_t (std::ostream &out) : m_out (out) {}
+  ~json_stream_t () { flush (); }
+
+  void begin_object () { open ('{'); }
+  void end_object () { close ('}'); }
+  void begin_array () { open ('['); }
+  void end_array () { close (']'); }
+
+  void key (std::string_view name)
+  {
+    separator ();
+    string (name);
+    put (':');
+    m_after_key = true;
+  }
+
+  void value (std::string_view value)
+  {
+    separator ();
+    string (value);
+  }
+
+  /* Without this overload, string literals would be converted to bool.  */
+  void value (const char *value) { this->value (std::string_view (value)); }
+
+  void value (uint64_t value)
+  {
+    separator ();
+    char buffer[20];
+    auto [end, ec] = std::to_chars (std::begin (buffer), std::end (buffer),
+                                    value);
+    put (buffer, end - buffer);
+  }
+
+  void value (bool value)
+  {
+    separator ();
+    if (value)
+      put ("true", 4);
+    else
+      put ("false", 5);
+  }
+
+  void null ()
+  {
+    separator ();
+    put ("null", 4);
+  }
+
+  /* Emit VALUE as a "0x" prefixed hexadecimal string.  */
+  void address (uint64_t value)
+  {
+    separator ();
+    char buffer[16];
+    auto [end, ec] = std::to_chars (std::begin (buffer), std::end (buffer),
+                                    value, 16);
+    put ("\"0x", 3);
+    put (buffer, end - buffer);
+    put ('"');
+  }
+
+  /* Emit SIZE bytes at DATA as a hexadecimal string, most significant byte
+     first if REVERSE is true.  */
+  void hex_bytes (const uint8_t *data, size_t size, bool reverse)
+  {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+
+    separator ();
+    put ('"');
+    for (size_t i = 0; i < size; ++i)
+      {
+        uint8_t byte = data[reverse ? size - 1 - i : i];
+        put (hex_digits[byte >> 4]);
+        put (hex_digits[byte & 0xF]);
+      }
+    put ('"');
+  }
+
+  /* Terminate the current record.  */
+  void end_record ()
+  {
+    agent_assert (m_depth == 0);
+    put ('\n');
+  }
+
+  void flush ()
+  {
+    if (m_size)
+      m_out.write (m_buffer, m_size);
+    m_out.flush ();
+    m_bytes_flushed += m_size;
+    m_size = 0;
+  }
+
+  uint64_t bytes_written () const { return m_bytes_flushed + m_size; }
+
+  /* The number of objects and arrays that are open.  */
+  size_t depth () const { return m_depth; }
+
+private:
+  void put (char c)
+  {
+    if (m_size == sizeof (m_buffer))
+      drain ();
+    m_buffer[m_size++] = c;
+  }
+
+  void put (const char *data, size_t size)
+  {
+    if ((m_size + size) > sizeof (m_buffer))
+      drain ();
+    if (size > sizeof (m_buffer))
+      {
+        m_out.write (data, size);
+        m_bytes_flushed += size;
+        return;
+      }
+    std::memcpy (&m_buffer[m_size], data, size);
+    m_size += size;
+  }
+
+  void drain ()
+  {
+    m_out.write (m_buffer, m_size);
+    m_bytes_flushed += m_size;
+    m_size = 0;
+  }
+
+  void string (std::string_view value)
+  {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+
+    put ('"');
+    for (char c : value)
+      switch (c)
+        {
+        case '"':
+          put ("\\\"", 2);
+          break;
+        case '\\':
+          put ("\\\\", 2);
+          break;
+        case '\n':
+          put ("\\n", 2);
+          break;
+        case '\r':
+          put ("\\r", 2);
+          break;
+        case '\t':
+          put ("\\t", 2);
+          break;
+        default:
+          if (static_cast<unsigned char> (c) < 0x20)
+            {
+              char escape[] = { '\\', 'u', '0', '0', hex_digits[c >> 4],
+                                hex_digits[c & 0xF] };
+              put (escape, sizeof (escape));
+            }
+          else
+            put (c);
+        }
+    put ('"');
+  }
+
+  void separator ()
+  {
+    if (m_after_key)
+      m_after_key = false;
+    else if (m_depth && !m_first[m_depth - 1])
+      put (',');
+
+    if (m_depth)
+      m_first[m_depth - 1] = false;
+  }
+
+  void open (char c)
+  {
+    separator ();
+    agent_assert (m_depth < max_depth);
+    m_first[m_depth++] = true;
+    put (c);
+  }
+
+  void close (char c)
+  {
+    agent_assert (m_depth > 0);
+    --m_depth;
+    put (c);
+  }
+
+  static constexpr size_t max_depth = 8;
+
+  std::ostream &m_out;
+  char m_buffer[64 * 1024];
+  size_t m_size{ 0 };
+  uint64_t m_bytes_flushed{ 0 };
+
+  bool m_first[max_depth];
+  size_t m_depth{ 0 };
+  bool m_after_key{ false };
+};
+
+class json_writer_t : public dump_writer_t
+{
+public:
+  json_writer_t (std::ostream &out) : m_json (out), m_pid (getpid ()) {}
+
+  void begin_dump () override;
+  void end_dump () override;
+
+  void code_object (const code_object_info_t &code_object) override;
+  void wave (const wave_info_t &wave) override;
+  void registers (uint64_t wave_id,
+                  const std::vector<register_class_t> &classes) override;
+  void local_memory (uint64_t wave_id,
+                     const std::vector<uint8_t> &contents) override;
+  void disassembly (uint64_t wave_id,
+                    const disassembly_t &disassembly) override;
+  void end_wave (uint64_t wave_id) override;
+  void hot_spots (uint64_t wave_count,
+                  const std::vector<hot_spot_t> &hot_spots) override;
+  void
+  dispatch_history (const std::vector<dispatch_info_t> &dispatches) override;
+
+  void flush () override;
+
+  uint64_t bytes_written () const override { return m_json.bytes_written (); }
+
+private:
+  /* Start a new record of type TYPE, closing the current wave object if one
+     is still open.  */
+  void begin_record (std::string_view type);
+  void end_record ();
+  void close_wave ();
+
+  /* Continue the open wave object for WAVE_ID if there is one, or start a new
+     record of type TYPE for that wave.  */
+  void wave_record (uint64_t wave_id, std::string_view type);
+
+  json_stream_t m_json;
+  uint64_t m_pid;
+  uint64_t m_dump{ 0 };
+  std::optional<uint64_t> m_open_wave;
+};
+
+void
+json_writer_t::begin_record (std::string_view type)
+{
+  close_wave ();
+
+  m_json.begin_object ();
+  m_json.key ("type");
+  m_json.value (type);
+  m_json.key ("pid");
+  m_json.value (m_pid);
+  m_json.key ("dump");
+  m_json.value (m_dump);
+}
+
+void
+json_writer_t::end_record ()
+{
+  m_json.end_object ();
+  m_json.end_record ();
+  m_json.flush ();
+}
+
+void
+json_writer_t::flush ()
+{
+  /* The wave object is kept open for the details that follow it.  Any other
+     record that is still open is incomplete.  */
+  if (m_open_wave && m_json.depth () == 1)
+    close_wave ();
+
+  if (m_json.depth () == 0)
+    m_json.flush ();
+}
+
+void
+json_writer_t::close_wave ()
+{
+  if (!m_open_wave)
+    return;
+
+  m_open_wave.reset ();
+  end_record ();
+}
+
+void
+json_writer_t::wave_record (uint64_t wave_id, std::string_view type)
+{
+  if (m_open_wave == wave_id)
+    return;
+
+  begin_record (type);
+  m_json.key ("wave");
+  m_json.value (wave_id);
+  m_open_wave.emplace (wave_id);
+}
+
+void
+json_writer_t::end_wave (uint64_t wave_id)
+{
+  if (m_open_wave == wave_id)
+    close_wave ();
+}
+
+void
+json_writer_t::begin_dump ()
+{
+  ++m_dump;
+
+  timespec now;
+  clock_gettime (CLOCK_REALTIME, &now);
+
+  begin_record ("dump_begin");
+  m_json.key ("time");
+  m_json.value (static_cast<uint64_t> (now.tv_sec) * 1000000000
+                + now.tv_nsec);
+  end_record ();
+}
+
+void
+json_writer_t::end_dump ()
+{
+  begin_record ("dump_end");
+  end_record ();
+}
+
+void
+json_writer_t::code_object (const code_object_info_t &code_object)
+{
+  begin_record ("code_object");
+  m_json.key ("uri");
+  m_json.value (code_object.m_uri);
+  m_json.key ("load_address");
+  m_json.address (code_object.m_load_address);
+  m_json.key ("mem_size");
+  m_json.value (code_object.m_mem_size);
+  end_record ();
+}
+
+void
+json_writer_t::wave (const wave_info_t &wave)
+{
+  close_wave ();
+  wave_record (wave.m_wave_id, "wave");
+
+  m_json.key ("pc");
+  m_json.address (wave.m_pc);
+
+  m_json.key ("kernel_code_entry");
+  if (wave.m_kernel_entry)
+    m_json.address (*wave.m_kernel_entry);
+  else
+    m_json.null ();
+
+  m_json.key ("kernel_name");
+  if (wave.m_kernel_name)
+    m_json.value (*wave.m_kernel_name);
+  else
+    m_json.null ();
+
+  m_json.key ("dispatch");
+  if (wave.m_dispatch_id)
+    m_json.value (*wave.m_dispatch_id);
+  else
+    m_json.null ();
+
+  m_json.key ("queue");
+  if (wave.m_queue_id)
+    m_json.value (*wave.m_queue_id);
+  else
+    m_json.null ();
+
+  m_json.key ("stopped");
+  m_json.value (wave.m_stop_reason != 0);
+
+  m_json.key ("stop_reason");
+  m_json.begin_array ();
+  for (auto bits = wave.m_stop_reason; bits != 0; bits &= bits - 1)
+    m_json.value (stop_reason_name (bits & -bits));
+  m_json.end_array ();
+}
+
+void
+json_writer_t::registers (uint64_t wave_id,
+                          const std::vector<register_class_t> &classes)
+{
+  wave_record (wave_id, "registers");
+
+  m_json.key ("registers");
+  m_json.begin_object ();
+  for (auto &&register_class : classes)
+    {
+      m_json.key (register_class.m_name);
+      m_json.begin_object ();
+      for (auto &&reg : register_class.m_registers)
+        {
+          const uint8_t *data = reg.m_value.data ();
+          const size_t size = reg.m_value.size ();
+
+          m_json.key (reg.m_name);
+
+          /* Vector registers are emitted as an array of elements.  */
+          size_t element_count = 0;
+          if (size_t pos = reg.m_type.find_last_of ('[');
+              pos != std::string::npos)
+            element_count = std::strtoul (&reg.m_type[pos + 1], nullptr, 10);
+
+          if (element_count && !(size % element_count))
+            {
+              const size_t element_size = size / element_count;
+
+              m_json.begin_array ();
+              for (size_t i = 0; i < element_count; ++i)
+                m_json.hex_bytes (&data[i * element_size], element_size,
+                                  true);
+              m_json.end_array ();
+            }
+          else
+            m_json.hex_bytes (data, size, true);
+        }
+      m_json.end_object ();
+    }
+  m_json.end_object ();
+}
+
+void
+json_writer_t::local_memory (uint64_t wave_id,
+                             const std::vector<uint8_t> &contents)
+{
+  if (contents.empty ())
+    return;
+
+  wave_record (wave_id, "local_memory");
+
+  m_json.key ("local_memory");
+  m_json.begin_object ();
+  m_json.key ("size");
+  m_json.value (static_cast<uint64_t> (contents.size ()));
+  m_json.key ("contents");
+  m_json.hex_bytes (contents.data (), contents.size (), false);
+  m_json.end_object ();
+}
+
+void
+json_writer_t::disassembly (uint64_t wave_id, const disassembly_t &disassembly)
+{
+  begin_record ("disassembly");
+  m_json.key ("wave");
+  m_json.value (wave_id);
+
+  m_json.key ("function");
+  if (disassembly.m_function_name)
+    m_json.value (*disassembly.m_function_name);
+  else
+    m_json.null ();
+
+  m_json.key ("function_address");
+  if (disassembly.m_function_address)
+    m_json.address (*disassembly.m_function_address);
+  else
+    m_json.null ();
+
+  m_json.key ("code_object");
+  m_json.value (disassembly.m_uri);
+  m_json.key ("load_address");
+  m_json.address (disassembly.m_load_address);
+  m_json.key ("mem_size");
+  m_json.value (disassembly.m_mem_size);
+  m_json.key ("pc");
+  m_json.address (disassembly.m_pc);
+
+  m_json.key ("lines");
+  m_json.begin_array ();
+
+  std::string_view file_name;
+  for (auto &&line : disassembly.m_lines)
+    switch (line.m_kind)
+      {
+      case disassembly_line_t::kind_t::blank:
+        break;
+
+      case disassembly_line_t::kind_t::file:
+        file_name = line.m_text;
+        break;
+
+      case disassembly_line_t::kind_t::source:
+        m_json.begin_object ();
+        m_json.key ("kind");
+        m_json.value ("source");
+        m_json.key ("file");
+        m_json.value (file_name);
+        m_json.key ("line");
+        m_json.value (line.m_value);
+        m_json.key ("text");
+        m_json.value (line.m_text);
+        m_json.end_object ();
+        break;
+
+      case disassembly_line_t::kind_t::ellipsis:
+        m_json.begin_object ();
+        m_json.key ("kind");
+        m_json.value ("ellipsis");
+        m_json.end_object ();
+        break;
+
+      case disassembly_line_t::kind_t::instruction:
+        m_json.begin_object ();
+        m_json.key ("kind");
+        m_json.value ("instruction");
+        m_json.key ("address");
+        m_json.address (line.m_value);
+        m_json.key ("text");
+        m_json.value (line.m_text);
+        if (line.m_value == disassembly.m_pc)
+          {
+            m_json.key ("pc");
+            m_json.value (true);
+          }
+        m_json.end_object ();
+        break;
+
+      case disassembly_line_t::kind_t::memory_error:
+        m_json.begin_object ();
+        m_json.key ("kind");
+        m_json.value ("memory_error");
+        m_json.key ("address");
+        m_json.address (line.m_value);
+        m_json.end_object ();
+        break;
+      }
+
+  m_json.end_array ();
+  end_record ();
+}
+
+void
+json_writer_t::hot_spots (uint64_t wave_count,
+                          const std::vector<hot_spot_t> &hot_spots)
+{
+  auto optional_string = [this] (const std::optional<std::string> &value) {
+    if (value)
+      m_json.value (*value);
+    else
+      m_json.null ();
+  };
+
+  begin_record ("hot_spots");
+  m_json.key ("waves");
+  m_json.value (wave_count);
+
+  m_json.key ("hot_spots");
+  m_json.begin_array ();
+  for (auto &&hot_spot : hot_spots)
+    {
+      m_json.begin_object ();
+      m_json.key ("waves");
+      m_json.value (hot_spot.m_wave_count);
+      m_json.key ("kernel_name");
+      optional_string (hot_spot.m_kernel_name);
+      m_json.key ("function");
+      optional_string (hot_spot.m_function_name);
+      m_json.key ("file");
+      optional_string (hot_spot.m_file_name);
+      m_json.key ("line");
+      if (hot_spot.m_file_name)
+        m_json.value (hot_spot.m_line);
+      else
+        m_json.null ();
+
+      m_json.key ("pcs");
+      m_json.begin_array ();
+      for (auto &&pc : hot_spot.m_pcs)
+        {
+          m_json.begin_object ();
+          m_json.key ("pc");
+          m_json.address (pc.m_pc);
+          m_json.key ("waves");
+          m_json.value (pc.m_wave_count);
+          m_json.end_object ();
+        }
+      m_json.end_array ();
+      m_json.end_object ();
+    }
+  m_json.end_array ();
+  end_record ();
+}
+
+void
+json_writer_t::dispatch_history (
+    const std::vector<dispatch_info_t> &dispatches)
+{
+  begin_record ("dispatch_history");
+  m_json.key ("dispatches");
+  m_json.begin_array ();
+  for (auto &&dispatch : dispatches)
+    {
+      m_json.begin_object ();
+      m_json.key ("queue");
+      m_json.value (dispatch.m_queue_id);
+      m_json.key ("packet");
+      m_json.value (dispatch.m_packet_id);
+      m_json.key ("kernel_object");
+      m_json.address (dispatch.m_kernel_object);
+      m_json.key ("kernel_name");
+      if (dispatch.m_kernel_name)
+        m_json.value (*dispatch.m_kernel_name);
+      else
+        m_json.null ();
+
+      m_json.key ("grid_size");
+      m_json.begin_array ();
+      for (uint32_t size : dispatch.m_grid_size)
+        m_json.value (uint64_t{ size });
+      m_json.end_array ();
+
+      m_json.key ("workgroup_size");
+      m_json.begin_array ();
+      for (uint32_t size : dispatch.m_workgroup_size)
+        m_json.value (uint64_t{ size });
+      m_json.end_array ();
+
+      m_json.key ("age_ns");
+      m_json.value (dispatch.m_age);
+      m_json.end_object ();
+    }
+  m_json.end_array ();
+  end_record ();
+}
+
+} /* namespace */
+
+std::unique_ptr<dump_writer_t>
+detail::make_json_writer (std::ostream &out)
+{
+  return std::make_unique<json_writer_t> (out);
+}
+
+} /* namespace amd::debug_agent */
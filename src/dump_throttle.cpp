@@ -0,0 +1,115 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "dump_throttle.h"
+
+#include <functional>
+
+namespace amd::debug_agent
+{
+
+size_t
+dump_throttle_t::signature_hash_t::operator() (
+    const signature_t &signature) const
+{
+  size_t hash = std::hash<uint64_t>{}(signature.m_kernel_entry);
+  hash = hash * 31 + std::hash<uint64_t>{}(signature.m_pc);
+  hash = hash * 31 + std::hash<uint64_t>{}(signature.m_stop_reason);
+  return hash;
+}
+
+bool
+dump_throttle_t::record (const std::vector<signature_t> &signatures,
+                         std::chrono::steady_clock::time_point now)
+{
+  /* Count each wave, but only count the stop cycle once per signature.  */
+  std::unordered_map<signature_t, size_t, signature_hash_t> wave_counts;
+  for (auto &&signature : signatures)
+    ++wave_counts[signature];
+
+  bool dump = !m_max_dumps;
+  for (auto &&[signature, wave_count] : wave_counts)
+    {
+      counters_t &counters = m_counters[signature];
+      counters.m_stop_count += 1;
+      counters.m_wave_count += wave_count;
+
+      if (m_max_dumps && counters.m_dump_count < *m_max_dumps)
+        dump = true;
+    }
+
+  if (dump)
+    {
+      for (auto &&[signature, wave_count] : wave_counts)
+        m_counters[signature].m_dump_count += 1;
+      return true;
+    }
+
+  if (!m_suppressed_dumps)
+    m_period_start = now;
+
+  m_suppressed_dumps += 1;
+  for (auto &&[signature, wave_count] : wave_counts)
+    {
+      m_suppressed_waves += wave_count;
+      m_suppressed_signatures.emplace (signature);
+    }
+
+  return false;
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+dump_throttle_t::next_summary () const
+{
+  if (!m_suppressed_dumps)
+    return std::nullopt;
+
+  return m_period_start + m_summary_interval;
+}
+
+std::optional<dump_throttle_t::summary_t>
+dump_throttle_t::take_summary (std::chrono::steady_clock::time_point now,
+                               bool force)
+{
+  auto next = next_summary ();
+  if (!next || (!force && now < *next))
+    return std::nullopt;
+
+  summary_t summary{ m_suppressed_dumps, m_suppressed_waves,
+                     m_suppressed_signatures.size (), now - m_period_start };
+
+  m_suppressed_dumps = 0;
+  m_suppressed_waves = 0;
+  m_suppressed_signatures.clear ();
+
+  return summary;
+}
+
+} /* namespace amd::debug_agent */
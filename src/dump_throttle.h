@@ -0,0 +1,141 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_DUMP_THROTTLE_H
+#define _ROCM_DEBUG_AGENT_DUMP_THROTTLE_H 1
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* Limit the number of dumps printed for the same exception.  An exception
+   is identified by its signature, the kernel, pc and stop reason of the wave
+   that raised it.  The first occurrences of a signature are dumped, the next
+   ones are only counted, and the suppressed dumps are summarized
+   periodically.  */
+
+class dump_throttle_t
+{
+public:
+  struct signature_t
+  {
+    /* The kernel code entry address of the wave's dispatch, or 0 if it is
+       not known.  */
+    uint64_t m_kernel_entry;
+    uint64_t m_pc;
+    /* A mask of amd_dbgapi_wave_stop_reasons_t bits.  */
+    uint64_t m_stop_reason;
+
+    bool operator== (const signature_t &other) const
+    {
+      return m_kernel_entry == other.m_kernel_entry && m_pc == other.m_pc
+             && m_stop_reason == other.m_stop_reason;
+    }
+  };
+
+  struct signature_hash_t
+  {
+    size_t operator() (const signature_t &signature) const;
+  };
+
+  struct counters_t
+  {
+    /* The number of stop cycles that reported this signature.  */
+    size_t m_stop_count{ 0 };
+    /* The number of these stop cycles that were dumped.  */
+    size_t m_dump_count{ 0 };
+    size_t m_wave_count{ 0 };
+  };
+
+  /* The dumps suppressed since the previous summary.  */
+  struct summary_t
+  {
+    size_t m_dump_count;
+    size_t m_wave_count;
+    size_t m_signature_count;
+    std::chrono::steady_clock::duration m_period;
+  };
+
+  /* Dump each signature at most COUNT times.  */
+  void set_max_dumps (size_t count) { m_max_dumps.emplace (count); }
+
+  /* Summarize the suppressed dumps at most once every INTERVAL.  */
+  void set_summary_interval (std::chrono::milliseconds interval)
+  {
+    m_summary_interval = interval;
+  }
+
+  bool enabled () const { return m_max_dumps.has_value (); }
+
+  /* Count a stop cycle where waves raised the exceptions in SIGNATURES, one
+     element per wave.  Return true if the stop cycle should be dumped, that
+     is if one of its signatures was not dumped the maximum number of times
+     yet.  */
+  bool record (const std::vector<signature_t> &signatures,
+               std::chrono::steady_clock::time_point now);
+
+  /* The time when the suppressed dumps should be summarized, or an empty
+     optional if no dump was suppressed since the previous summary.  */
+  std::optional<std::chrono::steady_clock::time_point> next_summary () const;
+
+  /* Return the summary of the dumps suppressed since the previous summary if
+     it is due at NOW, or if FORCE is true.  */
+  std::optional<summary_t>
+  take_summary (std::chrono::steady_clock::time_point now, bool force = false);
+
+  const std::unordered_map<signature_t, counters_t, signature_hash_t> &
+  counters () const
+  {
+    return m_counters;
+  }
+
+private:
+  std::optional<size_t> m_max_dumps;
+  std::chrono::milliseconds m_summary_interval{ std::chrono::seconds (60) };
+
+  std::unordered_map<signature_t, counters_t, signature_hash_t> m_counters;
+
+  /* The dumps suppressed since the previous summary.  */
+  std::chrono::steady_clock::time_point m_period_start;
+  size_t m_suppressed_dumps{ 0 };
+  size_t m_suppressed_waves{ 0 };
+  std::unordered_set<signature_t, signature_hash_t> m_suppressed_signatures;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_DUMP_THROTTLE_H */
@@ -0,0 +1,77 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "hang_detector.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace amd::debug_agent
+{
+
+hang_detector_t::slot_t *
+hang_detector_t::acquire_slot ()
+{
+  slot_t *slot = m_slots.acquire ([] { return new slot_t; });
+
+  slot->m_signal.store (0, std::memory_order_relaxed);
+  slot->m_wait_start.store (0, std::memory_order_relaxed);
+  slot->m_timeout_end = 0;
+  slot->m_thread_id.store (syscall (SYS_gettid), std::memory_order_relaxed);
+  return slot;
+}
+
+std::vector<hang_detector_t::hang_t>
+hang_detector_t::check ()
+{
+  const uint64_t now = now_ns ();
+  std::vector<hang_t> hangs;
+
+  for (slot_t *slot = m_slots.first (); slot; slot = slot->m_next)
+    {
+      /* The thread of a released slot exited, maybe while it waited.  */
+      if (!slot->m_owned.load (std::memory_order_acquire))
+        continue;
+
+      uint64_t start = slot->m_wait_start.load (std::memory_order_acquire);
+      if (!start || start == slot->m_reported_start || start > now
+          || now - start < static_cast<uint64_t> (m_threshold.count ()))
+        continue;
+
+      slot->m_reported_start = start;
+      hangs.push_back ({ slot->m_thread_id.load (std::memory_order_relaxed),
+                         slot->m_signal.load (std::memory_order_relaxed),
+                         std::chrono::nanoseconds (now - start) });
+    }
+
+  return hangs;
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,168 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_HANG_DETECTOR_H
+#define _ROCM_DEBUG_AGENT_HANG_DETECTOR_H 1
+
+#include "thread_slots.h"
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* Detect the host threads waiting on an HSA signal for longer than a
+   threshold, which usually means that a kernel is hung.  The signal wait
+   functions record the start of each wait in a slot owned by the waiting
+   thread, without taking any lock, and a watchdog checks the slots
+   periodically.
+
+   A wait that times out before the signal satisfies its condition is
+   continued by the next wait of the same thread on the same signal, so
+   that a thread polling a signal with a short timeout is seen as waiting
+   since its first poll.  The next wait only continues it if it starts
+   within the duration of the wait that timed out: a thread that does other
+   work between its polls (a hostcall thread, for example) starts a new
+   wait with each poll, and is not seen as waiting between them.  */
+
+class hang_detector_t
+{
+public:
+  struct hang_t
+  {
+    pid_t m_thread_id;
+    uint64_t m_signal;
+    std::chrono::nanoseconds m_duration;
+  };
+
+  explicit hang_detector_t (std::chrono::nanoseconds threshold)
+      : m_threshold (threshold)
+  {
+  }
+
+  hang_detector_t (const hang_detector_t &) = delete;
+  hang_detector_t &operator= (const hang_detector_t &) = delete;
+
+  std::chrono::nanoseconds threshold () const { return m_threshold; }
+
+  /* Record the start of a wait on SIGNAL by the calling thread.  */
+  void begin_wait (uint64_t signal)
+  {
+    slot_t *slot = thread_slot ();
+    const uint64_t now = now_ns ();
+
+    uint64_t start = now;
+    if (slot->m_timeout_end
+        && slot->m_signal.load (std::memory_order_relaxed) == signal
+        && now - slot->m_timeout_end <= slot->m_timeout_duration)
+      start = slot->m_first_start;
+
+    slot->m_timeout_end = 0;
+    slot->m_poll_start = now;
+    slot->m_first_start = start;
+    slot->m_signal.store (signal, std::memory_order_relaxed);
+    slot->m_wait_start.store (start, std::memory_order_release);
+  }
+
+  /* Record the end of the calling thread's wait.  SATISFIED is false if the
+     wait timed out before the signal satisfied its condition, the next wait
+     may then continue it.  */
+  void end_wait (bool satisfied)
+  {
+    slot_t *slot = thread_slot ();
+    slot->m_wait_start.store (0, std::memory_order_relaxed);
+
+    if (!satisfied)
+      {
+        slot->m_timeout_end = now_ns ();
+        slot->m_timeout_duration = slot->m_timeout_end - slot->m_poll_start;
+      }
+  }
+
+  /* Return the waits that have lasted longer than the threshold, and were
+     not returned by a previous call.  Must only be called by one thread.  */
+  std::vector<hang_t> check ();
+
+private:
+  struct slot_t
+  {
+    /* The steady_clock time the current wait started, in nanoseconds, or 0
+       if the thread is not waiting.  A continued wait keeps the start of the
+       wait that timed out.  */
+    std::atomic<uint64_t> m_wait_start{ 0 };
+    std::atomic<uint64_t> m_signal{ 0 };
+    std::atomic<pid_t> m_thread_id{ 0 };
+
+    /* Only used by the owner thread: the start of its current wait and of
+       its last poll, and when its last wait timed out and how long it
+       lasted, or 0 if it did not time out.  */
+    uint64_t m_first_start{ 0 };
+    uint64_t m_poll_start{ 0 };
+    uint64_t m_timeout_end{ 0 };
+    uint64_t m_timeout_duration{ 0 };
+
+    /* The start of the last wait returned by check.  */
+    uint64_t m_reported_start{ 0 };
+
+    std::atomic<bool> m_owned{ true };
+    slot_t *m_next{ nullptr };
+  };
+
+  slot_t *thread_slot ()
+  {
+    if (slot_t *slot = m_slots.thread_slot ())
+      return slot;
+    return acquire_slot ();
+  }
+
+  slot_t *acquire_slot ();
+
+  static uint64_t now_ns ()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+               std::chrono::steady_clock::now ().time_since_epoch ())
+        .count ();
+  }
+
+  const std::chrono::nanoseconds m_threshold;
+
+  /* The slots of all the threads that waited on a signal.  The slot of a
+     thread that exited is reused by the next thread that needs one.  */
+  thread_slots_t<slot_t> m_slots;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_HANG_DETECTOR_H */
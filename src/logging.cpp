@@ -30,70 +30,854 @@
 
 #include "logging.h"
 
-#include <amd-dbgapi/amd-dbgapi.h>
 #include <cstdio>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdarg.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <streambuf>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace amd::debug_agent
 {
 
 log_level_t log_level = log_level_t::warning;
 
-std::ofstream agent_out;
+/* The buffer behind agent_out.  There is no put area, so that every insertion
+   goes through xsputn or overflow which append to the pending output while
+   holding m_mutex.  The pending output is swapped with m_writing before it is
+   written, so that other threads can continue to append to the stream during
+   the write.  m_write_mutex serializes the writes to keep the output in
+   order.  */
+
+class output_stream_t::buffer_t : public std::streambuf
+{
+public:
+  /* The pending output is written when it reaches this size, or half of it
+     if a writer thread is running.  */
+  static constexpr size_t capacity = 1024 * 1024;
+
+  buffer_t ();
+  ~buffer_t ();
+
+  bool open (const std::string &path);
+
+  void start_writer_thread (std::chrono::milliseconds interval);
+  void stop_writer_thread ();
+
+  bool asynchronous () const { return m_asynchronous.load (); }
+
+protected:
+  std::streamsize xsputn (const char *data, std::streamsize size) override;
+  int_type overflow (int_type c) override;
+  int sync () override;
+
+private:
+  /* Append SIZE bytes at DATA to the pending output, and write it if it is
+     large enough.  */
+  void append (const char *data, size_t size);
+
+  /* Write the pending output.  LOCK must hold m_mutex, it is released while
+     the output is written.  */
+  void drain (std::unique_lock<std::mutex> &lock);
+
+  void writer_thread (std::chrono::milliseconds interval);
+
+  int m_fd{ STDERR_FILENO };
+  bool m_owns_fd{ false };
+
+  std::mutex m_mutex;
+  std::vector<char> m_pending;
+
+  std::mutex m_write_mutex;
+  std::vector<char> m_writing;
+
+  std::thread m_writer_thread;
+  std::condition_variable m_writer_cv;
+  bool m_stop_writer{ false };
+  std::atomic<bool> m_asynchronous{ false };
+};
+
+output_stream_t::buffer_t::buffer_t ()
+{
+  m_pending.reserve (capacity);
+  m_writing.reserve (capacity);
+}
+
+output_stream_t::buffer_t::~buffer_t ()
+{
+  stop_writer_thread ();
+  sync ();
+
+  if (m_owns_fd)
+    ::close (m_fd);
+}
+
+bool
+output_stream_t::buffer_t::open (const std::string &path)
+{
+  int fd = ::open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0666);
+  if (fd == -1)
+    return false;
+
+  sync ();
+
+  if (m_owns_fd)
+    ::close (m_fd);
+
+  m_fd = fd;
+  m_owns_fd = true;
+  return true;
+}
+
+void
+output_stream_t::buffer_t::append (const char *data, size_t size)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_pending.insert (m_pending.end (), data, data + size);
+
+  if (!asynchronous ())
+    {
+      if (m_pending.size () >= capacity)
+        drain (lock);
+    }
+  /* Only write synchronously if the writer thread is falling behind.  */
+  else if (m_pending.size () >= 4 * capacity)
+    drain (lock);
+  else if (m_pending.size () >= capacity / 2)
+    m_writer_cv.notify_one ();
+}
+
+void
+output_stream_t::buffer_t::drain (std::unique_lock<std::mutex> &lock)
+{
+  std::unique_lock<std::mutex> write_lock (m_write_mutex);
+
+  m_pending.swap (m_writing);
+  lock.unlock ();
+
+  const char *data = m_writing.data ();
+  size_t size = m_writing.size ();
+  while (size)
+    {
+      ssize_t written = ::write (m_fd, data, size);
+      if (written == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          /* There is nowhere left to report the error, drop the output.  */
+          break;
+        }
+      data += written;
+      size -= written;
+    }
+
+  m_writing.clear ();
+  write_lock.unlock ();
+
+  lock.lock ();
+}
+
+std::streamsize
+output_stream_t::buffer_t::xsputn (const char *data, std::streamsize size)
+{
+  append (data, size);
+  return size;
+}
+
+output_stream_t::buffer_t::int_type
+output_stream_t::buffer_t::overflow (int_type c)
+{
+  if (traits_type::eq_int_type (c, traits_type::eof ()))
+    return traits_type::not_eof (c);
+
+  char ch = traits_type::to_char_type (c);
+  append (&ch, 1);
+  return c;
+}
+
+int
+output_stream_t::buffer_t::sync ()
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  if (!m_pending.empty ())
+    drain (lock);
+  return 0;
+}
+
+void
+output_stream_t::buffer_t::writer_thread (std::chrono::milliseconds interval)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (!m_stop_writer)
+    {
+      m_writer_cv.wait_for (lock, interval, [this] () {
+        return m_stop_writer || m_pending.size () >= capacity / 2;
+      });
+
+      if (!m_pending.empty ())
+        drain (lock);
+    }
+}
+
+void
+output_stream_t::buffer_t::start_writer_thread (
+    std::chrono::milliseconds interval)
+{
+  if (asynchronous ())
+    return;
+
+  m_stop_writer = false;
+  m_asynchronous.store (true);
+  m_writer_thread
+      = std::thread ([this, interval] () { writer_thread (interval); });
+  pthread_setname_np (m_writer_thread.native_handle (), "RocrDbgAgentOut");
+}
+
+void
+output_stream_t::buffer_t::stop_writer_thread ()
+{
+  if (!asynchronous ())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop_writer = true;
+  }
+  m_writer_cv.notify_one ();
+  m_writer_thread.join ();
+  m_asynchronous.store (false);
+}
+
+output_stream_t::output_stream_t ()
+    : std::ostream (nullptr), m_buffer (std::make_unique<buffer_t> ())
+{
+  rdbuf (m_buffer.get ());
+}
+
+output_stream_t::~output_stream_t ()
+{
+  m_buffer->stop_writer_thread ();
+  flush ();
+}
+
+bool
+output_stream_t::open (const std::string &path)
+{
+  return m_buffer->open (path);
+}
+
+void
+output_stream_t::start_writer_thread (std::chrono::milliseconds interval)
+{
+  m_buffer->start_writer_thread (interval);
+}
+
+void
+output_stream_t::stop_writer_thread ()
+{
+  m_buffer->stop_writer_thread ();
+}
+
+bool
+output_stream_t::asynchronous () const
+{
+  return m_buffer->asynchronous ();
+}
+
+output_stream_t agent_out;
 
 namespace detail
 {
 
+log_level_t record_level = log_level;
+
+namespace
+{
+
 void
-log (log_level_t level, const char *format, ...)
+append_prefix (std::string &out, log_source_t source, log_level_t level)
 {
-  va_list va;
+  if (source == log_source_t::dbgapi)
+    {
+      out += "rocm-dbgapi: ";
+      return;
+    }
 
-  agent_out << "rocm-debug-agent: ";
+  out += "rocm-debug-agent: ";
 
   if (level == log_level_t::error)
-    agent_out << "error: ";
+    out += "error: ";
   else if (level == log_level_t::warning)
-    agent_out << "warning: ";
+    out += "warning: ";
+}
+
+void
+append_record (std::string &out, const log_record_t &record)
+{
+  append_prefix (out, record.m_source, record.m_level);
+  record.m_formatter (record, out);
+  out += '\n';
+}
+
+void
+write_message (const std::string &message)
+{
+  agent_out << message;
+
+  /* Without a writer thread, the message would otherwise only be written
+     with the next dump.  */
+  if (!agent_out.asynchronous ())
+    agent_out.flush ();
+}
+
+/* The records of the messages that were not written, in a ring buffer
+   whose oldest records are overwritten.  The records are copied, they are
+   only formatted when the flight recorder is written.  */
+
+class flight_recorder_t
+{
+public:
+  explicit flight_recorder_t (size_t capacity) : m_data (capacity) {}
+
+  /* Add a copy of RECORD, or drop it if it is too large.  */
+  void add (const log_record_t &record);
+
+  /* Format the records, oldest first, append them to OUT, and remove
+     them.  */
+  void format (std::string &out);
+
+private:
+  /* Remove the oldest record.  */
+  void remove_oldest ();
+
+  std::vector<char> m_data;
+  size_t m_head{ 0 };
+  size_t m_tail{ 0 };
+  size_t m_count{ 0 };
+  size_t m_overwritten{ 0 };
+};
+
+void
+flight_recorder_t::remove_oldest ()
+{
+  uint32_t marker[2];
+  memcpy (marker, &m_data[m_tail % m_data.size ()], sizeof (marker));
+  m_tail += marker[0];
+
+  if (!marker[1])
+    {
+      --m_count;
+      ++m_overwritten;
+    }
+}
+
+void
+flight_recorder_t::add (const log_record_t &record)
+{
+  const size_t capacity = m_data.size ();
+  if (record.m_size > capacity / 2)
+    {
+      ++m_overwritten;
+      return;
+    }
+
+  size_t offset = m_head % capacity;
+  size_t padding = offset + record.m_size > capacity ? capacity - offset : 0;
+
+  while (m_head + padding + record.m_size - m_tail > capacity)
+    remove_oldest ();
+
+  if (padding)
+    {
+      const uint32_t marker[2] = { static_cast<uint32_t> (padding), 1 };
+      memcpy (&m_data[offset], marker, sizeof (marker));
+      m_head += padding;
+    }
+
+  memcpy (&m_data[m_head % capacity], &record, record.m_size);
+  m_head += record.m_size;
+  ++m_count;
+}
+
+void
+flight_recorder_t::format (std::string &out)
+{
+  if (!m_count)
+    return;
+
+  append_prefix (out, log_source_t::agent, log_level_t::info);
+  out += "flight recorder: " + std::to_string (m_count)
+         + (m_count == 1 ? " message" : " messages");
+  if (m_overwritten)
+    out += " (" + std::to_string (m_overwritten)
+           + " older messages were overwritten)";
+  out += ":\n";
+
+  while (m_tail != m_head)
+    {
+      const char *data = &m_data[m_tail % m_data.size ()];
+
+      uint32_t marker[2];
+      memcpy (marker, data, sizeof (marker));
+      if (!marker[1])
+        append_record (out, *reinterpret_cast<const log_record_t *> (data));
+
+      m_tail += marker[0];
+    }
+
+  append_prefix (out, log_source_t::agent, log_level_t::info);
+  out += "end of flight recorder\n";
+
+  m_count = 0;
+  m_overwritten = 0;
+}
+
+} /* namespace */
+
+/* The ring buffers of the threads that logged a message, and the log
+   thread.  The ring buffer of a thread that exits is reused by the next
+   thread that logs a message.  */
+
+class log_rings_t
+{
+public:
+  log_ring_t &claim ();
+  void release (log_ring_t &ring);
+
+  /* Format and write the records of all the ring buffers.  */
+  void flush ();
+
+  /* Write RECORD, after the records of the ring buffers.  */
+  void write (const log_record_t &record);
+
+  void start_thread (std::chrono::milliseconds interval);
+  void stop_thread ();
+
+  void enable_flight_recorder (size_t size);
+  bool flight_recorder_enabled ();
+  std::string flight_recorder_messages ();
+
+private:
+  /* Format the records in order, append the ones to write to OUT, and move
+     the others to the flight recorder.  M_MUTEX must be held.  */
+  void format (std::string &out);
+
+  /* Write RECORD to OUT if it is not above the log level, else add it to
+     the flight recorder.  M_MUTEX must be held.  */
+  void process (std::string &out, const log_record_t &record);
+
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<log_ring_t>> m_rings;
+  std::optional<flight_recorder_t> m_flight_recorder;
+
+  std::thread m_thread;
+  std::condition_variable m_thread_cv;
+  bool m_stop_thread{ false };
+};
+
+/* Never destroyed, the threads may log messages until the process
+   exits.  */
+log_rings_t &
+log_rings ()
+{
+  static log_rings_t *rings = new log_rings_t;
+  return *rings;
+}
+
+log_ring_t &
+log_rings_t::claim ()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+
+  auto it = std::find_if (m_rings.begin (), m_rings.end (),
+                          [] (auto &&ring) { return !ring->m_owned; });
+  if (it == m_rings.end ())
+    it = m_rings.emplace (m_rings.end (), std::make_unique<log_ring_t> ());
+
+  (*it)->m_owned = true;
+  return **it;
+}
+
+void
+log_rings_t::release (log_ring_t &ring)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  ring.m_owned = false;
+}
+
+void
+log_rings_t::process (std::string &out, const log_record_t &record)
+{
+  if (record.m_level <= log_level)
+    append_record (out, record);
+  else if (m_flight_recorder)
+    m_flight_recorder->add (record);
+}
+
+void
+log_rings_t::format (std::string &out)
+{
+  struct cursor_t
+  {
+    log_ring_t *m_ring;
+    size_t m_tail;
+    size_t m_head;
+
+    /* Return the next record, skipping the padding, or nullptr.  */
+    const log_record_t *next ()
+    {
+      while (m_tail != m_head)
+        {
+          const char *data = &m_ring->m_data[m_tail % log_ring_t::capacity];
+
+          uint32_t marker[2];
+          memcpy (marker, data, sizeof (marker));
+          if (!marker[1])
+            return reinterpret_cast<const log_record_t *> (data);
+
+          m_tail += marker[0];
+        }
+      return nullptr;
+    }
+  };
+
+  std::vector<cursor_t> cursors;
+  for (auto &&ring : m_rings)
+    {
+      size_t tail = ring->m_tail.load (std::memory_order_relaxed);
+      size_t head = ring->m_head.load (std::memory_order_acquire);
+      if (tail != head)
+        cursors.emplace_back (cursor_t{ ring.get (), tail, head });
+    }
+
+  /* Merge the records of the threads in the order they were logged.  */
+  while (true)
+    {
+      cursor_t *first = nullptr;
+      const log_record_t *first_record = nullptr;
+
+      for (auto &&cursor : cursors)
+        if (const log_record_t *record = cursor.next ();
+            record != nullptr
+            && (first_record == nullptr
+                || record->m_sequence < first_record->m_sequence))
+          {
+            first = &cursor;
+            first_record = record;
+          }
+
+      if (first == nullptr)
+        break;
+
+      process (out, *first_record);
+      first->m_tail += first_record->m_size;
+    }
+
+  for (auto &&cursor : cursors)
+    cursor.m_ring->m_tail.store (cursor.m_tail, std::memory_order_release);
+}
+
+void
+log_rings_t::flush ()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+
+  /* Write while holding the mutex, so that the batches are written in the
+     order they were formatted.  */
+  std::string out;
+  format (out);
+  if (!out.empty ())
+    write_message (out);
+}
+
+void
+log_rings_t::write (const log_record_t &record)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+
+  std::string out;
+  format (out);
+  process (out, record);
+  if (!out.empty ())
+    write_message (out);
+}
+
+void
+log_rings_t::start_thread (std::chrono::milliseconds interval)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  if (m_thread.joinable ())
+    return;
+
+  m_stop_thread = false;
+  m_thread = std::thread ([this, interval] () {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    while (!m_stop_thread)
+      {
+        m_thread_cv.wait_for (lock, interval);
+
+        std::string out;
+        format (out);
+        if (!out.empty ())
+          write_message (out);
+      }
+  });
+  pthread_setname_np (m_thread.native_handle (), "RocrDbgAgentLog");
+}
+
+void
+log_rings_t::stop_thread ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    if (!m_thread.joinable ())
+      return;
+    m_stop_thread = true;
+  }
+  m_thread_cv.notify_one ();
+  m_thread.join ();
+
+  flush ();
+}
+
+void
+log_rings_t::enable_flight_recorder (size_t size)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_flight_recorder.emplace (size);
+}
+
+bool
+log_rings_t::flight_recorder_enabled ()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_flight_recorder.has_value ();
+}
+
+std::string
+log_rings_t::flight_recorder_messages ()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+
+  std::string out;
+  format (out);
+  if (!out.empty ())
+    write_message (out);
+
+  std::string messages;
+  if (m_flight_recorder)
+    m_flight_recorder->format (messages);
+  return messages;
+}
+
+log_ring_t &
+log_ring_t::current ()
+{
+  struct owner_t
+  {
+    log_ring_t &m_ring{ log_rings ().claim () };
+    ~owner_t () { log_rings ().release (m_ring); }
+  };
+
+  thread_local owner_t owner;
+  return owner.m_ring;
+}
+
+void
+append_formatted (std::string &out, const char *format, ...)
+{
+  va_list va;
+
+  va_start (va, format);
+  int size = vsnprintf (nullptr, 0, format, va);
+  va_end (va);
+
+  if (size <= 0)
+    return;
+
+  size_t start = out.size ();
+  out.resize (start + size + 1);
+
+  va_start (va, format);
+  vsnprintf (&out[start], size + 1, format, va);
+  va_end (va);
+
+  out.resize (start + size);
+}
+
+void
+write_log_record (const log_record_t &record)
+{
+  log_rings ().write (record);
+}
+
+void
+flush_log_records ()
+{
+  log_rings ().flush ();
+}
+
+void
+log (log_level_t level, const char *format, ...)
+{
+  va_list va;
+
+  /* The context of an error.  */
+  if (level == log_level_t::error)
+    write_flight_recorder ();
+
+  /* Keep the messages in order.  */
+  flush_log_records ();
+
+  std::string message;
+  append_prefix (message, log_source_t::agent, level);
 
   va_start (va, format);
   size_t size = vsnprintf (NULL, 0, format, va);
   va_end (va);
 
+  size_t start = message.size ();
+  message.resize (start + size + 1);
+
   va_start (va, format);
-  std::string str (size, '\0');
-  vsprintf (&str[0], format, va);
+  vsnprintf (&message[start], size + 1, format, va);
   va_end (va);
 
-  agent_out << str << std::endl;
+  message.back () = '\n';
+  write_message (message);
 }
 
 } /* namespace detail */
 
 void
-set_log_level (log_level_t level)
+start_log_thread (std::chrono::milliseconds interval)
 {
-  log_level = level;
-  switch (level)
+  detail::log_rings ().start_thread (interval);
+}
+
+void
+stop_log_thread ()
+{
+  detail::log_rings ().stop_thread ();
+}
+
+void
+flush_log ()
+{
+  detail::flush_log_records ();
+}
+
+void
+log_dbgapi_message (log_level_t level, const char *message)
+{
+  if (level > detail::record_level)
+    return;
+
+  if (level <= log_level && level <= log_level_t::warning)
     {
-    case log_level_t::none:
-      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_NONE);
-      break;
-    case log_level_t::verbose:
-      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_VERBOSE);
-      break;
-    case log_level_t::info:
-      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_INFO);
-      break;
-    case log_level_t::warning:
-      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_WARNING);
-      break;
-    case log_level_t::error:
-      amd_dbgapi_set_log_level (AMD_DBGAPI_LOG_LEVEL_FATAL_ERROR);
-      break;
+      /* The context of an error, as for the agent's errors.  */
+      if (level == log_level_t::error)
+        write_flight_recorder ();
+
+      detail::flush_log_records ();
+      detail::write_message (std::string ("rocm-dbgapi: ") + message + '\n');
     }
+  else
+    detail::record_message (detail::log_source_t::dbgapi, level, "%s",
+                            message);
+}
+
+namespace
+{
+
+/* Update the record level after a change of the log level or of the flight
+   recorder.  */
+
+void
+update_log_levels ()
+{
+  detail::record_level = detail::log_rings ().flight_recorder_enabled ()
+                             ? log_level_t::verbose
+                             : log_level;
+}
+
+} /* namespace */
+
+void
+enable_flight_recorder (size_t size)
+{
+  detail::log_rings ().enable_flight_recorder (size);
+  update_log_levels ();
+}
+
+bool
+flight_recorder_enabled ()
+{
+  return detail::log_rings ().flight_recorder_enabled ();
+}
+
+std::string
+flight_recorder_messages ()
+{
+  return detail::log_rings ().flight_recorder_messages ();
+}
+
+void
+write_flight_recorder ()
+{
+  std::string messages = flight_recorder_messages ();
+  if (!messages.empty ())
+    detail::write_message (messages);
+}
+
+void
+set_log_level (log_level_t level)
+{
+  log_level = level;
+  update_log_levels ();
+}
+
+log_level_t
+dbgapi_log_level ()
+{
+  /* The flight recorder records all the agent's messages, but only dbgapi's
+     info messages, its verbose messages trace every dbgapi call and are
+     formatted by dbgapi.  */
+  if (flight_recorder_enabled () && log_level < log_level_t::info)
+    return log_level_t::info;
+  return log_level;
+}
+
+namespace
+{
+std::atomic<void (*) ()> abort_hook{ nullptr };
+} /* namespace */
+
+void
+set_abort_hook (void (*hook) ())
+{
+  abort_hook.store (hook, std::memory_order_release);
+}
+
+void
+run_abort_hook ()
+{
+  static std::atomic_flag running = ATOMIC_FLAG_INIT;
+
+  if (auto *hook = abort_hook.load (std::memory_order_acquire);
+      hook && !running.test_and_set ())
+    hook ();
 }
 
 } /* namespace amd::debug_agent */
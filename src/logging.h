@@ -31,7 +31,17 @@
 #ifndef _ROCM_DEBUG_AGENT_LOGGING_H
 #define _ROCM_DEBUG_AGENT_LOGGING_H 1
 
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
 
 namespace amd::debug_agent
 {
@@ -52,31 +62,368 @@ enum class log_level_t
 
 extern log_level_t log_level;
 
-extern std::ofstream agent_out;
+/* The stream the debug agent's messages and text dumps are written to.
+
+   The output is accumulated in a large buffer which is written to the file
+   descriptor when it is full, when the stream is flushed, or periodically by
+   a writer thread if one was started, so that a dump only costs a few large
+   writes.  The stream can be written to from multiple threads.  By default,
+   the output goes to stderr.  */
+class output_stream_t : public std::ostream
+{
+public:
+  output_stream_t ();
+  ~output_stream_t ();
+
+  /* Send the output to the file at PATH instead of stderr.  Return false if
+     the file could not be created.  */
+  bool open (const std::string &path);
+
+  /* Start a thread that writes the buffered output when at least half of the
+     buffer is used, or at least every INTERVAL.  Once the writer thread is
+     running, the output is only written synchronously when the stream is
+     explicitly flushed, or if the buffer overflows.  */
+  void start_writer_thread (std::chrono::milliseconds interval);
+  void stop_writer_thread ();
+
+  /* Return true if a writer thread is running.  */
+  bool asynchronous () const;
+
+private:
+  class buffer_t;
+  std::unique_ptr<buffer_t> m_buffer;
+};
+
+extern output_stream_t agent_out;
+
+/* Reset the formatting state of a stream (flags, fill and precision) to its
+   defaults, and restore it when destroyed.  The streams live for the whole
+   process, so a manipulator such as std::setfill would otherwise affect
+   everything printed after it.  */
+class scoped_format_t
+{
+public:
+  explicit scoped_format_t (std::ostream &out)
+      : m_out (out), m_flags (out.flags ()), m_fill (out.fill ()),
+        m_precision (out.precision ())
+  {
+    out.flags (std::ios_base::dec | std::ios_base::skipws);
+    out.fill (' ');
+    out.precision (6);
+  }
+
+  ~scoped_format_t ()
+  {
+    m_out.flags (m_flags);
+    m_out.fill (m_fill);
+    m_out.precision (m_precision);
+  }
+
+  scoped_format_t (const scoped_format_t &) = delete;
+  scoped_format_t &operator= (const scoped_format_t &) = delete;
+
+private:
+  std::ostream &m_out;
+  const std::ios_base::fmtflags m_flags;
+  const char m_fill;
+  const std::streamsize m_precision;
+};
 
 namespace detail
 {
 
-/* A macro instead of a variadic template so that the __VAR_ARGS__ are not
-   evaluated unless the log level indicated they are needed.  */
+/* Format and write a message.  The messages recorded by other threads are
+   written first.  */
 extern void log (log_level_t level, const char *format, ...)
 #if defined(__GNUC__)
     __attribute__ ((format (printf, 2, 3)))
 #endif /* defined (__GNUC__) */
     ;
 
+/* The level of the messages that are written or recorded in the flight
+   recorder.  */
+extern log_level_t record_level;
+
+/* Info and verbose messages are not formatted by the thread that logs them.
+   The format, which must be a string literal, and the arguments are copied
+   into a record in a ring buffer owned by the thread, and the records of
+   all the threads are formatted in order and written by the log thread (see
+   start_log_thread), or before the next warning or error, which are
+   written synchronously.  Recording a message costs a few tens of
+   nanoseconds.  The records of the messages above log_level are only kept
+   in the flight recorder.  */
+
+enum class log_source_t : uint8_t
+{
+  agent,
+  dbgapi
+};
+
+struct log_record_t
+{
+  /* The size of the record, including the arguments that follow it.  */
+  uint32_t m_size;
+  /* Not zero if the record only pads the end of the ring buffer, in which
+     case only m_size and m_padding are valid.  */
+  uint32_t m_padding;
+  log_level_t m_level;
+  log_source_t m_source;
+  uint64_t m_sequence;
+  const char *m_format;
+  /* Append the formatted message to OUT.  */
+  void (*m_formatter) (const log_record_t &record, std::string &out);
+};
+
+/* The order of the records of all the threads.  */
+inline std::atomic<uint64_t> log_sequence{ 0 };
+
+/* How a message argument is stored in a record.  */
+template <typename T> struct log_argument_t
+{
+  static_assert (std::is_arithmetic_v<T> || std::is_enum_v<T>
+                     || std::is_pointer_v<T>,
+                 "log message arguments must be scalars");
+
+  static size_t size (T) { return sizeof (T); }
+
+  static char *store (char *data, T value)
+  {
+    memcpy (data, &value, sizeof (T));
+    return data + sizeof (T);
+  }
+
+  static T load (const char *&data)
+  {
+    T value;
+    memcpy (&value, data, sizeof (T));
+    data += sizeof (T);
+    return value;
+  }
+};
+
+/* Strings are copied, they may not outlive the call (strerror,
+   std::string::c_str).  */
+template <> struct log_argument_t<const char *>
+{
+  static const char *string (const char *value)
+  {
+    return value != nullptr ? value : "(null)";
+  }
+
+  static size_t size (const char *value)
+  {
+    return strlen (string (value)) + 1;
+  }
+
+  static char *store (char *data, const char *value)
+  {
+    size_t size = strlen (string (value)) + 1;
+    memcpy (data, string (value), size);
+    return data + size;
+  }
+
+  static const char *load (const char *&data)
+  {
+    const char *value = data;
+    data += strlen (data) + 1;
+    return value;
+  }
+};
+
+template <> struct log_argument_t<char *> : log_argument_t<const char *>
+{
+};
+
+/* Append the message formatted with FORMAT to OUT.  */
+extern void append_formatted (std::string &out, const char *format, ...);
+
+template <typename... Args>
+void
+format_log_record (const log_record_t &record, std::string &out)
+{
+  const char *data = reinterpret_cast<const char *> (&record + 1);
+  /* A braced initializer loads the arguments in order.  */
+  std::tuple<decltype (log_argument_t<Args>::load (data))...> arguments{
+    log_argument_t<Args>::load (data)...
+  };
+  std::apply ([&] (auto... values)
+                { append_formatted (out, record.m_format, values...); },
+              arguments);
+}
+
+/* The ring buffer of records of a thread.  Only the owner thread adds
+   records, and only one thread at a time (holding the log mutex) removes
+   them.  */
+class log_ring_t
+{
+public:
+  static constexpr size_t capacity = 128 * 1024;
+
+  /* Return the ring buffer of the calling thread.  */
+  static log_ring_t &current ();
+
+  /* Return space for a record of SIZE bytes, a multiple of 8, at POSITION,
+     or nullptr if the ring buffer is full.  */
+  char *reserve (size_t size, size_t &position)
+  {
+    size_t head = m_head.load (std::memory_order_relaxed);
+    size_t offset = head % capacity;
+    size_t padding = offset + size > capacity ? capacity - offset : 0;
+
+    if (head + padding + size - m_tail.load (std::memory_order_acquire)
+        > capacity)
+      return nullptr;
+
+    if (padding)
+      {
+        const uint32_t marker[2] = { static_cast<uint32_t> (padding), 1 };
+        memcpy (&m_data[offset], marker, sizeof (marker));
+        head += padding;
+      }
+
+    position = head;
+    return &m_data[head % capacity];
+  }
+
+  /* Make the record of SIZE bytes at POSITION visible to the log thread.  */
+  void commit (size_t position, size_t size)
+  {
+    m_head.store (position + size, std::memory_order_release);
+  }
+
+private:
+  friend class log_rings_t;
+
+  alignas (64) std::atomic<size_t> m_head{ 0 };
+  alignas (64) std::atomic<size_t> m_tail{ 0 };
+  /* True while a thread owns the ring buffer, protected by the log
+     mutex.  */
+  bool m_owned{ false };
+  alignas (64) char m_data[capacity];
+};
+
+/* Write RECORD now.  */
+extern void write_log_record (const log_record_t &record);
+
+/* Format and write the records of all the threads.  */
+extern void flush_log_records ();
+
+template <typename... Args>
+void
+record_message (log_source_t source, log_level_t level, const char *format,
+                Args... args)
+{
+  const size_t size
+      = ((sizeof (log_record_t) + ... + log_argument_t<Args>::size (args))
+         + 7)
+        & ~size_t{ 7 };
+
+  auto fill = [&] (char *data) -> log_record_t & {
+    auto *record = new (data) log_record_t{
+      static_cast<uint32_t> (size),
+      0,
+      level,
+      source,
+      log_sequence.fetch_add (1, std::memory_order_relaxed),
+      format,
+      &format_log_record<Args...>
+    };
+    data += sizeof (log_record_t);
+    ((data = log_argument_t<Args>::store (data, args)), ...);
+    return *record;
+  };
+
+  log_ring_t &ring = log_ring_t::current ();
+  size_t position;
+
+  char *data = ring.reserve (size, position);
+  if (data == nullptr && size <= log_ring_t::capacity / 4)
+    {
+      /* The log thread is falling behind, do its work.  */
+      flush_log_records ();
+      data = ring.reserve (size, position);
+    }
+
+  if (data == nullptr)
+    {
+      auto buffer = std::make_unique<uint64_t[]> (size / sizeof (uint64_t));
+      write_log_record (fill (reinterpret_cast<char *> (buffer.get ())));
+      return;
+    }
+
+  fill (data);
+  ring.commit (position, size);
+}
+
+template <typename... Args>
+void
+log_record (log_level_t level, const char *format, Args... args)
+{
+  record_message (log_source_t::agent, level, format, args...);
+}
+
 } /* namespace detail */
 
+/* A macro instead of a variadic template so that the __VAR_ARGS__ are not
+   evaluated unless the log level indicated they are needed.  Both branches
+   are compiled, so the arguments are always checked against the format.  */
 #define agent_log(level, format, ...)                                         \
   do                                                                          \
     {                                                                         \
-      if (level <= amd::debug_agent::log_level)                               \
-        amd::debug_agent::detail::log (level, format, ##__VA_ARGS__);         \
+      if (level <= amd::debug_agent::detail::record_level)                    \
+        {                                                                     \
+          if (level <= amd::debug_agent::log_level                            \
+              && level <= amd::debug_agent::log_level_t::warning)             \
+            amd::debug_agent::detail::log (level, format, ##__VA_ARGS__);     \
+          else                                                                \
+            amd::debug_agent::detail::log_record (level, format,              \
+                                                  ##__VA_ARGS__);             \
+        }                                                                     \
     }                                                                         \
   while (0)
 
+/* Start a thread that formats and writes the info and verbose messages
+   every INTERVAL.  */
+void start_log_thread (std::chrono::milliseconds interval);
+void stop_log_thread ();
+
+/* Write the info and verbose messages recorded so far.  */
+void flush_log ();
+
+/* Log MESSAGE, received from dbgapi.  */
+void log_dbgapi_message (log_level_t level, const char *message);
+
+/* Keep the messages that are not written because of the log level in a
+   ring buffer of SIZE bytes, overwriting the oldest ones, so that the
+   context of a failure can be written when it happens.  The recorded
+   messages are written by the dumps, agent_error and the errors reported
+   by dbgapi.  Recording a message in the flight recorder does not format
+   it.  */
+void enable_flight_recorder (size_t size);
+bool flight_recorder_enabled ();
+
+/* Return the messages in the flight recorder, oldest first, and remove
+   them.  */
+std::string flight_recorder_messages ();
+
+/* Write the messages in the flight recorder to agent_out, and remove
+   them.  */
+void write_flight_recorder ();
+
 void set_log_level (log_level_t level);
 
+/* Return the level of the messages dbgapi should report, which depends on
+   the log level and on the flight recorder.  */
+log_level_t dbgapi_log_level ();
+
+/* Set the function agent_error calls before the process is aborted, to
+   write the output that is buffered outside of agent_out.  */
+void set_abort_hook (void (*hook) ());
+
+/* Call the abort hook, if one is set.  It is only called once, even if it
+   fails and calls agent_error.  */
+void run_abort_hook ();
+
 } /* namespace amd::debug_agent */
 
 #endif /* _ROCM_DEBUG_AGENT_LOGGING_H */
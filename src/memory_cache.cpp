@@ -0,0 +1,222 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "memory_cache.h"
+#include "stats.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+constexpr uint64_t
+page_address (uint64_t address)
+{
+  return address & ~static_cast<uint64_t> (memory_cache_t::page_size - 1);
+}
+
+} /* namespace */
+
+memory_cache_t::memory_cache_t (int mem_fd)
+    : m_mem_fd (mem_fd), m_pid (getpid ())
+{
+}
+
+ssize_t
+memory_cache_t::read_direct (uint64_t address, void *buffer, size_t size)
+{
+  size_t done = 0;
+
+  if (m_use_process_vm_readv)
+    {
+      iovec local{ buffer, size };
+      iovec remote{ reinterpret_cast<void *> (address), size };
+
+      ssize_t nbytes = process_vm_readv (m_pid, &local, 1, &remote, 1, 0);
+      stats::add (stats::counter_t::memory_syscalls);
+
+      if (nbytes == -1 && (errno == ENOSYS || errno == EPERM))
+        m_use_process_vm_readv = false;
+      else if (nbytes > 0)
+        done = nbytes;
+
+      if (done == size)
+        return done;
+    }
+
+  /* Read the rest from /proc/self/mem, which can also access the memory
+     process_vm_readv cannot.  */
+  ssize_t nbytes = pread (m_mem_fd, static_cast<uint8_t *> (buffer) + done,
+                          size - done, address + done);
+  stats::add (stats::counter_t::memory_syscalls);
+
+  if (nbytes == -1)
+    return done ? static_cast<ssize_t> (done) : -1;
+
+  return done + nbytes;
+}
+
+void
+memory_cache_t::fill (const std::vector<uint64_t> &addresses)
+{
+  std::vector<page_t *> pages;
+  pages.reserve (addresses.size ());
+  for (auto &&address : addresses)
+    {
+      auto page = std::make_unique<page_t> ();
+      pages.emplace_back (page.get ());
+      m_pages.emplace (address, std::move (page));
+    }
+
+  std::vector<iovec> local (addresses.size ());
+  for (size_t i = 0; i < addresses.size (); ++i)
+    local[i] = { pages[i]->m_data.data (), page_size };
+
+  size_t done = 0;
+
+  if (m_use_process_vm_readv)
+    {
+      std::vector<iovec> remote (addresses.size ());
+      for (size_t i = 0; i < addresses.size (); ++i)
+        remote[i] = { reinterpret_cast<void *> (addresses[i]), page_size };
+
+      /* The transfer stops at the first page that cannot be read.  */
+      ssize_t nbytes = process_vm_readv (m_pid, local.data (), local.size (),
+                                         remote.data (), remote.size (), 0);
+      stats::add (stats::counter_t::memory_syscalls);
+
+      if (nbytes == -1 && (errno == ENOSYS || errno == EPERM))
+        m_use_process_vm_readv = false;
+      else if (nbytes > 0)
+        done = nbytes / page_size;
+    }
+
+  for (size_t i = 0; i < done; ++i)
+    pages[i]->m_readable = true;
+
+  /* Read the other pages from /proc/self/mem, one run of contiguous pages
+     at a time.  */
+  for (size_t i = done; i < addresses.size ();)
+    {
+      size_t count = 1;
+      while (i + count < addresses.size ()
+             && addresses[i + count] == addresses[i] + count * page_size)
+        ++count;
+
+      ssize_t nbytes = preadv (m_mem_fd, &local[i], count, addresses[i]);
+      stats::add (stats::counter_t::memory_syscalls);
+
+      size_t readable = nbytes > 0 ? nbytes / page_size : 0;
+      for (size_t j = 0; j < readable; ++j)
+        pages[i + j]->m_readable = true;
+
+      /* Skip the page that could not be read, and retry after it.  */
+      i += std::min (readable + 1, count);
+    }
+}
+
+ssize_t
+memory_cache_t::read (uint64_t address, void *buffer, size_t size)
+{
+  stats::add (stats::counter_t::memory_reads);
+
+  if (!m_enabled || size == 0 || size > max_cached_read)
+    return read_direct (address, buffer, size);
+
+  const uint64_t first = page_address (address);
+  const uint64_t last = page_address (address + size - 1);
+
+  if (m_pages.size () + (last - first) / page_size + 1 > max_cached_pages)
+    m_pages.clear ();
+
+  std::vector<uint64_t> missing;
+  for (uint64_t page = first; page <= last; page += page_size)
+    if (m_pages.find (page) == m_pages.end ())
+      missing.emplace_back (page);
+
+  if (missing.empty ())
+    stats::add (stats::counter_t::memory_cached_reads);
+  else
+    fill (missing);
+
+  auto *out = static_cast<uint8_t *> (buffer);
+  size_t copied = 0;
+  while (copied < size)
+    {
+      const uint64_t current = address + copied;
+      const page_t &page = *m_pages.at (page_address (current));
+      if (!page.m_readable)
+        break;
+
+      const size_t offset = current - page_address (current);
+      const size_t length = std::min (size - copied, page_size - offset);
+      memcpy (out + copied, page.m_data.data () + offset, length);
+      copied += length;
+    }
+
+  if (!copied)
+    {
+      errno = EIO;
+      return -1;
+    }
+
+  return copied;
+}
+
+ssize_t
+memory_cache_t::write (uint64_t address, const void *buffer, size_t size)
+{
+  ssize_t nbytes = pwrite (m_mem_fd, buffer, size, address);
+  stats::add (stats::counter_t::memory_syscalls);
+
+  if (m_pages.empty () || size == 0)
+    return nbytes;
+
+  const uint64_t first = page_address (address);
+  const uint64_t last = page_address (address + size - 1);
+
+  if ((last - first) / page_size >= m_pages.size ())
+    m_pages.clear ();
+  else
+    for (uint64_t page = first; page <= last; page += page_size)
+      m_pages.erase (page);
+
+  return nbytes;
+}
+
+} /* namespace amd::debug_agent */
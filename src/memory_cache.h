@@ -0,0 +1,127 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_MEMORY_CACHE_H
+#define _ROCM_DEBUG_AGENT_MEMORY_CACHE_H 1
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* Access the global memory of the process for dbgapi.
+
+   Memory is read with process_vm_readv, and with pread from /proc/self/mem
+   for the memory process_vm_readv cannot access (device memory mapped with
+   VM_IO or VM_PFNMAP, or pages without read permission).
+
+   While enabled, reads go through a cache of whole pages, so that the many
+   small reads dbgapi does while the waves are stopped (queue and dispatch
+   packets, wave save areas, instructions) cost one syscall per page instead
+   of one per read.  The cache must only be enabled once the waves are
+   reported stopped, since dbgapi updates the queues and the save areas
+   until then.  The host threads are still running, so the cached memory is
+   a snapshot taken during the stop, and it is dropped when the waves are
+   resumed.  Writes go directly to memory, and drop the cached pages they
+   overlap.
+
+   It is not thread-safe, it is only used by the thread that calls
+   dbgapi.  */
+
+class memory_cache_t
+{
+public:
+  static constexpr size_t page_size = 4096;
+  /* Reads larger than this (code objects read from memory) are not cached,
+     they are read directly into the caller's buffer.  */
+  static constexpr size_t max_cached_read = 16 * page_size;
+  /* The cache is dropped when it would exceed this number of pages.  */
+  static constexpr size_t max_cached_pages = 4096;
+
+  /* MEM_FD is /proc/self/mem opened for reading and writing.  */
+  explicit memory_cache_t (int mem_fd);
+
+  memory_cache_t (const memory_cache_t &) = delete;
+  memory_cache_t &operator= (const memory_cache_t &) = delete;
+
+  /* Start caching reads.  */
+  void enable () { m_enabled = true; }
+
+  /* Stop caching reads, and drop the cache.  */
+  void disable ()
+  {
+    m_enabled = false;
+    m_pages.clear ();
+  }
+
+  bool enabled () const { return m_enabled; }
+
+  /* Read up to SIZE bytes at ADDRESS into BUFFER.  Return the number of
+     bytes read, which is less than SIZE if the memory after them is not
+     readable, or -1 with errno set if no byte could be read.  */
+  ssize_t read (uint64_t address, void *buffer, size_t size);
+
+  /* Write up to SIZE bytes from BUFFER at ADDRESS.  Return the number of
+     bytes written, or -1 with errno set.  */
+  ssize_t write (uint64_t address, const void *buffer, size_t size);
+
+private:
+  struct page_t
+  {
+    bool m_readable{ false };
+    std::array<uint8_t, page_size> m_data;
+  };
+
+  /* Read without the cache.  */
+  ssize_t read_direct (uint64_t address, void *buffer, size_t size);
+
+  /* Read the pages at ADDRESSES, sorted in increasing order, and add them to
+     the cache.  The pages that cannot be read are cached as unreadable.  */
+  void fill (const std::vector<uint64_t> &addresses);
+
+  int m_mem_fd;
+  pid_t m_pid;
+  /* False if process_vm_readv is not allowed (seccomp) or not
+     implemented.  */
+  bool m_use_process_vm_readv{ true };
+  bool m_enabled{ false };
+  std::unordered_map<uint64_t, std::unique_ptr<page_t>> m_pages;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_MEMORY_CACHE_H */
@@ -0,0 +1,389 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "profile.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+/* A protocol buffer message, encoded as it is built.  */
+class message_t
+{
+public:
+  void add_varint (uint32_t field, uint64_t value)
+  {
+    append_varint (field << 3 | 0);
+    append_varint (value);
+  }
+
+  void add_bytes (uint32_t field, const std::string &value)
+  {
+    append_varint (field << 3 | 2);
+    append_varint (value.size ());
+    m_data.append (value);
+  }
+
+  void add_message (uint32_t field, const message_t &message)
+  {
+    add_bytes (field, message.m_data);
+  }
+
+  void add_packed (uint32_t field, const std::vector<uint64_t> &values)
+  {
+    message_t packed;
+    for (uint64_t value : values)
+      packed.append_varint (value);
+    add_bytes (field, packed.m_data);
+  }
+
+  const std::string &data () const { return m_data; }
+
+private:
+  void append_varint (uint64_t value)
+  {
+    do
+      {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        m_data.push_back (static_cast<char> (value ? byte | 0x80 : byte));
+      }
+    while (value);
+  }
+
+  std::string m_data;
+};
+
+std::string
+hex_address (uint64_t address)
+{
+  std::ostringstream out;
+  out << "0x" << std::hex << address;
+  return out.str ();
+}
+
+/* Return the frames of a sample, outermost first: the kernel, the function
+   if it is not the kernel itself, and the source line or the pc.  */
+std::vector<std::string>
+sample_frames (uint64_t kernel_entry, uint64_t pc,
+               const profile_t::location_t &location)
+{
+  std::vector<std::string> frames;
+
+  if (location.m_kernel_name)
+    frames.emplace_back (*location.m_kernel_name);
+  else
+    frames.emplace_back (kernel_entry ? "[kernel " + hex_address (kernel_entry)
+                                            + "]"
+                                      : "[unknown kernel]");
+
+  if (location.m_function_name
+      && location.m_function_name != location.m_kernel_name)
+    frames.emplace_back (*location.m_function_name);
+
+  if (location.m_file_name)
+    frames.emplace_back (*location.m_file_name + ":"
+                         + std::to_string (location.m_line));
+  else
+    frames.emplace_back (hex_address (pc));
+
+  return frames;
+}
+
+} /* namespace */
+
+profile_t::profile_t (std::chrono::nanoseconds period)
+    : m_period (period), m_start_time (std::chrono::system_clock::now ()),
+      m_start (std::chrono::steady_clock::now ())
+{
+}
+
+void
+profile_t::add_tick (std::chrono::nanoseconds pause)
+{
+  ++m_tick_count;
+  m_total_pause += pause;
+  m_max_pause = std::max (m_max_pause, pause);
+}
+
+std::vector<profile_t::symbolized_sample_t>
+profile_t::symbolize (const symbolizer_t &symbolizer) const
+{
+  std::vector<symbolized_sample_t> samples;
+  samples.reserve (m_counts.size ());
+
+  for (auto &&[key, count] : m_counts)
+    {
+      auto [kernel_entry, pc] = key;
+      samples.push_back (
+          { kernel_entry, pc, count, symbolizer (kernel_entry, pc) });
+    }
+
+  return samples;
+}
+
+void
+profile_t::write_folded (std::ostream &out,
+                         const symbolizer_t &symbolizer) const
+{
+  /* Samples at different pcs of the same source line are merged.  */
+  std::map<std::string, uint64_t> stacks;
+
+  for (auto &&sample : symbolize (symbolizer))
+    {
+      std::string stack;
+      for (auto &&frame :
+           sample_frames (sample.m_kernel_entry, sample.m_pc,
+                          sample.m_location))
+        stack += (stack.empty () ? "" : ";") + frame;
+
+      stacks[stack] += sample.m_count;
+    }
+
+  for (auto &&[stack, count] : stacks)
+    out << stack << ' ' << count << '\n';
+}
+
+void
+profile_t::write_pprof (std::ostream &out,
+                        const symbolizer_t &symbolizer) const
+{
+  /* See https://github.com/google/pprof/blob/main/proto/profile.proto for
+     the meaning of the fields.  */
+  enum : uint32_t
+  {
+    profile_sample_type = 1,
+    profile_sample = 2,
+    profile_location = 4,
+    profile_function = 5,
+    profile_string_table = 6,
+    profile_time_nanos = 9,
+    profile_duration_nanos = 10,
+    profile_period_type = 11,
+    profile_period = 12,
+    profile_comment = 13,
+
+    value_type_type = 1,
+    value_type_unit = 2,
+
+    sample_location_id = 1,
+    sample_value = 2,
+
+    location_id = 1,
+    location_address = 3,
+    location_line = 4,
+
+    line_function_id = 1,
+    line_line = 2,
+
+    function_id = 1,
+    function_name = 2,
+    function_system_name = 3,
+    function_filename = 4,
+  };
+
+  message_t profile;
+
+  std::vector<std::string> strings;
+  std::map<std::string, uint64_t> string_ids;
+  auto string_id = [&] (const std::string &str) {
+    auto [it, inserted] = string_ids.try_emplace (str, strings.size ());
+    if (inserted)
+      strings.push_back (str);
+    return it->second;
+  };
+  /* The first string must be empty.  */
+  string_id ("");
+
+  auto value_type = [&] (const std::string &type, const std::string &unit) {
+    message_t message;
+    message.add_varint (value_type_type, string_id (type));
+    message.add_varint (value_type_unit, string_id (unit));
+    return message;
+  };
+
+  profile.add_message (profile_sample_type, value_type ("samples", "count"));
+  profile.add_message (profile_sample_type,
+                       value_type ("wave_time", "nanoseconds"));
+
+  std::map<std::pair<std::string, std::string>, uint64_t> function_ids;
+  auto function = [&] (const std::string &name,
+                       const std::optional<std::string> &file_name) {
+    auto [it, inserted] = function_ids.try_emplace (
+        { name, file_name.value_or ("") }, function_ids.size () + 1);
+    if (inserted)
+      {
+        message_t message;
+        message.add_varint (function_id, it->second);
+        message.add_varint (function_name, string_id (name));
+        message.add_varint (function_system_name, string_id (name));
+        if (file_name)
+          message.add_varint (function_filename, string_id (*file_name));
+        profile.add_message (profile_function, message);
+      }
+    return it->second;
+  };
+
+  /* A location is an address, and the function and line containing it if
+     they are known.  */
+  std::map<std::tuple<uint64_t, uint64_t, uint64_t>, uint64_t> location_ids;
+  auto location = [&] (uint64_t address, std::optional<uint64_t> function,
+                       uint64_t line) {
+    auto [it, inserted] = location_ids.try_emplace (
+        { address, function.value_or (0), line }, location_ids.size () + 1);
+    if (inserted)
+      {
+        message_t message;
+        message.add_varint (location_id, it->second);
+        message.add_varint (location_address, address);
+        if (function)
+          {
+            message_t line_message;
+            line_message.add_varint (line_function_id, *function);
+            if (line)
+              line_message.add_varint (line_line, line);
+            message.add_message (location_line, line_message);
+          }
+        profile.add_message (profile_location, message);
+      }
+    return it->second;
+  };
+
+  for (auto &&sample : symbolize (symbolizer))
+    {
+      const location_t &where = sample.m_location;
+
+      /* The leaf location first.  */
+      std::vector<uint64_t> locations;
+      std::optional<uint64_t> leaf_function;
+      if (where.m_function_name)
+        leaf_function = function (*where.m_function_name, where.m_file_name);
+      locations.push_back (location (sample.m_pc, leaf_function,
+                                     where.m_file_name ? where.m_line : 0));
+
+      if (where.m_kernel_name && where.m_kernel_name != where.m_function_name)
+        locations.push_back (
+            location (sample.m_kernel_entry,
+                      function (*where.m_kernel_name, std::nullopt), 0));
+
+      message_t message;
+      message.add_packed (sample_location_id, locations);
+      message.add_packed (sample_value,
+                          { sample.m_count,
+                            sample.m_count
+                                * static_cast<uint64_t> (m_period.count ()) });
+      profile.add_message (profile_sample, message);
+    }
+
+  profile.add_varint (
+      profile_time_nanos,
+      std::chrono::duration_cast<std::chrono::nanoseconds> (
+          m_start_time.time_since_epoch ())
+          .count ());
+  profile.add_varint (profile_duration_nanos,
+                      std::chrono::duration_cast<std::chrono::nanoseconds> (
+                          std::chrono::steady_clock::now () - m_start)
+                          .count ());
+  profile.add_message (profile_period_type,
+                       value_type ("wave_time", "nanoseconds"));
+  profile.add_varint (profile_period, m_period.count ());
+  profile.add_varint (
+      profile_comment,
+      string_id ("ROCdebug-agent wavefront pc sampling, "
+                 + std::to_string (m_tick_count) + " intervals"));
+
+  /* The string table is complete once everything else is encoded.  */
+  for (auto &&str : strings)
+    profile.add_bytes (profile_string_table, str);
+
+  out.write (profile.data ().data (), profile.data ().size ());
+}
+
+void
+profile_t::print_summary (std::ostream &out, const symbolizer_t &symbolizer,
+                          size_t max_entries) const
+{
+  scoped_format_t format (out);
+
+  using usec = std::chrono::duration<double, std::micro>;
+
+  out << "ROCdebug-agent profile: " << m_sample_count
+      << " wavefront samples in " << m_tick_count << " intervals of "
+      << usec (m_period).count () << " us" << '\n';
+  if (m_tick_count)
+    out << "  the waves were stopped for "
+        << usec (m_total_pause).count () / m_tick_count
+        << " us on average, " << usec (m_max_pause).count ()
+        << " us at most" << '\n';
+
+  if (!m_sample_count)
+    return;
+
+  std::map<std::string, uint64_t> functions, lines;
+  for (auto &&sample : symbolize (symbolizer))
+    {
+      auto frames = sample_frames (sample.m_kernel_entry, sample.m_pc,
+                                   sample.m_location);
+      functions[frames.size () > 2 ? frames[1] : frames[0]]
+          += sample.m_count;
+      lines[frames.back ()] += sample.m_count;
+    }
+
+  auto print_top = [&] (const char *title,
+                        const std::map<std::string, uint64_t> &counts) {
+    std::vector<std::pair<std::string, uint64_t>> sorted (counts.begin (),
+                                                          counts.end ());
+    std::stable_sort (sorted.begin (), sorted.end (),
+                      [] (auto &&lhs, auto &&rhs) {
+                        return lhs.second > rhs.second;
+                      });
+    if (sorted.size () > max_entries)
+      sorted.resize (max_entries);
+
+    out << "  " << title << ":" << '\n';
+    for (auto &&[name, count] : sorted)
+      out << "  " << std::setw (10) << count << std::fixed
+          << std::setprecision (1) << std::setw (7)
+          << 100.0 * count / m_sample_count << "%  " << name << '\n';
+  };
+
+  print_top ("functions", functions);
+  print_top ("source lines", lines);
+}
+
+} /* namespace amd::debug_agent */
@@ -0,0 +1,127 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_PROFILE_H
+#define _ROCM_DEBUG_AGENT_PROFILE_H 1
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* A statistical profile of the wavefronts.  The waves are stopped
+   periodically, and the kernel entry and pc of each wave are counted.  Only
+   these addresses are recorded while the waves are stopped, the samples are
+   symbolized when the profile is written.  */
+
+class profile_t
+{
+public:
+  /* The source location of a sampled pc.  */
+  struct location_t
+  {
+    std::optional<std::string> m_kernel_name;
+    std::optional<std::string> m_function_name;
+    std::optional<std::string> m_file_name;
+    uint64_t m_line{ 0 };
+  };
+
+  /* Return the location of PC, executed by a wave of the kernel at
+     KERNEL_ENTRY (or 0 if it is not known).  */
+  using symbolizer_t
+      = std::function<location_t (uint64_t kernel_entry, uint64_t pc)>;
+
+  explicit profile_t (std::chrono::nanoseconds period);
+
+  std::chrono::nanoseconds period () const { return m_period; }
+
+  /* Count a wave of the kernel at KERNEL_ENTRY found at PC.  */
+  void add_sample (uint64_t kernel_entry, uint64_t pc)
+  {
+    ++m_counts[{ kernel_entry, pc }];
+    ++m_sample_count;
+  }
+
+  /* Count a sampling interval, during which the waves were stopped for
+     PAUSE.  */
+  void add_tick (std::chrono::nanoseconds pause);
+
+  size_t sample_count () const { return m_sample_count; }
+
+  /* Write the profile in the folded stacks format, one line per kernel,
+     function and source line followed by its sample count, as used by flame
+     graph tools.  */
+  void write_folded (std::ostream &out, const symbolizer_t &symbolizer) const;
+
+  /* Write the profile in the pprof protocol buffer format (uncompressed).  */
+  void write_pprof (std::ostream &out, const symbolizer_t &symbolizer) const;
+
+  /* Print the number of samples of the most sampled functions and source
+     lines.  */
+  void print_summary (std::ostream &out, const symbolizer_t &symbolizer,
+                      size_t max_entries) const;
+
+private:
+  struct symbolized_sample_t
+  {
+    uint64_t m_kernel_entry;
+    uint64_t m_pc;
+    uint64_t m_count;
+    location_t m_location;
+  };
+
+  std::vector<symbolized_sample_t>
+  symbolize (const symbolizer_t &symbolizer) const;
+
+  std::chrono::nanoseconds m_period;
+  std::chrono::system_clock::time_point m_start_time;
+  std::chrono::steady_clock::time_point m_start;
+
+  /* The number of waves sampled at each kernel entry and pc.  */
+  std::map<std::pair<uint64_t, uint64_t>, uint64_t> m_counts;
+  size_t m_sample_count{ 0 };
+
+  size_t m_tick_count{ 0 };
+  std::chrono::nanoseconds m_total_pause{ 0 };
+  std::chrono::nanoseconds m_max_pause{ 0 };
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_PROFILE_H */
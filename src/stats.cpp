@@ -0,0 +1,244 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "stats.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+
+namespace amd::debug_agent::stats
+{
+
+bool detail::enabled{ false };
+
+namespace
+{
+
+/* A histogram of durations in buckets of increasing powers of 2
+   nanoseconds.  Bucket I counts the durations in [2^I, 2^(I+1)) ns.  */
+struct histogram_t
+{
+  static constexpr size_t bucket_count = 64;
+
+  std::atomic<uint64_t> m_buckets[bucket_count]{};
+  std::atomic<uint64_t> m_count{ 0 };
+  std::atomic<uint64_t> m_total_ns{ 0 };
+  std::atomic<uint64_t> m_max_ns{ 0 };
+
+  void record (uint64_t ns);
+
+  /* Return an estimate of the P quantile, in nanoseconds: the middle of the
+     bucket that contains it, or the maximum if it is smaller.  */
+  double quantile (double p) const;
+};
+
+void
+histogram_t::record (uint64_t ns)
+{
+  const size_t bucket = 63 - __builtin_clzll (ns | 1);
+  m_buckets[bucket].fetch_add (1, std::memory_order_relaxed);
+  m_count.fetch_add (1, std::memory_order_relaxed);
+  m_total_ns.fetch_add (ns, std::memory_order_relaxed);
+
+  uint64_t max_ns = m_max_ns.load (std::memory_order_relaxed);
+  while (max_ns < ns
+         && !m_max_ns.compare_exchange_weak (max_ns, ns,
+                                             std::memory_order_relaxed))
+    ;
+}
+
+double
+histogram_t::quantile (double p) const
+{
+  const uint64_t count = m_count.load (std::memory_order_relaxed);
+  const uint64_t rank = static_cast<uint64_t> (p * count);
+
+  uint64_t cumulative = 0;
+  for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+      cumulative += m_buckets[bucket].load (std::memory_order_relaxed);
+      if (cumulative > rank)
+        return std::min<double> (1.5 * (uint64_t{ 1 } << bucket),
+                                 m_max_ns.load (std::memory_order_relaxed));
+    }
+
+  return m_max_ns.load (std::memory_order_relaxed);
+}
+
+std::array<std::atomic<uint64_t>, static_cast<size_t> (counter_t::count)>
+    counters{};
+std::array<histogram_t, static_cast<size_t> (timer_t::count)> timers;
+
+const char *
+counter_name (counter_t counter)
+{
+  switch (counter)
+    {
+    case counter_t::freezes:
+      return "executable freezes";
+    case counter_t::destroys:
+      return "executable destroys";
+    case counter_t::code_object_reports:
+      return "code object list reports";
+    case counter_t::debug_traps:
+      return "debug traps resumed";
+    case counter_t::dumps:
+      return "dumps";
+    case counter_t::waves_dumped:
+      return "wavefronts dumped";
+    case counter_t::register_bytes:
+      return "register bytes read";
+    case counter_t::local_memory_bytes:
+      return "local memory bytes read";
+    case counter_t::dump_bytes:
+      return "dump bytes written";
+    case counter_t::memory_reads:
+      return "global memory reads";
+    case counter_t::memory_syscalls:
+      return "global memory syscalls";
+    case counter_t::memory_cached_reads:
+      return "global memory reads cached";
+    case counter_t::count:
+      break;
+    }
+  return "";
+}
+
+const char *
+timer_name (timer_t timer)
+{
+  switch (timer)
+    {
+    case timer_t::on_load:
+      return "OnLoad";
+    case timer_t::attach:
+      return "dbgapi attach";
+    case timer_t::freeze_hook:
+      return "executable freeze hook";
+    case timer_t::destroy_hook:
+      return "executable destroy hook";
+    case timer_t::dump:
+      return "dump";
+    case timer_t::code_objects:
+      return "  code object open";
+    case timer_t::stop_all_wavefronts:
+      return "  stop all wavefronts";
+    case timer_t::registers:
+      return "  register reads";
+    case timer_t::local_memory:
+      return "  local memory reads";
+    case timer_t::disassembly:
+      return "  disassembly";
+    case timer_t::output:
+      return "  output";
+    case timer_t::profile_sample:
+      return "profile sample";
+    case timer_t::count:
+      break;
+    }
+  return "";
+}
+
+} /* namespace */
+
+void
+enable ()
+{
+  detail::enabled = true;
+}
+
+void
+detail::add (counter_t counter, uint64_t value)
+{
+  counters[static_cast<size_t> (counter)].fetch_add (
+      value, std::memory_order_relaxed);
+}
+
+void
+detail::record (timer_t timer, std::chrono::nanoseconds duration)
+{
+  timers[static_cast<size_t> (timer)].record (
+      duration.count () > 0 ? duration.count () : 0);
+}
+
+uint64_t
+value (counter_t counter)
+{
+  return counters[static_cast<size_t> (counter)].load (
+      std::memory_order_relaxed);
+}
+
+void
+print (std::ostream &out)
+{
+  scoped_format_t format (out);
+
+  out << "ROCdebug-agent statistics:" << '\n';
+
+  for (size_t i = 0; i < counters.size (); ++i)
+    out << "  " << std::left << std::setw (30)
+        << counter_name (static_cast<counter_t> (i)) << std::right
+        << std::setw (12) << std::dec
+        << counters[i].load (std::memory_order_relaxed) << '\n';
+
+  out << '\n'
+      << "  " << std::left << std::setw (30) << "time (us)" << std::right
+      << std::setw (8) << "count" << std::setw (12) << "total"
+      << std::setw (9) << "p50" << std::setw (9) << "p99" << std::setw (9)
+      << "max" << '\n';
+
+  out << std::fixed << std::setprecision (1);
+  for (size_t i = 0; i < timers.size (); ++i)
+    {
+      const histogram_t &histogram = timers[i];
+      const uint64_t count
+          = histogram.m_count.load (std::memory_order_relaxed);
+
+      out << "  " << std::left << std::setw (30)
+          << timer_name (static_cast<timer_t> (i)) << std::right
+          << std::setw (8) << count;
+
+      if (count)
+        out << std::setw (12)
+            << histogram.m_total_ns.load (std::memory_order_relaxed) / 1e3
+            << std::setw (9) << histogram.quantile (0.5) / 1e3
+            << std::setw (9) << histogram.quantile (0.99) / 1e3
+            << std::setw (9)
+            << histogram.m_max_ns.load (std::memory_order_relaxed) / 1e3;
+
+      out << '\n';
+    }
+
+  out.flush ();
+}
+
+} /* namespace amd::debug_agent::stats */
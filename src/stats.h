@@ -0,0 +1,155 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_STATS_H
+#define _ROCM_DEBUG_AGENT_STATS_H 1
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace amd::debug_agent::stats
+{
+
+/* The self-profiling statistics of the agent.  They are kept in lock-free
+   counters and histograms, and are only collected if enabled (--stats).
+   When disabled, recording a statistic costs a predictable branch, and the
+   clock is not read.  */
+
+enum class counter_t : size_t
+{
+  freezes,
+  destroys,
+  code_object_reports,
+  debug_traps,
+  dumps,
+  waves_dumped,
+  register_bytes,
+  local_memory_bytes,
+  dump_bytes,
+  /* The global memory reads done by dbgapi, the syscalls done to serve them,
+     and the reads served from the memory cache without a syscall.  */
+  memory_reads,
+  memory_syscalls,
+  memory_cached_reads,
+  count
+};
+
+enum class timer_t : size_t
+{
+  /* The startup of the agent: OnLoad, and the attach of dbgapi by the
+     worker thread, until it waits for events.  */
+  on_load,
+  attach,
+  /* The time spent by the agent in the HSA executable hooks.  */
+  freeze_hook,
+  destroy_hook,
+  /* The phases of a dump.  */
+  dump,
+  code_objects,
+  stop_all_wavefronts,
+  registers,
+  local_memory,
+  disassembly,
+  output,
+  /* The time the waves are stopped to sample their pc (--profile).  */
+  profile_sample,
+  count
+};
+
+namespace detail
+{
+
+extern bool enabled;
+
+void add (counter_t counter, uint64_t value);
+void record (timer_t timer, std::chrono::nanoseconds duration);
+
+} /* namespace detail */
+
+/* Start collecting statistics.  This must be called before the agent's
+   threads and hooks are started.  */
+void enable ();
+
+inline bool
+enabled ()
+{
+  return detail::enabled;
+}
+
+inline void
+add (counter_t counter, uint64_t value = 1)
+{
+  if (enabled ())
+    detail::add (counter, value);
+}
+
+inline void
+record (timer_t timer, std::chrono::nanoseconds duration)
+{
+  if (enabled ())
+    detail::record (timer, duration);
+}
+
+/* Record the time spent in a scope.  */
+class scoped_timer_t
+{
+public:
+  explicit scoped_timer_t (timer_t timer) : m_timer (timer)
+  {
+    if (enabled ())
+      m_start = std::chrono::steady_clock::now ();
+  }
+
+  ~scoped_timer_t ()
+  {
+    if (enabled ())
+      detail::record (m_timer, std::chrono::steady_clock::now () - m_start);
+  }
+
+  scoped_timer_t (const scoped_timer_t &) = delete;
+  scoped_timer_t &operator= (const scoped_timer_t &) = delete;
+
+private:
+  timer_t m_timer;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/* Return the current value of COUNTER.  */
+uint64_t value (counter_t counter);
+
+/* Print the statistics to OUT.  */
+void print (std::ostream &out);
+
+} /* namespace amd::debug_agent::stats */
+
+#endif /* _ROCM_DEBUG_AGENT_STATS_H */
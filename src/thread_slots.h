@@ -0,0 +1,119 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+#ifndef _ROCM_DEBUG_AGENT_THREAD_SLOTS_H
+#define _ROCM_DEBUG_AGENT_THREAD_SLOTS_H 1
+
+#include <atomic>
+
+namespace amd::debug_agent
+{
+
+/* A registry of per-thread slots, which the threads acquire without taking
+   any lock.  The slot of a thread is released when the thread exits, and
+   reused by the next thread that acquires one.  SLOT must have a
+   std::atomic<bool> m_owned initialized to true, and a SLOT *m_next.
+
+   The slots are never freed: the registries live until the process exits,
+   and a thread that is still running may use its slot until then.  */
+
+template <typename Slot> class thread_slots_t
+{
+public:
+  thread_slots_t () = default;
+
+  thread_slots_t (const thread_slots_t &) = delete;
+  thread_slots_t &operator= (const thread_slots_t &) = delete;
+
+  /* Return the slot the calling thread acquired in this registry, or
+     nullptr if it did not acquire one.  */
+  Slot *thread_slot () const
+  {
+    return s_owner.m_slots == this ? s_owner.m_slot : nullptr;
+  }
+
+  /* Acquire a slot for the calling thread, releasing the slot it acquired
+     in another registry.  Reuse the slot of a thread that exited if there
+     is one, else add the slot returned by MAKE.  */
+  template <typename Make> Slot *acquire (Make &&make)
+  {
+    if (s_owner.m_slot)
+      s_owner.m_slot->m_owned.store (false, std::memory_order_release);
+
+    Slot *slot = nullptr;
+    for (Slot *it = first (); it; it = it->m_next)
+      {
+        bool owned = false;
+        if (it->m_owned.compare_exchange_strong (owned, true,
+                                                 std::memory_order_acquire))
+          {
+            slot = it;
+            break;
+          }
+      }
+
+    if (!slot)
+      {
+        slot = make ();
+        slot->m_next = m_head.load (std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak (slot->m_next, slot,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed))
+          ;
+      }
+
+    s_owner.m_slots = this;
+    s_owner.m_slot = slot;
+    return slot;
+  }
+
+  /* The slots of all the threads, owned or not, linked by m_next.  */
+  Slot *first () const { return m_head.load (std::memory_order_acquire); }
+
+private:
+  /* The slot of the calling thread, released when the thread exits.  */
+  struct owner_t
+  {
+    ~owner_t ()
+    {
+      if (m_slot)
+        m_slot->m_owned.store (false, std::memory_order_release);
+    }
+
+    const thread_slots_t *m_slots{ nullptr };
+    Slot *m_slot{ nullptr };
+  };
+  static inline thread_local owner_t s_owner;
+
+  std::atomic<Slot *> m_head{ nullptr };
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_THREAD_SLOTS_H */
@@ -0,0 +1,171 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#include "wave_filter.h"
+#include "dump.h"
+
+#include <fnmatch.h>
+#include <strings.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+namespace amd::debug_agent
+{
+
+namespace
+{
+
+/* Parse IDS, a comma separated list of unsigned numbers, into SET.  Return
+   false if IDS is not a valid list.  */
+
+bool
+parse_id_list (const std::string &ids, std::unordered_set<uint64_t> &set)
+{
+  std::istringstream stream (ids);
+  std::string id;
+
+  while (std::getline (stream, id, ','))
+    {
+      if (id.empty () || !isdigit (id[0]))
+        return false;
+
+      char *end;
+      errno = 0;
+      uint64_t value = strtoull (id.c_str (), &end, 0);
+      if (errno || *end != '\0')
+        return false;
+
+      set.emplace (value);
+    }
+
+  return !set.empty ();
+}
+
+} /* namespace */
+
+bool
+wave_filter_t::set_stop_reasons (const std::string &names)
+{
+  std::istringstream stream (names);
+  std::string name;
+  uint64_t mask = 0;
+
+  /* std::getline does not return the empty name after a trailing comma.  */
+  if (!names.empty () && names.back () == ',')
+    return false;
+
+  while (std::getline (stream, name, ','))
+    {
+      if (name.empty ())
+        return false;
+
+      /* stop_reason_name returns an empty name for the bits that are not
+         defined, only compare the names of the defined bits.  */
+      uint64_t bit = 0;
+      for (size_t i = 0; i < 64; ++i)
+        {
+          const char *bit_name = stop_reason_name (uint64_t{ 1 } << i);
+          if (*bit_name && !strcasecmp (name.c_str (), bit_name))
+            {
+              bit = uint64_t{ 1 } << i;
+              break;
+            }
+        }
+
+      if (!bit)
+        return false;
+
+      mask |= bit;
+    }
+
+  if (!mask)
+    return false;
+
+  m_stop_reasons.emplace (mask);
+  return true;
+}
+
+bool
+wave_filter_t::set_agents (const std::string &ids)
+{
+  return parse_id_list (ids, m_agents);
+}
+
+bool
+wave_filter_t::set_dispatches (const std::string &ids)
+{
+  return parse_id_list (ids, m_dispatches);
+}
+
+void
+wave_filter_t::add_kernel_pattern (const std::string &pattern)
+{
+  m_kernel_patterns.emplace_back (pattern);
+}
+
+bool
+wave_filter_t::match_stop_reason (uint64_t stop_reason) const
+{
+  return !m_stop_reasons || (stop_reason & *m_stop_reasons) != 0;
+}
+
+bool
+wave_filter_t::match_agent (uint64_t os_agent_id) const
+{
+  return m_agents.empty () || m_agents.count (os_agent_id);
+}
+
+bool
+wave_filter_t::match_dispatch (std::optional<uint64_t> dispatch_id) const
+{
+  return m_dispatches.empty ()
+         || (dispatch_id && m_dispatches.count (*dispatch_id));
+}
+
+bool
+wave_filter_t::match_kernel_name (const std::optional<std::string> &name) const
+{
+  if (m_kernel_patterns.empty ())
+    return true;
+
+  if (!name)
+    return false;
+
+  for (auto &&pattern : m_kernel_patterns)
+    if (!fnmatch (pattern.c_str (), name->c_str (), 0))
+      return true;
+
+  return false;
+}
+
+} /* namespace amd::debug_agent */
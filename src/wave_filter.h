@@ -0,0 +1,98 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+#ifndef _ROCM_DEBUG_AGENT_WAVE_FILTER_H
+#define _ROCM_DEBUG_AGENT_WAVE_FILTER_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace amd::debug_agent
+{
+
+/* Select the wavefronts included in a dump.  Each criterion is checked by a
+   separate function so that the caller can test the criteria in the order
+   of the cost of the information they need, and skip a wavefront before
+   anything expensive is read from it.  A criterion that was not set matches
+   every wavefront.  */
+
+class wave_filter_t
+{
+public:
+  /* Only match the waves stopped for one of the reasons in NAMES, a comma
+     separated list of stop reason names (e.g. "memory_violation,trap").
+     Return false if NAMES contains an unknown or empty stop reason.  */
+  bool set_stop_reasons (const std::string &names);
+
+  /* Only match the waves running on one of the agents in IDS, a comma
+     separated list of operating system agent ids (the KFD gpu_id).  Return
+     false if IDS is not a valid list.  */
+  bool set_agents (const std::string &ids);
+
+  /* Only match the waves created by one of the dispatches in IDS, a comma
+     separated list of dbgapi dispatch ids.  Return false if IDS is not a
+     valid list.  */
+  bool set_dispatches (const std::string &ids);
+
+  /* Only match the waves executing a kernel whose name matches one of the
+     added shell wildcard patterns.  */
+  void add_kernel_pattern (const std::string &pattern);
+
+  /* Do not include more than COUNT waves in a dump.  */
+  void set_max_waves (size_t count) { m_max_waves.emplace (count); }
+
+  bool match_stop_reason (uint64_t stop_reason) const;
+  bool match_agent (uint64_t os_agent_id) const;
+  bool match_dispatch (std::optional<uint64_t> dispatch_id) const;
+  bool match_kernel_name (const std::optional<std::string> &name) const;
+
+  bool filters_agents () const { return !m_agents.empty (); }
+  bool filters_dispatches () const { return !m_dispatches.empty (); }
+  bool filters_kernel_names () const { return !m_kernel_patterns.empty (); }
+
+  std::optional<size_t> max_waves () const { return m_max_waves; }
+
+private:
+  /* A mask of amd_dbgapi_wave_stop_reasons_t bits, or an empty optional if
+     waves are not filtered by stop reason.  */
+  std::optional<uint64_t> m_stop_reasons;
+  std::unordered_set<uint64_t> m_agents;
+  std::unordered_set<uint64_t> m_dispatches;
+  std::vector<std::string> m_kernel_patterns;
+  std::optional<size_t> m_max_waves;
+};
+
+} /* namespace amd::debug_agent */
+
+#endif /* _ROCM_DEBUG_AGENT_WAVE_FILTER_H */
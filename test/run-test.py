@@ -1,6 +1,8 @@
 import os
 import re
 import sys
+import json
+import shutil
 import inspect
 from subprocess import Popen, PIPE
 
@@ -97,6 +99,139 @@ def check_test_1():
 
     return all_output_string_found
 
+# test 1, with a binary dump rendered by rocm-debug-agent-print
+def check_test_1_binary():
+    print("Starting rocm-debug-agent test 1 with a binary dump")
+
+    # The HSA_STATUS_ERROR_EXCEPTION message is printed by the runtime, it is
+    # not part of the dump.
+    check_list = ['\(stopped, reason: ASSERT_TRAP\)',
+                  'exec: (00000000)?00000001',
+                  's0:',
+                  'v0:',
+                  '0x0000: 22222222 11111111', # First uint64_t in LDS is '1111111122222222'
+                  'Disassembly for function vector_add_assert_trap\(int\*, int\*, int\*\)'
+                  ]
+
+    # rocm-debug-agent-print is built next to the agent library, and
+    # installed in the PATH with it.
+    print_tool = agent_library_directory + "/rocm-debug-agent-print"
+    if not os.access(print_tool, os.X_OK):
+        print_tool = shutil.which("rocm-debug-agent-print")
+    if not print_tool:
+        print("rocm-debug-agent-print Not Found.")
+        return False
+
+    dump_file = os.path.abspath("rocm-debug-agent-test-1.bin")
+    env = dict(os.environ)
+    env["ROCM_DEBUG_AGENT_OPTIONS"] = "-p --format=binary --output=" + dump_file
+    p = Popen(['./rocm-debug-agent-test', '1'], stdout=PIPE, stderr=PIPE, env=env)
+    output, err = p.communicate()
+    out_str = output.decode('utf-8')
+    err_str = err.decode('utf-8')
+
+    p = Popen([print_tool, dump_file], stdout=PIPE, stderr=PIPE)
+    output, err = p.communicate()
+    dump_str = output.decode('utf-8')
+    print_err_str = err.decode('utf-8')
+    if os.path.exists(dump_file):
+        os.remove(dump_file)
+
+    # check output string
+    all_output_string_found = p.returncode == 0
+    if (not all_output_string_found):
+        print ("rocm-debug-agent-print failed: ", print_err_str)
+
+    for check_str in check_list:
+        pattern = re.compile(check_str)
+        if (not (pattern.search(dump_str))):
+            all_output_string_found = False
+            print ("\"", check_str, "\" Not Found in dump.")
+
+    if (not all_output_string_found):
+        print("rocm-debug-agent test print out.")
+        print(out_str)
+        print("rocm-debug-agent test error message.")
+        print(err_str)
+        print("rocm-debug-agent-print print out.")
+        print(dump_str)
+
+    return all_output_string_found
+
+# test 1, with a json dump
+def check_test_1_json():
+    print("Starting rocm-debug-agent test 1 with a json dump")
+
+    dump_file = os.path.abspath("rocm-debug-agent-test-1.json")
+    env = dict(os.environ)
+    env["ROCM_DEBUG_AGENT_OPTIONS"] = "-p --format=json --output=" + dump_file
+    p = Popen(['./rocm-debug-agent-test', '1'], stdout=PIPE, stderr=PIPE, env=env)
+    output, err = p.communicate()
+    out_str = output.decode('utf-8')
+    err_str = err.decode('utf-8')
+
+    dump_str = ""
+    if os.path.exists(dump_file):
+        with open(dump_file) as f:
+            dump_str = f.read()
+        os.remove(dump_file)
+
+    # Every line is a record.  The registers and local memory of a wave are
+    # either folded into its wave record, or in records of their own.
+    all_output_string_found = True
+    waves = {}
+    disassemblies = []
+    for line in dump_str.splitlines():
+        try:
+            record = json.loads(line)
+        except ValueError:
+            all_output_string_found = False
+            print ("\"", line, "\" is not a JSON object.")
+            continue
+        if record["type"] in ("wave", "registers", "local_memory"):
+            waves.setdefault((record["dump"], record["wave"]), {}).update(record)
+        elif record["type"] == "disassembly":
+            disassemblies.append(record)
+
+    wave = next((w for w in waves.values()
+                 if "ASSERT_TRAP" in w.get("stop_reason", [])), None)
+    if wave is None:
+        all_output_string_found = False
+        print ("No wave stopped by ASSERT_TRAP in dump.")
+    else:
+        registers = {}
+        for register_class in wave.get("registers", {}).values():
+            registers.update(register_class)
+
+        checks = [
+            ('exec: (00000000)?00000001',
+             re.fullmatch('(00000000)?00000001', registers.get("exec", ""))),
+            ('s0', "s0" in registers),
+            ('v0', "v0" in registers),
+            # First uint64_t in LDS is '1111111122222222'
+            ('local_memory: 2222222211111111',
+             wave.get("local_memory", {}).get("contents", "")
+                 .startswith("2222222211111111")),
+            ('disassembly of vector_add_assert_trap(int*, int*, int*)',
+             any(d["wave"] == wave["wave"]
+                 and d.get("function") == "vector_add_assert_trap(int*, int*, int*)"
+                 for d in disassemblies))
+        ]
+        for check_str, found in checks:
+            if not found:
+                all_output_string_found = False
+                print ("\"", check_str, "\" Not Found in dump.")
+
+    if (not all_output_string_found):
+        print("rocm-debug-agent test print out.")
+        print(out_str)
+        print("rocm-debug-agent test error message.")
+        print(err_str)
+        print("rocm-debug-agent test json dump.")
+        print(dump_str)
+
+    return all_output_string_found
+
 # test 2
 def check_test_2():
     print("Starting rocm-debug-agent test 2")
@@ -141,6 +276,8 @@ def check_test_2():
 test_success = True
 test_success &= check_test_0()
 test_success &= check_test_1()
+test_success &= check_test_1_binary()
+test_success &= check_test_1_json()
 test_success &= check_test_2()
 if (test_success):
     print("rocm-debug-agent test Pass!")
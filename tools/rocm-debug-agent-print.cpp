@@ -0,0 +1,80 @@
+/* The University of Illinois/NCSA
+   Open Source License (NCSA)
+
+   Copyright (c) 2026, Advanced Micro Devices, Inc. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal with the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+    - Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimers.
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimers in
+      the documentation and/or other materials provided with the distribution.
+    - Neither the names of Advanced Micro Devices, Inc,
+      nor the names of its contributors may be used to endorse or promote
+      products derived from this Software without specific prior written
+      permission.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+   OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+   ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS WITH THE SOFTWARE.  */
+
+/* Render a binary wavefront dump, produced with
+   ROCM_DEBUG_AGENT_OPTIONS="--format=binary --output=FILE", into the same
+   text the debug agent prints by default.  */
+
+#include "dump.h"
+#include "logging.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace amd::debug_agent;
+
+int
+main (int argc, char *argv[])
+{
+  if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1] != '\0'))
+    {
+      std::cerr << "usage: " << argv[0] << " [FILE]" << std::endl
+                << "Print the binary wavefront dump FILE (or the standard "
+                   "input if FILE is"
+                << std::endl
+                << "omitted or is '-') as text." << std::endl;
+      return 2;
+    }
+
+  std::ifstream file;
+  if (argc == 2 && std::string (argv[1]) != "-")
+    {
+      file.open (argv[1], std::ios::in | std::ios::binary);
+      if (!file.is_open ())
+        {
+          std::cerr << "could not open `" << argv[1] << "'" << std::endl;
+          return 1;
+        }
+    }
+
+  std::istream &in = file.is_open () ? file : std::cin;
+  auto writer = make_dump_writer (output_format_t::text, std::cout);
+
+  if (!read_binary_dump (in, *writer))
+    {
+      std::cout.flush ();
+      std::cerr << "error: not a valid rocm-debug-agent binary dump"
+                << std::endl;
+      return 1;
+    }
+
+  return 0;
+}